@@ -7,8 +7,10 @@ AudioCapture::AudioCapture(int sampleRate, int framesPerBuffer, int numChannels)
     sampleRate_(sampleRate),
     framesPerBuffer_(framesPerBuffer),
     numChannels_(numChannels),
-    audioBuffer_(framesPerBuffer* numChannels),
-    bufferReady_(false)
+    ring_(static_cast<size_t>(framesPerBuffer) * numChannels * CAPTURE_RING_PERIODS),
+    overflowCount_(0),
+    inputOverflowCount_(0),
+    reportedOverflows_(0)
 {
 
 
@@ -87,10 +89,38 @@ void AudioCapture::stop() {
 }
 
 std::vector<float> AudioCapture::readBlocking() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    condVar_.wait(lock, [this] { return bufferReady_; }); // Wait until new buffer is ready
-    bufferReady_ = false; // Reset flag
-    return audioBuffer_; // Return a copy (could optimize with move semantics or shared_ptr)
+    std::vector<float> buffer;
+    if (!readBlocking(buffer)) {
+        return {};
+    }
+    return buffer;
+}
+
+bool AudioCapture::readBlocking(std::vector<float>& buffer) {
+    const size_t samples = static_cast<size_t>(framesPerBuffer_) * numChannels_;
+    buffer.resize(samples);
+
+    // The callback notifies without holding mutex_, so a wakeup can slip in
+    // between the check and the wait; the timeout of one period bounds that.
+    const auto period = std::chrono::microseconds(1000000LL * framesPerBuffer_ / std::max(sampleRate_, 1));
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (ring_.readAvailable() < samples) {
+            if (!stream) {
+                return false;
+            }
+            condVar_.wait_for(lock, period);
+        }
+    }
+    ring_.read(buffer.data(), samples);
+
+    uint64_t overflows = overflowCount_.load(std::memory_order_relaxed);
+    if (overflows != reportedOverflows_) {
+        std::cerr << "Warning: Capture ring full, dropped " << (overflows - reportedOverflows_)
+            << " period(s) (" << overflows << " total)\n";
+        reportedOverflows_ = overflows;
+    }
+    return true;
 }
 
 int AudioCapture::paCallback(const void* inputBuffer, void* outputBuffer,
@@ -101,16 +131,24 @@ int AudioCapture::paCallback(const void* inputBuffer, void* outputBuffer,
     AudioCapture* This = static_cast<AudioCapture*>(userData);
     const float* in = static_cast<const float*>(inputBuffer);
 
+    if (statusFlags & paInputOverflow) {
+        This->inputOverflowCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+
     if (inputBuffer == nullptr) {
         // No input, fill with silence or handle error
         return paContinue;
     }
 
-    std::lock_guard<std::mutex> lock(This->mutex_);
-    // Copy input buffer to our internal buffer
-    std::copy(in, in + (framesPerBuffer * This->numChannels_), This->audioBuffer_.begin());
-    This->bufferReady_ = true;
-    This->condVar_.notify_one(); // Notify thread that buffer is ready
+    // Real-time thread: no locks, no allocation. A period either fits in the
+    // ring as a whole or is dropped and counted, never partially written.
+    const size_t samples = framesPerBuffer * This->numChannels_;
+    if (This->ring_.writeAvailable() < samples) {
+        This->overflowCount_.fetch_add(1, std::memory_order_relaxed);
+        return paContinue;
+    }
+    This->ring_.write(in, samples);
+    This->condVar_.notify_one(); // Wake the reader; no lock taken here
 
     return paContinue;
 }
\ No newline at end of file
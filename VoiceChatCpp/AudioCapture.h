@@ -7,7 +7,11 @@
 #include <stdexcept>
 #include <mutex>
 #include <condition_variable>
-#include <algorithm> // For std::copy
+#include <atomic>
+#include <chrono>
+#include <algorithm> // For std::max
+#include <cstdint>
+#include "SpscRingBuffer.h"
 
 class AudioCapture {
 public:
@@ -17,6 +21,12 @@ public:
     bool start();
     void stop();
     std::vector<float> readBlocking(); // Read a buffer of audio
+    bool readBlocking(std::vector<float>& buffer); // Same, but reuses the caller's buffer
+
+    // Device periods dropped because the encoder thread fell behind and the ring was full.
+    uint64_t overflowCount() const { return overflowCount_.load(std::memory_order_relaxed); }
+    // Periods PortAudio itself reported as overflowed (paInputOverflow).
+    uint64_t inputOverflowCount() const { return inputOverflowCount_.load(std::memory_order_relaxed); }
 
 private:
     static int paCallback(const void* inputBuffer, void* outputBuffer,
@@ -29,8 +39,16 @@ private:
     int sampleRate_;
     int framesPerBuffer_;
     int numChannels_;
-    std::vector<float> audioBuffer_; // Buffer to store captured audio
-    bool bufferReady_;
+
+    // Captured periods are handed to readBlocking() through a lock-free ring that
+    // holds CAPTURE_RING_PERIODS periods, so the callback never waits on the reader.
+    static const int CAPTURE_RING_PERIODS = 8;
+    SpscRingBuffer<float> ring_;
+    std::atomic<uint64_t> overflowCount_;
+    std::atomic<uint64_t> inputOverflowCount_;
+    uint64_t reportedOverflows_; // Reader-side copy, for logging only
+
+    // Only used by the reader to sleep; the callback just notifies without locking.
     std::mutex mutex_;
     std::condition_variable condVar_;
 };
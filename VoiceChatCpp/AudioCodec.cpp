@@ -1,27 +1,62 @@
 #include "AudioCodec.h"
+#include <utility> // For std::swap
+#include <cstring>
+#include <algorithm>
 
-OpusEncoder* AudioCodec::encoder = nullptr;
-OpusDecoder* AudioCodec::decoder = nullptr;
-int AudioCodec::numChannels_ = 0;
-int AudioCodec::sampleRate_ = 0;
+namespace {
 
-bool AudioCodec::initializeEncoder(int sampleRate, int channels, int bitrate) {
+// Opus's audio bandwidths by the highest frequency they keep.
+struct Bandwidth {
+    int hz;
+    int opusBandwidth;
+    int sampleRate; // The lowest Opus rate that carries it
+};
+
+const Bandwidth BANDWIDTHS[] = {
+    { 4000, OPUS_BANDWIDTH_NARROWBAND, 8000 },
+    { 6000, OPUS_BANDWIDTH_MEDIUMBAND, 12000 },
+    { 8000, OPUS_BANDWIDTH_WIDEBAND, 16000 },
+    { 12000, OPUS_BANDWIDTH_SUPERWIDEBAND, 24000 },
+    { 20000, OPUS_BANDWIDTH_FULLBAND, 48000 },
+};
+
+const Bandwidth* findBandwidth(int hz) {
+    for (const Bandwidth& bandwidth : BANDWIDTHS) {
+        if (bandwidth.hz == hz) return &bandwidth;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+AudioEncoder::AudioEncoder()
+    : encoder_(nullptr), sampleRate_(0), numChannels_(0)
+{
+}
+
+AudioEncoder::AudioEncoder(int sampleRate, int channels, int bitrate, int bandwidthHz)
+    : encoder_(nullptr), sampleRate_(sampleRate), numChannels_(channels)
+{
+    const Bandwidth* bandwidth = findBandwidth(bandwidthHz);
+    if (!bandwidth) {
+        throw std::runtime_error("Opus can't limit audio to " + std::to_string(bandwidthHz) + " Hz");
+    }
     int error;
-    encoder = opus_encoder_create(sampleRate, channels, OPUS_APPLICATION_VOIP, &error);
+    encoder_ = opus_encoder_create(sampleRate, channels, OPUS_APPLICATION_VOIP, &error);
     if (error != OPUS_OK) {
-        std::cerr << "Failed to create Opus encoder: " << opus_strerror(error) << std::endl;
-        return false;
+        throw std::runtime_error("Failed to create Opus encoder: " + std::string(opus_strerror(error)));
     }
-    std::cout << "[Opus Encoder] "<< channels << " sampleRate = " << sampleRate << " channels = " << channels << std::endl;
+    std::cout << "[Opus Encoder] sampleRate = " << sampleRate << " channels = " << channels << std::endl;
 
-    opus_encoder_ctl(encoder, OPUS_SET_BITRATE(bitrate));
-    opus_encoder_ctl(encoder, OPUS_SET_VBR(0)); // Disable VBR for more consistent latency
-    opus_encoder_ctl(encoder, OPUS_SET_COMPLEXITY(1)); // Lowest complexity for speed
-    opus_encoder_ctl(encoder, OPUS_SET_LSB_DEPTH(16)); // Use 16-bit depth
-    opus_encoder_ctl(encoder, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
-    //opus_encoder_ctl(encoder, OPUS_SET_EXPERT_FRAME_DURATION(OPUS_FRAMESIZE_10_MS));
-    opus_encoder_ctl(encoder, OPUS_SET_PACKET_LOSS_PERC(10));
-    opus_encoder_ctl(encoder, OPUS_SET_BANDWIDTH(OPUS_BANDWIDTH_NARROWBAND));  // 4 kHz
+    opus_encoder_ctl(encoder_, OPUS_SET_BITRATE(bitrate));
+    opus_encoder_ctl(encoder_, OPUS_SET_VBR(0)); // Disable VBR for more consistent latency
+    opus_encoder_ctl(encoder_, OPUS_SET_COMPLEXITY(1)); // Lowest complexity for speed
+    opus_encoder_ctl(encoder_, OPUS_SET_LSB_DEPTH(16)); // Use 16-bit depth
+    opus_encoder_ctl(encoder_, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+    //opus_encoder_ctl(encoder_, OPUS_SET_EXPERT_FRAME_DURATION(OPUS_FRAMESIZE_10_MS));
+    opus_encoder_ctl(encoder_, OPUS_SET_PACKET_LOSS_PERC(10));
+    opus_encoder_ctl(encoder_, OPUS_SET_INBAND_FEC(1)); // Spend that loss budget on LBRR copies of the previous frame
+    opus_encoder_ctl(encoder_, OPUS_SET_BANDWIDTH(bandwidth->opusBandwidth));
 
 
 
@@ -31,48 +66,52 @@ bool AudioCodec::initializeEncoder(int sampleRate, int channels, int bitrate) {
     // If you set FRAMES_PER_BUFFER to 480 (10ms) in main.cpp, that's what you encode.
     // Opus will handle the internal frame sizes (2.5ms, 5ms, 10ms, 20ms, 40ms, 60ms) automatically
     // based on the input frame size, but providing a small input frame size helps.
-
-    numChannels_ = channels;
-    sampleRate_ = sampleRate;
-    return true;
 }
 
-bool AudioCodec::initializeDecoder(int sampleRate, int channels) {
-    int error;
-    decoder = opus_decoder_create(sampleRate, channels, &error);
-    if (error != OPUS_OK) {
-        std::cerr << "Failed to create Opus decoder: " << opus_strerror(error) << std::endl;
-        return false;
+AudioEncoder::~AudioEncoder() {
+    if (encoder_) {
+        opus_encoder_destroy(encoder_);
     }
-    numChannels_ = channels;
-    sampleRate_ = sampleRate;
-    return true;
 }
 
-std::vector<unsigned char> AudioCodec::encode(const std::vector<float>& pcmData) {
-    if (!encoder) {
+AudioEncoder::AudioEncoder(AudioEncoder&& other) noexcept
+    : encoder_(other.encoder_), sampleRate_(other.sampleRate_), numChannels_(other.numChannels_)
+{
+    other.encoder_ = nullptr;
+}
+
+AudioEncoder& AudioEncoder::operator=(AudioEncoder&& other) noexcept {
+    std::swap(encoder_, other.encoder_);
+    std::swap(sampleRate_, other.sampleRate_);
+    std::swap(numChannels_, other.numChannels_);
+    return *this;
+}
+
+int AudioEncoder::encodeInto(const float* pcm, int frameSize, unsigned char* packet, int maxPacketSize) {
+    if (!encoder_) {
         std::cerr << "Encoder not initialized.\n";
-        return {};
+        return -1;
     }
 
-    // opus_encode expects int16_t (short), so convert float to int16_t
-    std::vector<opus_int16> pcm_int16(pcmData.size());
-    for (size_t i = 0; i < pcmData.size(); ++i) {
-        pcm_int16[i] = static_cast<opus_int16>(pcmData[i] * 32767.0f); // Scale float to int16_t range
+    // Opus takes float input natively, so the samples go in as they came from
+    // PortAudio, with no int16 round trip and no temporary buffer.
+    opus_int32 len = opus_encode_float(encoder_, pcm, frameSize, packet, (opus_int32)maxPacketSize);
+
+    if (len < 0) {
+        std::cerr << "Opus encoding failed: " << opus_strerror(len) << std::endl;
+        return -1;
     }
+    return len;
+}
 
-    const int MAX_PACKET_SIZE = 4000; // Max size for an Opus packet (reasonable for speech)
+std::vector<unsigned char> AudioEncoder::encode(const std::vector<float>& pcmData) {
     std::vector<unsigned char> encodedData(MAX_PACKET_SIZE);
 
     // Number of samples per channel in the input pcmData
-    int frame_size = static_cast<int>(pcm_int16.size() / numChannels_);
-
-    //std::cout << "Fframe_size:\n  " << frame_size << std::endl;
-
-    opus_int32 len = opus_encode(encoder, pcm_int16.data(), frame_size, encodedData.data(), (opus_int32)MAX_PACKET_SIZE);
+    int frame_size = static_cast<int>(pcmData.size() / numChannels_);
 
+    int len = encodeInto(pcmData.data(), frame_size, encodedData.data(), MAX_PACKET_SIZE);
     if (len < 0) {
-        std::cerr << "Opus encoding failed: " << opus_strerror(len) << std::endl;
         return {};
     }
 
@@ -80,46 +119,231 @@ std::vector<unsigned char> AudioCodec::encode(const std::vector<float>& pcmData)
     return encodedData;
 }
 
-std::vector<float> AudioCodec::decode(const std::vector<unsigned char>& encodedData) {
-    if (!decoder) {
-        std::cerr << "Decoder not initialized.\n";
-        return {};
+bool AudioEncoder::setDredDuration(int durationMs) {
+    if (!encoder_) {
+        return false;
+    }
+    int frames = (std::max(durationMs, 0) + 9) / 10; // The ctl counts 10 ms frames
+    int error = opus_encoder_ctl(encoder_, OPUS_SET_DRED_DURATION(frames));
+    if (error != OPUS_OK) {
+        std::cerr << "Opus DRED not available: " << opus_strerror(error) << std::endl;
+        return false;
+    }
+    if (frames > 0) {
+        // DRED is carried in the bits VBR leaves over (a CBR SILK frame has no room
+        // for it), and libopus only computes the voice activity it is driven by
+        // from complexity 7 up. So opting in trades the fixed-size packets and the
+        // lowest-CPU setting above for burst-loss resilience.
+        opus_encoder_ctl(encoder_, OPUS_SET_VBR(1));
+        opus_encoder_ctl(encoder_, OPUS_SET_VBR_CONSTRAINT(1));
+        opus_encoder_ctl(encoder_, OPUS_SET_COMPLEXITY(7));
+    }
+    return true;
+}
+
+void AudioEncoder::setDtx(bool enabled) {
+    if (encoder_) {
+        opus_encoder_ctl(encoder_, OPUS_SET_DTX(enabled ? 1 : 0));
+    }
+}
+
+int AudioEncoder::sampleRateForBandwidth(int bandwidthHz) {
+    const Bandwidth* bandwidth = findBandwidth(bandwidthHz);
+    return bandwidth ? bandwidth->sampleRate : -1;
+}
+
+int AudioEncoder::frameSizeFor(int sampleRate, double frameMs) {
+    // Legal durations are 1, 2, 4, 8, 16 or 24 times 2.5 ms.
+    const int quarterUnits = static_cast<int>(frameMs * 400.0 / 1000.0 + 0.5);
+    if (quarterUnits * 1000.0 / 400.0 != frameMs || sampleRate % 400 != 0) {
+        return -1;
+    }
+    switch (quarterUnits) {
+    case 1: case 2: case 4: case 8: case 16: case 24:
+        return quarterUnits * (sampleRate / 400);
+    default:
+        return -1;
     }
+}
 
+AudioDecoder::AudioDecoder()
+    : decoder_(nullptr), sampleRate_(0), numChannels_(0), concealedCount_(0), recoveredCount_(0),
+    dredDecoder_(nullptr), dred_(nullptr), maxDredSamples_(0), dredAvailable_(0), dredProcessed_(false), dredCount_(0)
+{
+}
+
+AudioDecoder::AudioDecoder(int sampleRate, int channels)
+    : decoder_(nullptr), sampleRate_(sampleRate), numChannels_(channels), concealedCount_(0), recoveredCount_(0),
+    dredDecoder_(nullptr), dred_(nullptr), maxDredSamples_(0), dredAvailable_(0), dredProcessed_(false), dredCount_(0)
+{
+    int error;
+    decoder_ = opus_decoder_create(sampleRate, channels, &error);
+    if (error != OPUS_OK) {
+        throw std::runtime_error("Failed to create Opus decoder: " + std::string(opus_strerror(error)));
+    }
+}
+
+AudioDecoder::~AudioDecoder() {
+    if (decoder_) {
+        opus_decoder_destroy(decoder_);
+    }
+    if (dred_) {
+        opus_dred_free(dred_);
+    }
+    if (dredDecoder_) {
+        opus_dred_decoder_destroy(dredDecoder_);
+    }
+}
+
+AudioDecoder::AudioDecoder(AudioDecoder&& other) noexcept
+    : decoder_(other.decoder_), sampleRate_(other.sampleRate_), numChannels_(other.numChannels_),
+    concealedCount_(other.concealedCount_), recoveredCount_(other.recoveredCount_),
+    dredDecoder_(other.dredDecoder_), dred_(other.dred_), maxDredSamples_(other.maxDredSamples_),
+    dredPacket_(std::move(other.dredPacket_)), dredAvailable_(other.dredAvailable_),
+    dredProcessed_(other.dredProcessed_), dredCount_(other.dredCount_)
+{
+    other.decoder_ = nullptr;
+    other.dredDecoder_ = nullptr;
+    other.dred_ = nullptr;
+}
+
+AudioDecoder& AudioDecoder::operator=(AudioDecoder&& other) noexcept {
+    std::swap(decoder_, other.decoder_);
+    std::swap(sampleRate_, other.sampleRate_);
+    std::swap(numChannels_, other.numChannels_);
+    std::swap(concealedCount_, other.concealedCount_);
+    std::swap(recoveredCount_, other.recoveredCount_);
+    std::swap(dredDecoder_, other.dredDecoder_);
+    std::swap(dred_, other.dred_);
+    std::swap(maxDredSamples_, other.maxDredSamples_);
+    std::swap(dredPacket_, other.dredPacket_);
+    std::swap(dredAvailable_, other.dredAvailable_);
+    std::swap(dredProcessed_, other.dredProcessed_);
+    std::swap(dredCount_, other.dredCount_);
+    return *this;
+}
+
+std::vector<float> AudioDecoder::decode(const std::vector<unsigned char>& encodedData) {
     // Determine the number of samples in the decoded frame
     // Max frame size is 60ms, which at 48kHz is 2880 samples
-    const int MAX_FRAME_SIZE = 6 * sampleRate_ / 100; // 60ms at sampleRate
-    std::vector<opus_int16> pcm_int16(MAX_FRAME_SIZE * numChannels_);
+    const int MAX_FRAME_SIZE = maxFrameSize();
+    std::vector<float> decodedData(MAX_FRAME_SIZE * numChannels_);
+
+    int frame_size = decodeInto(encodedData.data(), encodedData.size(), decodedData.data(), MAX_FRAME_SIZE);
+    if (frame_size < 0) {
+        return {};
+    }
+    decodedData.resize(frame_size * numChannels_);
+    return decodedData;
+}
+
+int AudioDecoder::decodeInto(const unsigned char* data, size_t size, float* pcm, int maxFrameSize) {
+    if (!decoder_) {
+        std::cerr << "Decoder not initialized.\n";
+        return -1;
+    }
 
-    opus_int32 frame_size = opus_decode(decoder, encodedData.data(), (opus_int32)encodedData.size(),
-        pcm_int16.data(), MAX_FRAME_SIZE, 0); // 0 for not-FEC
+    // Decode as float directly into the caller's buffer (often the playback ring).
+    opus_int32 frame_size = opus_decode_float(decoder_, data, (opus_int32)size,
+        pcm, maxFrameSize, 0); // 0 for not-FEC
 
     if (frame_size < 0) {
         std::cerr << "Opus decoding failed: " << opus_strerror(frame_size) << std::endl;
-        return {};
+        return -1;
     }
 
     if (frame_size != 240 && frame_size != 480 && frame_size != 960 && frame_size != 1920 && frame_size != 2880) {
         std::cerr << "Warning: Unsupported frame_size for Opus: " << frame_size << std::endl;
     }
+    return frame_size;
+}
+
+int AudioDecoder::concealInto(const unsigned char* next, size_t nextSize, int nextOffset, float* pcm, int frameSize) {
+    if (!decoder_) {
+        std::cerr << "Decoder not initialized.\n";
+        return -1;
+    }
 
-    std::vector<float> decodedData(frame_size * numChannels_);
-    for (int i = 0; i < frame_size * numChannels_; ++i) {
-        decodedData[i] = static_cast<float>(pcm_int16[i]) / 32767.0f; // Scale back to float
+    const bool haveNext = next != nullptr && nextSize > 0;
+    opus_int32 frame_size;
+    uint64_t* counter;
+    if (haveNext && nextOffset == frameSize && opus_packet_has_lbrr(next, (opus_int32)nextSize) > 0) {
+        // With decode_fec=1 Opus returns the frame *before* `next`, taken from
+        // its LBRR data.
+        frame_size = opus_decode_float(decoder_, next, (opus_int32)nextSize, pcm, frameSize, 1);
+        counter = &recoveredCount_;
     }
-    return decodedData;
+    else if (haveNext && dred_ && parseDred(next, nextSize) >= nextOffset) {
+        // The neural part of DRED decoding only runs once a loss actually needs it.
+        if (!dredProcessed_) {
+            opus_dred_process(dredDecoder_, dred_, dred_);
+            dredProcessed_ = true;
+        }
+        frame_size = opus_decoder_dred_decode_float(decoder_, dred_, nextOffset, pcm, frameSize);
+        counter = &dredCount_;
+    }
+    else {
+        // A NULL packet asks for plain concealment.
+        frame_size = opus_decode_float(decoder_, nullptr, 0, pcm, frameSize, 0);
+        counter = &concealedCount_;
+    }
+    // Either way the decoder state stays continuous, so the next real frame doesn't click.
+
+    if (frame_size < 0) {
+        std::cerr << "Opus concealment failed: " << opus_strerror(frame_size) << std::endl;
+        return -1;
+    }
+    ++*counter;
+    return frame_size;
 }
 
-void AudioCodec::cleanupEncoder() {
-    if (encoder) {
-        opus_encoder_destroy(encoder);
-        encoder = nullptr;
+bool AudioDecoder::enableDred(int maxDurationMs) {
+    if (!decoder_ || dred_) {
+        return dred_ != nullptr;
+    }
+    int error;
+    dredDecoder_ = opus_dred_decoder_create(&error);
+    if (error != OPUS_OK) {
+        std::cerr << "Opus DRED not available: " << opus_strerror(error) << std::endl;
+        dredDecoder_ = nullptr;
+        return false;
+    }
+    dred_ = opus_dred_alloc(&error);
+    if (error != OPUS_OK) {
+        std::cerr << "Opus DRED not available: " << opus_strerror(error) << std::endl;
+        opus_dred_decoder_destroy(dredDecoder_);
+        dredDecoder_ = nullptr;
+        dred_ = nullptr;
+        return false;
     }
+    maxDredSamples_ = static_cast<int>(static_cast<int64_t>(maxDurationMs) * sampleRate_ / 1000);
+    dredPacket_.reserve(AudioEncoder::MAX_PACKET_SIZE);
+    return true;
 }
 
-void AudioCodec::cleanupDecoder() {
-    if (decoder) {
-        opus_decoder_destroy(decoder);
-        decoder = nullptr;
+int AudioDecoder::parseDred(const unsigned char* next, size_t nextSize) {
+    if (dredPacket_.size() == nextSize && std::memcmp(dredPacket_.data(), next, nextSize) == 0) {
+        return dredAvailable_;
+    }
+    dredPacket_.assign(next, next + nextSize);
+    dredProcessed_ = false;
+
+    // defer_processing=1: only the entropy decoding happens here; the DNN runs
+    // in opus_dred_process() when a frame is actually rebuilt from it.
+    int dredEnd = 0;
+    dredAvailable_ = opus_dred_parse(dredDecoder_, dred_, next, (opus_int32)nextSize,
+        maxDredSamples_, sampleRate_, &dredEnd, 1);
+    if (dredAvailable_ < 0) {
+        dredAvailable_ = 0;
     }
-}
\ No newline at end of file
+    return dredAvailable_;
+}
+
+int AudioDecoder::getFrameCount(const std::vector<unsigned char>& encodedData) const {
+    return getFrameCount(encodedData, sampleRate_);
+}
+
+int AudioDecoder::getFrameCount(const unsigned char* data, size_t size, int sampleRate) {
+    int frames = opus_packet_get_nb_samples(data, (opus_int32)size, sampleRate);
+    return (frames < 0) ? -1 : frames;
+}
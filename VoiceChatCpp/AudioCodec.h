@@ -4,22 +4,144 @@
 #include <vector>
 #include <string>
 #include <iostream> // Keep this for now, though it might be part of the operator<< issue
+#include <stdexcept>
+#include <cstdint>
 #include <opus.h> // <-- Use THIS if your 'Additional Include Directories' poi
 
-class AudioCodec {
+// One Opus encoder. Each outgoing stream owns its own instance, so several
+// can encode in parallel on different threads without sharing any state.
+// Movable, not copyable; a default-constructed encoder is empty (!valid()).
+class AudioEncoder {
 public:
-    static bool initializeEncoder(int sampleRate, int channels, int bitrate);
-    static bool initializeDecoder(int sampleRate, int channels);
-    static std::vector<unsigned char> encode(const std::vector<float>& pcmData);
-    static std::vector<float> decode(const std::vector<unsigned char>& encodedData);
-    static void cleanupEncoder();
-    static void cleanupDecoder();
+    AudioEncoder();
+    // Keeps audio up to bandwidthHz (see sampleRateForBandwidth()).
+    AudioEncoder(int sampleRate, int channels, int bitrate, int bandwidthHz); // Throws std::runtime_error
+    ~AudioEncoder();
+
+    AudioEncoder(AudioEncoder&& other) noexcept;
+    AudioEncoder& operator=(AudioEncoder&& other) noexcept;
+    AudioEncoder(const AudioEncoder&) = delete;
+    AudioEncoder& operator=(const AudioEncoder&) = delete;
+
+    // Largest packet encodeInto() will ever produce with this configuration.
+    static const int MAX_PACKET_SIZE = 4000;
+
+    // Allocation-free path: encodes frameSize frames of interleaved float PCM
+    // straight into packet (capacity maxPacketSize bytes). Returns the packet
+    // length in bytes, or -1 on failure.
+    int encodeInto(const float* pcm, int frameSize, unsigned char* packet, int maxPacketSize);
+
+    // Convenience wrapper around encodeInto(); allocates the returned packet.
+    std::vector<unsigned char> encode(const std::vector<float>& pcmData);
+
+    // Opt-in Deep REDundancy (Opus 1.5): every packet also carries a low-rate
+    // neural description of up to durationMs of the audio before it, so a
+    // receiver can rebuild whole bursts of lost packets from the first one that
+    // gets through. 0 turns it off. Returns false if this libopus was built
+    // without DRED (OPUS_DRED=OFF).
+    bool setDredDuration(int durationMs);
+
+    // Discontinuous transmission: once the encoder decides the input is silence
+    // it emits 1-2 byte frames the sender need not transmit (see TransmitGate).
+    void setDtx(bool enabled);
+
+    bool valid() const { return encoder_ != nullptr; }
+    int sampleRate() const { return sampleRate_; }
+    int channels() const { return numChannels_; }
+
+    // The lowest Opus sample rate that carries audio up to bandwidthHz in
+    // full, for the bandwidths Opus can be limited to: 4000 (narrowband),
+    // 6000, 8000 (wideband), 12000 or 20000 Hz (fullband). -1 for any other.
+    static int sampleRateForBandwidth(int bandwidthHz);
+
+    // Frames per channel in one frameMs frame at sampleRate, or -1 if Opus
+    // can't encode frames of that length (2.5, 5, 10, 20, 40 or 60 ms only).
+    static int frameSizeFor(int sampleRate, double frameMs);
 
 private:
-    static OpusEncoder* encoder;
-    static OpusDecoder* decoder;
-    static int numChannels_;
-    static int sampleRate_;
+    OpusEncoder* encoder_;
+    int sampleRate_;
+    int numChannels_;
+};
+
+// One Opus decoder, i.e. one per remote talker. Same ownership rules as AudioEncoder.
+class AudioDecoder {
+public:
+    AudioDecoder();
+    AudioDecoder(int sampleRate, int channels); // Throws std::runtime_error
+    ~AudioDecoder();
+
+    AudioDecoder(AudioDecoder&& other) noexcept;
+    AudioDecoder& operator=(AudioDecoder&& other) noexcept;
+    AudioDecoder(const AudioDecoder&) = delete;
+    AudioDecoder& operator=(const AudioDecoder&) = delete;
+
+    // Allocation-free path: decodes one packet into caller-provided interleaved
+    // float storage of at least maxFrameSize * channels samples.
+    // Returns frames per channel, or -1.
+    int decodeInto(const unsigned char* data, size_t size, float* pcm, int maxFrameSize);
+    int decode(const std::vector<unsigned char>& encodedData, float* pcm, int maxFrameSize) {
+        return decodeInto(encodedData.data(), encodedData.size(), pcm, maxFrameSize);
+    }
+
+    // Convenience wrapper around decodeInto(); allocates the returned samples.
+    std::vector<float> decode(const std::vector<unsigned char>& encodedData);
+
+    // Produces one missing frame of frameSize frames per channel (a multiple of
+    // 2.5 ms). next/nextSize is the first packet received after the gap, if any,
+    // and nextOffset how many frames per channel before its start the missing
+    // frame begins. In order of preference the frame is rebuilt from next's
+    // in-band FEC (only when it directly follows the gap), from its DRED data
+    // (if enableDred() was called), or extrapolated by Opus packet loss
+    // concealment. Returns frames per channel, or -1.
+    int concealInto(const unsigned char* next, size_t nextSize, int nextOffset, float* pcm, int frameSize);
+
+    // Lets concealInto() use DRED covering up to maxDurationMs before a packet.
+    // Returns false if this libopus was built without DRED.
+    bool enableDred(int maxDurationMs);
+
+    uint64_t concealedCount() const { return concealedCount_; } // Frames extrapolated by PLC
+    uint64_t recoveredCount() const { return recoveredCount_; } // Frames rebuilt from FEC
+    uint64_t dredCount() const { return dredCount_; }           // Frames rebuilt from DRED
+
+    // Frames per channel of the longest packet Opus allows (60 ms).
+    int maxFrameSize() const { return maxFrameSizeFor(sampleRate_); }
+    static int maxFrameSizeFor(int sampleRate) { return 6 * sampleRate / 100; }
+
+    // Frames per channel the packet will decode to at this decoder's rate.
+    int getFrameCount(const std::vector<unsigned char>& encodedData) const;
+    int getFrameCount(const unsigned char* data, size_t size) const {
+        return getFrameCount(data, size, sampleRate_);
+    }
+    // Same at an arbitrary rate, or -1 if the packet is malformed.
+    static int getFrameCount(const unsigned char* data, size_t size, int sampleRate);
+    static int getFrameCount(const std::vector<unsigned char>& encodedData, int sampleRate) {
+        return getFrameCount(encodedData.data(), encodedData.size(), sampleRate);
+    }
+
+    bool valid() const { return decoder_ != nullptr; }
+    int sampleRate() const { return sampleRate_; }
+    int channels() const { return numChannels_; }
+
+private:
+    // Samples of DRED available in `next`, parsing it only if it isn't the packet
+    // parsed last time (a burst of losses is usually rebuilt from one packet).
+    int parseDred(const unsigned char* next, size_t nextSize);
+
+    OpusDecoder* decoder_;
+    int sampleRate_;
+    int numChannels_;
+    uint64_t concealedCount_;
+    uint64_t recoveredCount_;
+
+    // DRED state, only allocated by enableDred().
+    OpusDREDDecoder* dredDecoder_;
+    OpusDRED* dred_;
+    int maxDredSamples_;
+    std::vector<unsigned char> dredPacket_; // Copy of the packet dred_ was parsed from
+    int dredAvailable_;                     // What opus_dred_parse() returned for it
+    bool dredProcessed_;                    // opus_dred_process() has run on it
+    uint64_t dredCount_;
 };
 
-#endif // AUDIO_CODEC_H
\ No newline at end of file
+#endif // AUDIO_CODEC_H
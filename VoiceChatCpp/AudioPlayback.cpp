@@ -1,10 +1,13 @@
 #include "AudioPlayback.h"
 
-AudioPlayback::AudioPlayback(int sampleRate, int framesPerBuffer, int numChannels)
+AudioPlayback::AudioPlayback(int sampleRate, int framesPerBuffer, int numChannels, int maxWriteFrames)
     : stream(nullptr),
     sampleRate_(sampleRate),
     framesPerBuffer_(framesPerBuffer),
-    numChannels_(numChannels)
+    numChannels_(numChannels),
+    ring_(static_cast<size_t>(std::max(maxWriteFrames, framesPerBuffer) + framesPerBuffer) * numChannels),
+    underrunCount_(0),
+    overflowSamples_(0)
 {
     PaError err = Pa_Initialize();
     if (err != paNoError) {
@@ -88,21 +91,43 @@ void AudioPlayback::stop() {
 }
 
 void AudioPlayback::playBlocking(const std::vector<float>& audioData) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    // Append incoming audio data to the playback buffer
-    playbackBuffer_.insert(playbackBuffer_.end(), audioData.begin(), audioData.end());
-    // Potentially notify the callback that new data is available
-
-       // --- NEW: Simple buffer size management ---
-    // Keep buffer size limited to avoid excessive delay accumulation.
-    // If buffer gets too large, drop older data.
-    const size_t MAX_BUFFER_FRAMES = framesPerBuffer_ * 3; // e.g., keep max 3 frames worth of data
-    if (playbackBuffer_.size() > MAX_BUFFER_FRAMES * numChannels_) {
-        playbackBuffer_.erase(playbackBuffer_.begin(), playbackBuffer_.begin() + (playbackBuffer_.size() - MAX_BUFFER_FRAMES * numChannels_));
-        std::cerr << "Warning: Playback buffer too large, dropping old data!\n";
+    // Append incoming audio data to the playback ring. The ring size bounds the
+    // delay we can accumulate; whatever doesn't fit is dropped here instead of
+    // making the callback wait.
+    size_t written = ring_.write(audioData.data(), audioData.size());
+    if (written < audioData.size()) {
+        // Only the first overflow is reported; overflowSamples() keeps the count.
+        if (overflowSamples_.fetch_add(audioData.size() - written, std::memory_order_relaxed) == 0) {
+            std::cerr << "Warning: Playback buffer full, dropped " << (audioData.size() - written) << " samples!\n";
+        }
+    }
+}
+
+float* AudioPlayback::acquireWrite(size_t samples) {
+    float* region1;
+    float* region2;
+    size_t size1, size2;
+    ring_.getWriteRegions(samples, &region1, &size1, &region2, &size2);
+    // Frames don't divide the ring, so one may straddle its end; the caller
+    // then decodes elsewhere and copies it in with playBlocking().
+    return (size1 == samples) ? region1 : nullptr;
+}
+
+void AudioPlayback::commitWrite(size_t samples) {
+    ring_.commitWrite(samples);
+}
+
+void AudioPlayback::waitForRoom(size_t maxQueued) {
+    // Missed notifications are covered by re-checking once per period.
+    const auto period = std::chrono::microseconds(1000000LL * framesPerBuffer_ / std::max(sampleRate_, 1));
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (ring_.readAvailable() > maxQueued && stream) {
+        condVar_.wait_for(lock, period);
     }
-    // --- END NEW ---
-    condVar_.notify_one();
+}
+
+void AudioPlayback::waitForSpace(size_t samples) {
+    waitForRoom(ring_.capacity() - std::min(samples, ring_.capacity()));
 }
 
 int AudioPlayback::paCallback(const void* inputBuffer, void* outputBuffer,
@@ -114,24 +139,14 @@ int AudioPlayback::paCallback(const void* inputBuffer, void* outputBuffer,
     float* out = static_cast<float*>(outputBuffer);
     unsigned long framesToRead = framesPerBuffer * This->numChannels_;
 
-    std::unique_lock<std::mutex> lock(This->mutex_);
-
-    // Simple jitter buffer logic:
-    // If we don't have enough data, fill with silence.
-    // In a real system, you'd implement a more sophisticated jitter buffer
-    // that aims for a target buffer size and handles packet loss/reordering.
-    if (This->playbackBuffer_.size() < framesToRead) {
-        std::fill(out, out + framesToRead, 0.0f); // Fill with silence
-        // Optionally, wait for more data using condVar_.wait_for or similar
-        // This might introduce delays if not carefully managed.
-        return paContinue;
-    }
-
-    // Copy data from buffer to output
-    for (unsigned long i = 0; i < framesToRead; ++i) {
-        out[i] = This->playbackBuffer_.front();
-        This->playbackBuffer_.pop_front();
+    // Real-time thread: at most two block copies out of the ring, no locks.
+    // Whatever the ring can't supply is played as silence and counted.
+    size_t copied = This->ring_.read(out, framesToRead);
+    if (copied < framesToRead) {
+        std::fill(out + copied, out + framesToRead, 0.0f); // Fill with silence
+        This->underrunCount_.fetch_add(1, std::memory_order_relaxed);
     }
+    This->condVar_.notify_one(); // Room for more; no lock taken here
 
     return paContinue;
 }
\ No newline at end of file
@@ -7,18 +7,42 @@
 #include <stdexcept>
 #include <mutex>
 #include <condition_variable>
-#include <deque> // For simple playback buffer/jitter
+#include <chrono>
+#include <atomic>
+#include <cstdint>
 #include <algorithm> // For std::fill
+#include "SpscRingBuffer.h"
 
 class AudioPlayback {
 public:
-    AudioPlayback(int sampleRate, int framesPerBuffer, int numChannels);
+    // maxWriteFrames is the longest block (frames per channel) that will be
+    // written at once, e.g. the longest Opus frame after resampling.
+    AudioPlayback(int sampleRate, int framesPerBuffer, int numChannels, int maxWriteFrames);
     ~AudioPlayback();
 
     bool start();
     void stop();
     void playBlocking(const std::vector<float>& audioData); // Add audio to playback buffer
 
+    // Zero-copy producer path: returns a contiguous slot for `samples` interleaved
+    // samples inside the playback ring (or nullptr if there isn't one right now).
+    // Decode straight into it, then publish with commitWrite().
+    float* acquireWrite(size_t samples);
+    void commitWrite(size_t samples);
+
+    // Samples queued for the device, and a wait until at most maxQueued remain.
+    // The decode thread uses this to pull from the jitter buffer just in time.
+    size_t queuedSamples() const { return ring_.readAvailable(); }
+    void waitForRoom(size_t maxQueued);
+    // Waits until `samples` more fit in the ring (at most all of it), so a
+    // whole frame can be written without dropping any of it.
+    void waitForSpace(size_t samples);
+
+    // Callbacks that found fewer samples than the device asked for.
+    uint64_t underrunCount() const { return underrunCount_.load(std::memory_order_relaxed); }
+    // Samples dropped by playBlocking() because the ring was full.
+    uint64_t overflowSamples() const { return overflowSamples_.load(std::memory_order_relaxed); }
+
 private:
     static int paCallback(const void* inputBuffer, void* outputBuffer,
         unsigned long framesPerBuffer,
@@ -31,8 +55,15 @@ private:
     int framesPerBuffer_;
     int numChannels_;
 
-    // Simple playback buffer (can be optimized with a proper jitter buffer)
-    std::deque<float> playbackBuffer_;
+    // Decoded audio waiting for the device. Single producer (decode thread),
+    // single consumer (paCallback), no locks on either side. It holds the
+    // largest write plus one period, so a whole frame always fits once the
+    // device has drained the ring to one period.
+    SpscRingBuffer<float> ring_;
+    std::atomic<uint64_t> underrunCount_;
+    std::atomic<uint64_t> overflowSamples_;
+
+    // Only used by waitForRoom(); the callback notifies without locking.
     std::mutex mutex_;
     std::condition_variable condVar_;
 };
@@ -0,0 +1,68 @@
+#include "Denoiser.h"
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+
+// PortAudio delivers floats in [-1, 1]; RNNoise expects the int16 range.
+static const float PCM_SCALE = 32768.0f;
+
+bool Denoiser::supportsSampleRate(int sampleRate) {
+    return sampleRate == 48000 || sampleRate == 16000 || sampleRate == 8000;
+}
+
+Denoiser::Denoiser(int sampleRate, int channels)
+    : channels_(channels),
+    frameSize_(sampleRate / 100),
+    adapter_(static_cast<size_t>(frameSize_) * std::max(channels, 1)),
+    planarIn_(frameSize_),
+    planarOut_(frameSize_),
+    voiceProbability_(0.0f)
+{
+    if (!supportsSampleRate(sampleRate)) {
+        throw std::runtime_error("RNNoise needs 48000, 16000 or 8000 Hz input, got " + std::to_string(sampleRate));
+    }
+    if (channels <= 0) {
+        throw std::runtime_error("Invalid channel count for denoiser");
+    }
+    for (int c = 0; c < channels; ++c) {
+        DenoiseState* state = rnnoise_create_rate(nullptr, sampleRate); // nullptr = built-in model
+        if (!state) {
+            for (DenoiseState* s : states_) rnnoise_destroy(s);
+            throw std::runtime_error("Failed to create RNNoise state");
+        }
+        states_.push_back(state);
+    }
+}
+
+Denoiser::~Denoiser() {
+    for (DenoiseState* state : states_) {
+        rnnoise_destroy(state);
+    }
+}
+
+void Denoiser::process(const float* in, size_t count, std::vector<float>& out) {
+    out.clear();
+    float peak = -1.0f;
+    adapter_.push(in, count, [&](const float* frame) { peak = std::max(peak, processFrame(frame, out)); });
+    if (peak >= 0.0f) {
+        voiceProbability_ = peak;
+    }
+}
+
+float Denoiser::processFrame(const float* frame, std::vector<float>& out) {
+    const size_t offset = out.size();
+    out.resize(offset + static_cast<size_t>(frameSize_) * channels_);
+    float* dst = out.data() + offset;
+
+    float vad = 0.0f;
+    for (int c = 0; c < channels_; ++c) {
+        for (int i = 0; i < frameSize_; ++i) {
+            planarIn_[i] = frame[i * channels_ + c] * PCM_SCALE;
+        }
+        vad = std::max(vad, rnnoise_process_frame(states_[c], planarOut_.data(), planarIn_.data()));
+        for (int i = 0; i < frameSize_; ++i) {
+            dst[i * channels_ + c] = planarOut_[i] * (1.0f / PCM_SCALE);
+        }
+    }
+    return vad;
+}
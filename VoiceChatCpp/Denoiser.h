@@ -0,0 +1,51 @@
+#ifndef DENOISER_H
+#define DENOISER_H
+
+#include <vector>
+#include <cstddef>
+#include <rnnoise.h>
+#include "FrameAdapter.h"
+
+// RNNoise noise suppression for the capture path, between AudioCapture and the
+// encoder. RNNoise works on fixed 10 ms frames of mono samples in 16-bit range,
+// at 48, 16 or 8 kHz (the lower rates do proportionally less work, so narrowband
+// callers needn't resample up); this class adapts any chunk size and channel
+// count to that and keeps one DenoiseState per channel (the network carries
+// recurrent state).
+//
+// The output lags the input by up to one RNNoise frame of buffering, so
+// process() can return fewer or more samples than it was given.
+class Denoiser {
+public:
+    // 48000, 16000 or 8000
+    static bool supportsSampleRate(int sampleRate);
+
+    Denoiser(int sampleRate, int channels); // Throws std::runtime_error
+    ~Denoiser();
+
+    Denoiser(const Denoiser&) = delete;
+    Denoiser& operator=(const Denoiser&) = delete;
+
+    // Denoises count interleaved samples; whatever complete frames that yields
+    // replace the contents of out.
+    void process(const float* in, size_t count, std::vector<float>& out);
+
+    // Highest RNNoise voice activity probability over the channels and over the
+    // frames the last process() call completed; unchanged by a call that
+    // completed none (0 before the first frame).
+    float voiceProbability() const { return voiceProbability_; }
+
+private:
+    // Returns the frame's voice probability.
+    float processFrame(const float* frame, std::vector<float>& out);
+
+    const int channels_;
+    const int frameSize_; // Per channel, 10 ms
+    std::vector<DenoiseState*> states_;
+    FrameAdapter adapter_;
+    std::vector<float> planarIn_;  // One channel of the current frame, in 16-bit range
+    std::vector<float> planarOut_;
+    float voiceProbability_;
+};
+
+#endif // DENOISER_H
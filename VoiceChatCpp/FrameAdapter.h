@@ -0,0 +1,58 @@
+#ifndef FRAME_ADAPTER_H
+#define FRAME_ADAPTER_H
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+// Re-blocks a stream of interleaved audio arriving in chunks of any size into
+// frames of exactly frameSamples samples (frames per channel * channels).
+//
+// This is what lets the device run at whatever period it likes while Opus gets
+// legal 2.5/5/10/20 ms frames (and RNNoise its fixed 480-sample frames). Whole
+// frames that lie inside an input chunk are handed out in place; only the
+// pieces that straddle two chunks are copied into the internal frame buffer.
+class FrameAdapter {
+public:
+    explicit FrameAdapter(size_t frameSamples)
+        : frame_(frameSamples), fill_(0) {}
+
+    size_t frameSamples() const { return frame_.size(); }
+    size_t buffered() const { return fill_; } // Samples waiting for the rest of their frame
+    void reset() { fill_ = 0; }
+
+    // Feeds count samples and calls onFrame(const float* frame) once per
+    // completed frame. The pointer is only valid during the call.
+    template <typename F>
+    void push(const float* data, size_t count, F&& onFrame) {
+        const size_t frameSamples = frame_.size();
+        if (fill_ > 0) {
+            const size_t take = std::min(count, frameSamples - fill_);
+            std::memcpy(frame_.data() + fill_, data, take * sizeof(float));
+            fill_ += take;
+            data += take;
+            count -= take;
+            if (fill_ < frameSamples) {
+                return;
+            }
+            onFrame(static_cast<const float*>(frame_.data()));
+            fill_ = 0;
+        }
+        while (count >= frameSamples) {
+            onFrame(data); // Zero-copy: the frame is contiguous in the input
+            data += frameSamples;
+            count -= frameSamples;
+        }
+        if (count > 0) {
+            std::memcpy(frame_.data(), data, count * sizeof(float));
+            fill_ = count;
+        }
+    }
+
+private:
+    std::vector<float> frame_;
+    size_t fill_;
+};
+
+#endif // FRAME_ADAPTER_H
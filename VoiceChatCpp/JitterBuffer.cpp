@@ -0,0 +1,274 @@
+#include "JitterBuffer.h"
+#include <algorithm>
+#include <cstdlib>
+
+JitterBuffer::JitterBuffer(int clockRate, int minDelayMs, int maxDelayMs)
+    : clockRate_(clockRate),
+    minDelayMs_(minDelayMs),
+    maxDelayMs_(maxDelayMs),
+    slots_(static_cast<size_t>(std::max(maxDelayMs, 0)) * MAX_FRAMES_PER_SECOND / 1000 + 1),
+    count_(0),
+    firstSequence_(0),
+    lastSequence_(0),
+    haveSequence_(false),
+    highestSequence_(0),
+    haveTransit_(false),
+    lastTransit_(0),
+    jitter_(0.0),
+    epoch_(Clock::now()),
+    playing_(false),
+    nextSequence_(0),
+    nextTimestamp_(0),
+    lastDuration_(0),
+    emptyFrames_(0),
+    targetDelayMs_(minDelayMs),
+    lateCount_(0),
+    lostCount_(0),
+    droppedCount_(0)
+{
+}
+
+void JitterBuffer::push(MediaPacket&& packet) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    packet.arrival = Clock::now();
+
+    int64_t sequence = extendSequence(packet.sequence);
+    if (!haveSequence_ || sequence > highestSequence_) {
+        highestSequence_ = sequence;
+        haveSequence_ = true;
+    }
+    updateJitter(packet);
+
+    if (playing_ && packet.marker && count_ == 0) {
+        // New talk-spurt: let pop() pick a fresh playout delay for it. This comes
+        // before the lateness check because a sender using DTX doesn't spend
+        // sequence numbers on the frames it suppressed, while pop() has been
+        // counting those as Lost and so may already be past this one.
+        playing_ = false;
+    }
+    if (playing_ && sequence < nextSequence_) {
+        // Its playout slot has already gone by (played as Lost).
+        ++lateCount_;
+        return;
+    }
+    if (lastDuration_ == 0) {
+        lastDuration_ = packet.duration;
+    }
+    if (!store(sequence, std::move(packet))) {
+        return;
+    }
+
+    // Never hold more than maxDelayMs_ of audio; drop the oldest instead.
+    const uint32_t maxTicks = static_cast<uint32_t>(static_cast<int64_t>(maxDelayMs_) * clockRate_ / 1000);
+    while (count_ > 1 && bufferedTicks() > maxTicks) {
+        dropFirst();
+    }
+    condVar_.notify_one();
+}
+
+JitterBuffer::Result JitterBuffer::pop(MediaPacket& packet) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!playing_) {
+        if (count_ == 0 || !readyToStart(Clock::now())) {
+            return Result::Empty;
+        }
+        startTalkSpurt();
+    }
+
+    if (count_ > 0 && firstSequence_ == nextSequence_) {
+        packet = std::move(slot(firstSequence_).packet);
+        removeFirst();
+        ++nextSequence_;
+        emptyFrames_ = 0;
+        if (packet.duration != 0) {
+            lastDuration_ = packet.duration;
+        }
+        nextTimestamp_ = packet.timestamp + lastDuration_;
+        return Result::Packet;
+    }
+
+    if (count_ == 0 && ++emptyFrames_ >= END_OF_SPURT_FRAMES) {
+        // The sender has gone quiet; the next packet starts a new spurt.
+        playing_ = false;
+        return Result::Empty;
+    }
+
+    // Either a hole before the packets we do have, or the next packet is late.
+    // Keep the playout clock running and report the frame as missing.
+    ++nextSequence_;
+    ++lostCount_;
+    packet.timestamp = nextTimestamp_;
+    packet.duration = lastDuration_;
+    nextTimestamp_ += lastDuration_;
+    if (count_ > 0) {
+        // A later packet is here already; share it for FEC/DRED and leave
+        // it queued for its own playout slot.
+        const MediaPacket& next = slot(firstSequence_).packet;
+        packet.payload = next.payload;
+        packet.nextOffset = next.timestamp - packet.timestamp;
+    }
+    else {
+        packet.payload.reset();
+        packet.nextOffset = 0;
+    }
+    return Result::Lost;
+}
+
+void JitterBuffer::wait(std::chrono::milliseconds maxWait) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const Clock::time_point deadline = Clock::now() + maxWait;
+    if (count_ == 0) {
+        condVar_.wait_until(lock, deadline, [this] { return count_ > 0; });
+    }
+    if (!playing_ && count_ > 0) {
+        // Buffering the start of a talk-spurt: sleep until its playout time.
+        Clock::time_point start = slot(firstSequence_).packet.arrival + std::chrono::milliseconds(targetDelayMs_);
+        condVar_.wait_until(lock, std::min(start, deadline));
+    }
+}
+
+int64_t JitterBuffer::extendSequence(uint16_t sequence) const {
+    if (!haveSequence_) {
+        return sequence;
+    }
+    // Pick the 64-bit value closest to the highest sequence seen so far.
+    int64_t extended = (highestSequence_ & ~static_cast<int64_t>(0xFFFF)) | sequence;
+    if (extended - highestSequence_ > 0x8000) {
+        extended -= 0x10000;
+    }
+    else if (highestSequence_ - extended > 0x8000) {
+        extended += 0x10000;
+    }
+    return extended;
+}
+
+void JitterBuffer::updateJitter(const MediaPacket& packet) {
+    // RFC 3550: J += (|D(i-1,i)| - J) / 16, with D the change in transit time.
+    const int64_t arrivalUs = std::chrono::duration_cast<std::chrono::microseconds>(packet.arrival - epoch_).count();
+    const uint32_t arrivalTicks = static_cast<uint32_t>(arrivalUs * clockRate_ / 1000000);
+    const uint32_t transit = arrivalTicks - packet.timestamp;
+    if (haveTransit_) {
+        int32_t d = static_cast<int32_t>(transit - lastTransit_);
+        jitter_ += (std::abs(static_cast<double>(d)) - jitter_) / 16.0;
+    }
+    lastTransit_ = transit;
+    haveTransit_ = true;
+}
+
+void JitterBuffer::startTalkSpurt() {
+    playing_ = true;
+    nextSequence_ = firstSequence_;
+    nextTimestamp_ = slot(firstSequence_).packet.timestamp;
+    emptyFrames_ = 0;
+}
+
+bool JitterBuffer::readyToStart(Clock::time_point now) {
+    // The delay is chosen once per talk-spurt: one frame plus a few times the
+    // current jitter estimate, within the configured bounds.
+    const double frameMs = 1000.0 * lastDuration_ / clockRate_;
+    const double jitterMs = 1000.0 * jitter_ / clockRate_;
+    int target = static_cast<int>(frameMs + JITTER_MULTIPLIER * jitterMs + 0.5);
+    targetDelayMs_ = std::max(minDelayMs_, std::min(maxDelayMs_, target));
+    return now >= slot(firstSequence_).packet.arrival + std::chrono::milliseconds(targetDelayMs_);
+}
+
+uint32_t JitterBuffer::bufferedTicks() const {
+    const MediaPacket& first = slot(firstSequence_).packet;
+    const MediaPacket& last = slot(lastSequence_).packet;
+    return last.timestamp + last.duration - first.timestamp;
+}
+
+JitterBuffer::Slot& JitterBuffer::slot(int64_t sequence) {
+    const int64_t size = static_cast<int64_t>(slots_.size());
+    return slots_[static_cast<size_t>((sequence % size + size) % size)];
+}
+
+const JitterBuffer::Slot& JitterBuffer::slot(int64_t sequence) const {
+    const int64_t size = static_cast<int64_t>(slots_.size());
+    return slots_[static_cast<size_t>((sequence % size + size) % size)];
+}
+
+bool JitterBuffer::store(int64_t sequence, MediaPacket&& packet) {
+    const int64_t size = static_cast<int64_t>(slots_.size());
+    bool dropped = false;
+    if (count_ > 0) {
+        if (slot(sequence).used && slot(sequence).sequence == sequence) {
+            return false; // Duplicate: every buffered sequence has a slot of its own
+        }
+        if (sequence < firstSequence_ && lastSequence_ - sequence >= size) {
+            // Older than anything buffered and too far behind the newest to
+            // fit beside it: it would be the first to go anyway.
+            ++droppedCount_;
+            return false;
+        }
+        // Too far ahead of the oldest (a long gap, or frames shorter than
+        // their timestamps claim): make room the way maxDelayMs_ would.
+        while (count_ > 0 && sequence - firstSequence_ >= size) {
+            dropFirst();
+            dropped = true;
+        }
+    }
+    Slot& s = slot(sequence);
+    s.used = true;
+    s.sequence = sequence;
+    s.packet = std::move(packet);
+    if (count_++ == 0) {
+        firstSequence_ = lastSequence_ = sequence;
+    }
+    else {
+        firstSequence_ = std::min(firstSequence_, sequence);
+        lastSequence_ = std::max(lastSequence_, sequence);
+    }
+    if (dropped && playing_ && firstSequence_ == sequence) {
+        // Everything before it was dropped; play on from here.
+        nextSequence_ = sequence;
+        nextTimestamp_ = s.packet.timestamp;
+    }
+    return true;
+}
+
+void JitterBuffer::removeFirst() {
+    Slot& first = slot(firstSequence_);
+    first.used = false;
+    first.packet.payload.reset(); // Back to the pool now, not when the slot is reused
+    if (--count_ > 0) {
+        do {
+            ++firstSequence_;
+        } while (!slot(firstSequence_).used);
+    }
+}
+
+void JitterBuffer::dropFirst() {
+    removeFirst();
+    ++droppedCount_;
+    if (playing_ && count_ > 0) {
+        nextSequence_ = firstSequence_;
+        nextTimestamp_ = slot(firstSequence_).packet.timestamp;
+    }
+}
+
+double JitterBuffer::jitterMs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return 1000.0 * jitter_ / clockRate_;
+}
+
+int JitterBuffer::targetDelayMs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return targetDelayMs_;
+}
+
+uint64_t JitterBuffer::lateCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lateCount_;
+}
+
+uint64_t JitterBuffer::lostCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lostCount_;
+}
+
+uint64_t JitterBuffer::droppedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return droppedCount_;
+}
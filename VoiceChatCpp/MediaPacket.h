@@ -0,0 +1,21 @@
+#ifndef MEDIA_PACKET_H
+#define MEDIA_PACKET_H
+
+#include <cstdint>
+#include <chrono>
+#include "PacketBuffer.h"
+
+// One encoded audio frame plus the sequencing information the jitter buffer
+// needs to put it back in order and on time.
+struct MediaPacket {
+    uint16_t sequence = 0;  // +1 per packet sent, wraps at 65536
+    uint32_t timestamp = 0; // Media clock (48 kHz for Opus) at the first sample
+    uint32_t duration = 0;  // Media clock ticks covered by the payload
+    bool marker = false;    // First packet of a talk-spurt
+    uint32_t ssrc = 0;      // Identifies the sending stream
+    uint32_t nextOffset = 0; // Lost frames only: ticks from this frame to the packet in `payload`
+    PacketBuffer payload;   // The Opus packet: a slice of the pooled datagram it came in
+    std::chrono::steady_clock::time_point arrival; // Stamped by the jitter buffer
+};
+
+#endif // MEDIA_PACKET_H
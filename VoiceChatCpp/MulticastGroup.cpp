@@ -0,0 +1,231 @@
+#include "MulticastGroup.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <net/if.h>
+#endif
+
+namespace {
+
+void reportSocketError(const char* what) {
+#ifdef _WIN32
+    std::cerr << what << ": " << WSAGetLastError() << "\n";
+#else
+    perror(what);
+#endif
+}
+
+// Parses a numeric IPv4 or IPv6 address, splitting off an IPv6 "%scope".
+bool parseAddress(const std::string& text, sockaddr_storage& addr, std::string& scope) {
+    std::memset(&addr, 0, sizeof(addr));
+    size_t percent = text.find('%');
+    std::string host = text.substr(0, percent);
+    scope = percent == std::string::npos ? std::string() : text.substr(percent + 1);
+
+    sockaddr_in* v4 = reinterpret_cast<sockaddr_in*>(&addr);
+    if (scope.empty() && inet_pton(AF_INET, host.c_str(), &v4->sin_addr) == 1) {
+        v4->sin_family = AF_INET;
+        return true;
+    }
+    sockaddr_in6* v6 = reinterpret_cast<sockaddr_in6*>(&addr);
+    if (inet_pton(AF_INET6, host.c_str(), &v6->sin6_addr) == 1) {
+        v6->sin6_family = AF_INET6;
+        return true;
+    }
+    return false;
+}
+
+bool isMulticastAddress(const sockaddr_storage& addr) {
+    if (addr.ss_family == AF_INET) {
+        return IN_MULTICAST(ntohl(reinterpret_cast<const sockaddr_in&>(addr).sin_addr.s_addr));
+    }
+    return IN6_IS_ADDR_MULTICAST(&reinterpret_cast<const sockaddr_in6&>(addr).sin6_addr);
+}
+
+// An interface by name or index; 0 if there is no such interface. Windows
+// names are the short ones if_nametoindex knows ("ethernet_32768"); the index
+// from "netsh interface ip show interfaces" is easier there.
+unsigned int interfaceIndex(const std::string& name) {
+    if (name.find_first_not_of("0123456789") == std::string::npos) {
+        return static_cast<unsigned int>(std::strtoul(name.c_str(), nullptr, 10));
+    }
+    return if_nametoindex(name.c_str());
+}
+
+} // namespace
+
+bool MulticastGroup::isMulticast(const std::string& address) {
+    sockaddr_storage addr;
+    std::string scope;
+    return parseAddress(address, addr, scope) && isMulticastAddress(addr);
+}
+
+MulticastGroup::MulticastGroup(const std::string& group, unsigned short port, const MulticastOptions& options)
+    : hasSource_(!options.source.empty()), interface_(0), ttl_(options.ttl), loopback_(options.loopback), valid_(false) {
+    std::memset(&source_, 0, sizeof(source_));
+
+    std::string scope;
+    if (!parseAddress(group, group_, scope) || !isMulticastAddress(group_)) {
+        std::cerr << "Invalid multicast address: " << group << "\n";
+        return;
+    }
+    if (family() == AF_INET6) {
+        reinterpret_cast<sockaddr_in6&>(group_).sin6_port = htons(port);
+    }
+    else {
+        reinterpret_cast<sockaddr_in&>(group_).sin_port = htons(port);
+    }
+
+    std::string interfaceName = options.interfaceName.empty() ? scope : options.interfaceName;
+    if (!interfaceName.empty()) {
+        interface_ = interfaceIndex(interfaceName);
+        if (interface_ == 0) {
+            std::cerr << "No such network interface: " << interfaceName << "\n";
+            return;
+        }
+    }
+    if (family() == AF_INET6) {
+        // Needed to send to or bind to link-local groups (ff02::/16)
+        reinterpret_cast<sockaddr_in6&>(group_).sin6_scope_id = interface_;
+    }
+
+    std::string sourceScope;
+    if (hasSource_ && (!parseAddress(options.source, source_, sourceScope) ||
+        source_.ss_family != group_.ss_family || isMulticastAddress(source_))) {
+        std::cerr << "Invalid multicast source for " << group << ": " << options.source << "\n";
+        return;
+    }
+
+    if (ttl_ < 0 || ttl_ > 255) {
+        std::cerr << "Invalid multicast TTL: " << ttl_ << "\n";
+        return;
+    }
+    valid_ = true;
+}
+
+socklen_t MulticastGroup::addressLength() const {
+    return family() == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+}
+
+sockaddr_storage MulticastGroup::bindAddress() const {
+    sockaddr_storage addr = group_;
+#ifdef _WIN32
+    if (family() == AF_INET6) {
+        reinterpret_cast<sockaddr_in6&>(addr).sin6_addr = in6addr_any;
+        reinterpret_cast<sockaddr_in6&>(addr).sin6_scope_id = 0;
+    }
+    else {
+        reinterpret_cast<sockaddr_in&>(addr).sin_addr.s_addr = htonl(INADDR_ANY);
+    }
+#endif
+    return addr;
+}
+
+// The protocol-independent joins of RFC 3678 (MCAST_JOIN_SOURCE_GROUP is
+// IP_ADD_SOURCE_MEMBERSHIP for either family), which also take the interface
+// by index for IPv4.
+bool MulticastGroup::join(Socket sockfd) const {
+    if (!valid_) return false;
+
+    int result;
+    if (hasSource_) {
+        group_source_req req;
+        std::memset(&req, 0, sizeof(req));
+        req.gsr_interface = interface_;
+        std::memcpy(&req.gsr_group, &group_, sizeof(group_));
+        std::memcpy(&req.gsr_source, &source_, sizeof(source_));
+        result = setsockopt(sockfd, level(), MCAST_JOIN_SOURCE_GROUP, (const char*)&req, sizeof(req));
+    }
+    else {
+        group_req req;
+        std::memset(&req, 0, sizeof(req));
+        req.gr_interface = interface_;
+        std::memcpy(&req.gr_group, &group_, sizeof(group_));
+        result = setsockopt(sockfd, level(), MCAST_JOIN_GROUP, (const char*)&req, sizeof(req));
+    }
+    if (result != 0) {
+        reportSocketError("Multicast join failed");
+        return false;
+    }
+    return true;
+}
+
+void MulticastGroup::leave(Socket sockfd) const {
+    if (!valid_) return;
+
+    if (hasSource_) {
+        group_source_req req;
+        std::memset(&req, 0, sizeof(req));
+        req.gsr_interface = interface_;
+        std::memcpy(&req.gsr_group, &group_, sizeof(group_));
+        std::memcpy(&req.gsr_source, &source_, sizeof(source_));
+        setsockopt(sockfd, level(), MCAST_LEAVE_SOURCE_GROUP, (const char*)&req, sizeof(req));
+    }
+    else {
+        group_req req;
+        std::memset(&req, 0, sizeof(req));
+        req.gr_interface = interface_;
+        std::memcpy(&req.gr_group, &group_, sizeof(group_));
+        setsockopt(sockfd, level(), MCAST_LEAVE_GROUP, (const char*)&req, sizeof(req));
+    }
+}
+
+bool MulticastGroup::configureSender(Socket sockfd) const {
+    if (!valid_) return false;
+
+    if (family() == AF_INET6) {
+        int hops = ttl_;
+        if (setsockopt(sockfd, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, (const char*)&hops, sizeof(hops)) != 0) {
+            reportSocketError("Setting IPV6_MULTICAST_HOPS failed");
+            return false;
+        }
+        unsigned int loop = loopback_ ? 1 : 0;
+        if (setsockopt(sockfd, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, (const char*)&loop, sizeof(loop)) != 0) {
+            reportSocketError("Setting IPV6_MULTICAST_LOOP failed");
+            return false;
+        }
+        if (interface_ != 0 &&
+            setsockopt(sockfd, IPPROTO_IPV6, IPV6_MULTICAST_IF, (const char*)&interface_, sizeof(interface_)) != 0) {
+            reportSocketError("Setting IPV6_MULTICAST_IF failed");
+            return false;
+        }
+        return true;
+    }
+
+#ifdef _WIN32
+    DWORD ttl = static_cast<DWORD>(ttl_);
+    DWORD loop = loopback_ ? 1 : 0;
+#else
+    // The BSDs only take a byte here; Linux takes a byte or an int.
+    unsigned char ttl = static_cast<unsigned char>(ttl_);
+    unsigned char loop = loopback_ ? 1 : 0;
+#endif
+    if (setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&ttl, sizeof(ttl)) != 0) {
+        reportSocketError("Setting IP_MULTICAST_TTL failed");
+        return false;
+    }
+    if (setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_LOOP, (const char*)&loop, sizeof(loop)) != 0) {
+        reportSocketError("Setting IP_MULTICAST_LOOP failed");
+        return false;
+    }
+    if (interface_ != 0) {
+#ifdef _WIN32
+        // An "address" in 0.0.0.0/8 is taken as an interface index.
+        DWORD index = htonl(interface_);
+        int result = setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_IF, (const char*)&index, sizeof(index));
+#else
+        ip_mreqn req;
+        std::memset(&req, 0, sizeof(req));
+        req.imr_ifindex = static_cast<int>(interface_);
+        int result = setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_IF, &req, sizeof(req));
+#endif
+        if (result != 0) {
+            reportSocketError("Setting IP_MULTICAST_IF failed");
+            return false;
+        }
+    }
+    return true;
+}
\ No newline at end of file
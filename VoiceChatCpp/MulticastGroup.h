@@ -0,0 +1,81 @@
+#ifndef MULTICAST_GROUP_H
+#define MULTICAST_GROUP_H
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <iphlpapi.h> // if_nametoindex
+#pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "iphlpapi.lib")
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+#include <string>
+
+// How to join a multicast group, or send to one.
+struct MulticastOptions {
+    // Source-specific multicast (RFC 4607): only this sender's packets are
+    // delivered, and switches and routers that follow IGMPv3/MLDv2 only
+    // forward that sender's traffic to us instead of every sender's.
+    // Empty = any source.
+    std::string source;
+    // Interface to join on and send from, by name ("eth0") or index. Empty =
+    // the one the routing table picks.
+    std::string interfaceName;
+    // Routers a sent packet may cross (the IPv6 hop limit); 1 = this link only.
+    int ttl = 1;
+    // Whether sent packets also reach receivers on this host.
+    bool loopback = true;
+};
+
+// An IPv4 or IPv6 multicast group with its options, parsed and checked once.
+// Joins receiving sockets to it, and sets up sockets sending to it.
+class MulticastGroup {
+public:
+#ifdef _WIN32
+    typedef SOCKET Socket;
+#else
+    typedef int Socket;
+#endif
+
+    // Whether address is an IPv4 or IPv6 multicast address.
+    static bool isMulticast(const std::string& address);
+
+    // valid() is false, after printing why, if group is not a multicast
+    // address, the source is not an address of the same family or the
+    // interface does not exist. An IPv6 group may carry its interface as a
+    // scope ("ff02::1234%eth0").
+    MulticastGroup(const std::string& group, unsigned short port, const MulticastOptions& options);
+
+    bool valid() const { return valid_; }
+    int family() const { return group_.ss_family; }
+    // The group and port, to send to.
+    const sockaddr* address() const { return reinterpret_cast<const sockaddr*>(&group_); }
+    socklen_t addressLength() const;
+    // What a receiving socket binds to: the group itself, which keeps other
+    // traffic to the port off the socket, except on Windows, which can only
+    // bind to local addresses and gets the wildcard.
+    sockaddr_storage bindAddress() const;
+
+    // Joins the group (only the source's traffic, if there is one).
+    bool join(Socket sockfd) const;
+    void leave(Socket sockfd) const;
+    // Sets the TTL, loopback and outgoing interface for sending to the group.
+    bool configureSender(Socket sockfd) const;
+
+private:
+    int level() const { return family() == AF_INET6 ? IPPROTO_IPV6 : IPPROTO_IP; }
+
+    sockaddr_storage group_;
+    sockaddr_storage source_;
+    bool hasSource_;
+    unsigned int interface_; // 0 = the system's choice
+    int ttl_;
+    bool loopback_;
+    bool valid_;
+};
+
+#endif // MULTICAST_GROUP_H
\ No newline at end of file
@@ -0,0 +1,436 @@
+#include "NetworkReactor.h"
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef NETWORK_HAVE_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#elif !defined(_WIN32)
+#include <sys/select.h>
+#include <fcntl.h>
+#endif
+
+#ifndef _WIN32
+static const int INVALID_SOCKET = -1;
+#endif
+
+namespace {
+
+// Datagrams taken from a readable stream per wakeup.
+const size_t BATCH_SIZE = 64;
+#ifdef NETWORK_HAVE_EPOLL
+const int MAX_EVENTS = 64;
+const uint64_t WAKE_EVENT = ~0ull; // epoll data of the eventfd; streams use their id
+#else
+// Without a wakeup descriptor, run() rechecks for stop() this often.
+const int STOP_POLL_MS = 100;
+#endif
+
+void reportSocketError(const char* what) {
+#ifdef _WIN32
+    std::cerr << what << ": " << WSAGetLastError() << "\n";
+#else
+    perror(what);
+#endif
+}
+
+bool wouldBlock() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+} // namespace
+
+NetworkReactor::NetworkReactor(PacketPool& pool)
+    : nextId_(0), stopping_(false), pool_(pool), spare_(BATCH_SIZE), discard_(pool.bufferSize()), dropped_(0) {
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        throw std::runtime_error("WSAStartup failed");
+    }
+#endif
+#ifdef NETWORK_HAVE_EPOLL
+    epollfd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epollfd_ < 0) {
+        throw std::runtime_error(std::string("epoll_create1 failed: ") + strerror(errno));
+    }
+    wakefd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakefd_ < 0) {
+        close(epollfd_);
+        throw std::runtime_error(std::string("eventfd failed: ") + strerror(errno));
+    }
+    epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = WAKE_EVENT;
+    if (epoll_ctl(epollfd_, EPOLL_CTL_ADD, wakefd_, &ev) < 0) {
+        close(wakefd_);
+        close(epollfd_);
+        throw std::runtime_error(std::string("epoll_ctl failed: ") + strerror(errno));
+    }
+#endif
+}
+
+NetworkReactor::~NetworkReactor() {
+    for (auto& entry : streams_) {
+        closeStream(*entry.second);
+    }
+#ifdef NETWORK_HAVE_EPOLL
+    close(wakefd_);
+    close(epollfd_);
+#endif
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+NetworkReactor::Socket NetworkReactor::openSocket(const sockaddr_storage& bindAddr, socklen_t bindLength, bool multicast) {
+    const int family = bindAddr.ss_family;
+#ifdef NETWORK_HAVE_EPOLL
+    Socket sockfd = socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+#else
+    Socket sockfd = socket(family, SOCK_DGRAM, IPPROTO_UDP);
+#endif
+    if (sockfd == INVALID_SOCKET) {
+        reportSocketError("Socket creation failed");
+        return INVALID_SOCKET;
+    }
+
+    bool ok = true;
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ok = ioctlsocket(sockfd, FIONBIO, &nonBlocking) == 0;
+#elif !defined(NETWORK_HAVE_EPOLL)
+    int flags = fcntl(sockfd, F_GETFL, 0);
+    ok = flags >= 0 && fcntl(sockfd, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+    if (!ok) {
+        reportSocketError("Setting non-blocking mode failed");
+    }
+
+    // Lets unicast and multicast streams share a port. POSIX wants the option
+    // on every socket bound to the port; Windows only on the later ones, and
+    // there it would let other processes take over a unicast port.
+    int reuse = 1;
+#ifdef _WIN32
+    if (ok && multicast) {
+#else
+    (void)multicast;
+    if (ok) {
+#endif
+        setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+    }
+#ifdef IP_MULTICAST_ALL
+    // Linux otherwise delivers every group joined by any socket on the host
+    // to every socket on the port, so each packet would reach several streams.
+    int multicastAll = 0;
+    if (family == AF_INET6) {
+#ifdef IPV6_MULTICAST_ALL
+        setsockopt(sockfd, IPPROTO_IPV6, IPV6_MULTICAST_ALL, &multicastAll, sizeof(multicastAll));
+#endif
+    }
+    else {
+        setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_ALL, &multicastAll, sizeof(multicastAll));
+    }
+#endif
+
+    if (ok && bind(sockfd, (const struct sockaddr*)&bindAddr, bindLength) != 0) {
+        reportSocketError("Bind failed");
+        ok = false;
+    }
+
+    if (!ok) {
+#ifdef _WIN32
+        closesocket(sockfd);
+#else
+        close(sockfd);
+#endif
+        return INVALID_SOCKET;
+    }
+    return sockfd;
+}
+
+int NetworkReactor::addUnicast(unsigned short port, PacketHandler handler) {
+    sockaddr_storage any {};
+    sockaddr_in& localAddr = reinterpret_cast<sockaddr_in&>(any);
+    localAddr.sin_family = AF_INET;
+    localAddr.sin_port = htons(port);
+    localAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+    Socket sockfd = openSocket(any, sizeof(sockaddr_in), false);
+    if (sockfd == INVALID_SOCKET) return -1;
+    return addStream(sockfd, std::move(handler), nullptr);
+}
+
+int NetworkReactor::addMulticast(const std::string& multicastGroup, unsigned short port, PacketHandler handler,
+    const MulticastOptions& options) {
+    MulticastGroup group(multicastGroup, port, options);
+    if (!group.valid()) return -1;
+
+    Socket sockfd = openSocket(group.bindAddress(), group.addressLength(), true);
+    if (sockfd == INVALID_SOCKET) return -1;
+
+    if (!group.join(sockfd)) {
+#ifdef _WIN32
+        closesocket(sockfd);
+#else
+        close(sockfd);
+#endif
+        return -1;
+    }
+    return addStream(sockfd, std::move(handler), &group);
+}
+
+int NetworkReactor::addStream(Socket sockfd, PacketHandler handler, const MulticastGroup* multicast) {
+    std::unique_ptr<Stream> stream(new Stream());
+    stream->sockfd = sockfd;
+    stream->handler = std::move(handler);
+    if (multicast) {
+        stream->multicast.reset(new MulticastGroup(*multicast));
+    }
+
+#ifdef _WIN32
+    if (streams_.size() >= FD_SETSIZE) {
+        std::cerr << "NetworkReactor: at most " << FD_SETSIZE << " streams on this platform\n";
+        closeStream(*stream);
+        return -1;
+    }
+#endif
+
+    int id = nextId_++;
+#ifdef NETWORK_HAVE_EPOLL
+    epoll_event ev {};
+    ev.events = EPOLLIN; // Level-triggered: whatever one batch leaves is reported again
+    ev.data.u64 = static_cast<uint64_t>(id);
+    if (epoll_ctl(epollfd_, EPOLL_CTL_ADD, sockfd, &ev) < 0) {
+        perror("epoll_ctl failed");
+        closeStream(*stream);
+        return -1;
+    }
+#endif
+    streams_[id] = std::move(stream);
+    return id;
+}
+
+void NetworkReactor::remove(int streamId) {
+    auto it = streams_.find(streamId);
+    if (it == streams_.end()) return;
+    closeStream(*it->second);
+    // A handler may be removing its own stream, so the Stream outlives this call.
+    removed_.push_back(std::move(it->second));
+    streams_.erase(it);
+}
+
+void NetworkReactor::closeStream(Stream& stream) {
+    if (stream.sockfd == INVALID_SOCKET) return;
+#ifdef NETWORK_HAVE_EPOLL
+    epoll_ctl(epollfd_, EPOLL_CTL_DEL, stream.sockfd, nullptr);
+#endif
+    if (stream.multicast) {
+        stream.multicast->leave(stream.sockfd);
+    }
+#ifdef _WIN32
+    closesocket(stream.sockfd);
+#else
+    close(stream.sockfd);
+#endif
+    stream.sockfd = INVALID_SOCKET;
+}
+
+// Makes the leading spare_ buffers valid and ours alone; returns how many
+// are, 0 if the pool is empty. Those handed out last time were moved from,
+// or are still referenced by what the handler kept (a copy, or slices held
+// in a jitter buffer) and must not be received into again: they are let go,
+// to return to the pool with the last reference, and replaced.
+size_t NetworkReactor::fillSpares() {
+    size_t ready = 0;
+    bool poolEmpty = false;
+    for (size_t i = 0; i < spare_.size(); ++i) {
+        if (spare_[i].valid() && spare_[i].useCount() != 1) {
+            spare_[i] = PacketBuffer();
+        }
+        if (!spare_[i].valid()) {
+            if (poolEmpty) continue;
+            spare_[i] = pool_.acquire();
+            if (!spare_[i].valid()) {
+                poolEmpty = true;
+                continue;
+            }
+        }
+        spare_[i].resize(spare_[i].capacity());
+        spare_[ready++].swap(spare_[i]);
+    }
+    return ready;
+}
+
+size_t NetworkReactor::drain(Stream& stream) {
+    const size_t capacity = fillSpares();
+    if (capacity == 0) {
+        // Read it anyway, or the socket stays readable and run() spins.
+        if (recv(stream.sockfd, (char*)discard_.data(), static_cast<int>(discard_.size()), 0) >= 0) {
+            ++dropped_;
+        }
+        return 0;
+    }
+
+    size_t count = 0;
+#ifdef NETWORK_HAVE_EPOLL
+    if (msgs_.size() < capacity) {
+        msgs_.resize(capacity);
+        iovecs_.resize(capacity);
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+        iovecs_[i].iov_base = spare_[i].data();
+        iovecs_[i].iov_len = spare_[i].size();
+        std::memset(&msgs_[i], 0, sizeof(msgs_[i]));
+        msgs_[i].msg_hdr.msg_iov = &iovecs_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+    int received = recvmmsg(stream.sockfd, msgs_.data(), static_cast<unsigned int>(capacity), MSG_DONTWAIT, nullptr);
+    if (received < 0) {
+        if (!wouldBlock()) {
+            perror("recvmmsg failed");
+        }
+        return 0;
+    }
+    for (int i = 0; i < received; ++i) {
+        if (msgs_[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            ++dropped_; // Larger than a buffer; what arrived is incomplete
+            continue;
+        }
+        spare_[i].resize(msgs_[i].msg_len);
+        spare_[count++].swap(spare_[i]);
+    }
+#else
+    while (count < capacity) {
+#ifdef _WIN32
+        int bytesReceived = recvfrom(stream.sockfd, (char*)spare_[count].data(), static_cast<int>(spare_[count].size()), 0, nullptr, nullptr);
+        if (bytesReceived == SOCKET_ERROR) {
+            // A datagram larger than the slot; it has been dropped, carry on.
+            if (WSAGetLastError() == WSAEMSGSIZE) {
+                ++dropped_;
+                continue;
+            }
+#else
+        // recvmsg() rather than recvfrom(), which truncates without saying so.
+        iovec iov;
+        iov.iov_base = spare_[count].data();
+        iov.iov_len = spare_[count].size();
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        ssize_t bytesReceived = recvmsg(stream.sockfd, &msg, 0);
+        if (bytesReceived < 0) {
+#endif
+            if (!wouldBlock()) {
+                reportSocketError("recvfrom failed");
+            }
+            break;
+        }
+#ifndef _WIN32
+        if (msg.msg_flags & MSG_TRUNC) {
+            ++dropped_;
+            continue;
+        }
+#endif
+        spare_[count++].resize(static_cast<size_t>(bytesReceived));
+    }
+#endif
+
+    for (size_t i = 0; i < count && stream.sockfd != INVALID_SOCKET; ++i) {
+        stream.handler(std::move(spare_[i])); // If not taken, it stays a spare
+    }
+    return count;
+}
+
+size_t NetworkReactor::runOnce(int timeoutMs) {
+    ready_.clear();
+#ifdef NETWORK_HAVE_EPOLL
+    epoll_event events[MAX_EVENTS];
+    int n = epoll_wait(epollfd_, events, MAX_EVENTS, timeoutMs);
+    if (n < 0) {
+        if (errno != EINTR) {
+            perror("epoll_wait failed");
+        }
+        return 0;
+    }
+    for (int i = 0; i < n; ++i) {
+        if (events[i].data.u64 == WAKE_EVENT) {
+            uint64_t value;
+            while (read(wakefd_, &value, sizeof(value)) > 0) {}
+        }
+        else {
+            ready_.push_back(static_cast<int>(events[i].data.u64));
+        }
+    }
+#else
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    Socket maxfd = 0;
+    for (auto& entry : streams_) {
+        FD_SET(entry.second->sockfd, &readSet);
+        if (entry.second->sockfd > maxfd) maxfd = entry.second->sockfd;
+    }
+    timeval timeout;
+    timeval* timeoutArg = nullptr;
+    if (timeoutMs >= 0) {
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_usec = (timeoutMs % 1000) * 1000;
+        timeoutArg = &timeout;
+    }
+#ifdef _WIN32
+    if (streams_.empty()) {
+        // Windows select() fails on empty sets instead of waiting.
+        Sleep(timeoutMs >= 0 ? timeoutMs : STOP_POLL_MS);
+        return 0;
+    }
+#endif
+    int n = select(static_cast<int>(maxfd) + 1, &readSet, nullptr, nullptr, timeoutArg);
+    if (n < 0) {
+        if (!wouldBlock()) {
+            reportSocketError("select failed");
+        }
+        return 0;
+    }
+    for (auto& entry : streams_) {
+        if (FD_ISSET(entry.second->sockfd, &readSet)) {
+            ready_.push_back(entry.first);
+        }
+    }
+#endif
+
+    size_t handled = 0;
+    for (int id : ready_) {
+        auto it = streams_.find(id);
+        if (it != streams_.end()) {
+            handled += drain(*it->second);
+        }
+    }
+    removed_.clear();
+    return handled;
+}
+
+void NetworkReactor::run() {
+    while (!stopping_) {
+#ifdef NETWORK_HAVE_EPOLL
+        runOnce(-1);
+#else
+        runOnce(STOP_POLL_MS);
+#endif
+    }
+    stopping_ = false;
+}
+
+void NetworkReactor::stop() {
+    stopping_ = true;
+#ifdef NETWORK_HAVE_EPOLL
+    uint64_t one = 1;
+    if (write(wakefd_, &one, sizeof(one)) < 0) {
+        perror("eventfd write failed");
+    }
+#endif
+}
\ No newline at end of file
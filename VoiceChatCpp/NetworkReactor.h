@@ -0,0 +1,110 @@
+#ifndef NETWORK_REACTOR_H
+#define NETWORK_REACTOR_H
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#ifdef __linux__
+#define NETWORK_HAVE_EPOLL // epoll, eventfd and recvmmsg
+#endif
+#endif
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MulticastGroup.h"
+#include "PacketBuffer.h"
+
+// One thread serving any number of UDP sockets, unicast ports and multicast
+// groups alike, in place of a blocking NetworkReceiver and a thread per
+// socket. Every socket is non-blocking; run() waits on all of them at once
+// (epoll on Linux, select() elsewhere) and hands each datagram to the handler
+// of the stream it arrived on, received straight into a buffer from a
+// PacketPool that the handler then owns.
+//
+// Streams are added and removed before run(), or on its thread from inside a
+// handler. Only stop() may be called from other threads.
+class NetworkReactor {
+public:
+    // Called on the reactor thread with each datagram; the handler may keep
+    // the buffer (move from it) or copies and slices of it. A buffer is only
+    // received into again once nothing else refers to it.
+    typedef std::function<void(PacketBuffer&& packet)> PacketHandler;
+
+    // Throws std::runtime_error if the poller can't be created. pool must
+    // outlive the reactor.
+    explicit NetworkReactor(PacketPool& pool);
+    ~NetworkReactor();
+
+    NetworkReactor(const NetworkReactor&) = delete;
+    NetworkReactor& operator=(const NetworkReactor&) = delete;
+
+    // Listens on a port on all interfaces, or joins an IPv4 or IPv6
+    // multicastGroup on it (see MulticastOptions for source-specific joins).
+    // Returns the stream's id for remove(), or -1 (after printing why) if
+    // the socket can't be set up. Several streams may share a port.
+    int addUnicast(unsigned short port, PacketHandler handler);
+    int addMulticast(const std::string& multicastGroup, unsigned short port, PacketHandler handler,
+        const MulticastOptions& options = MulticastOptions());
+    void remove(int streamId);
+    size_t streamCount() const { return streams_.size(); }
+    // Datagrams thrown away because the pool had no free buffer, or because
+    // they were larger than one.
+    uint64_t droppedCount() const { return dropped_; }
+
+    // Dispatches packets until stop().
+    void run();
+    // Waits up to timeoutMs (-1 = indefinitely) for any stream to become
+    // readable, then takes up to one batch from each readable stream, so a
+    // flooded stream can't starve the others. Returns the packets handled.
+    size_t runOnce(int timeoutMs);
+    // Makes run() return once the current dispatch finishes.
+    void stop();
+
+private:
+#ifdef _WIN32
+    typedef SOCKET Socket;
+#else
+    typedef int Socket;
+#endif
+
+    struct Stream {
+        Socket sockfd;
+        PacketHandler handler;
+        std::unique_ptr<MulticastGroup> multicast; // Null for unicast streams
+    };
+
+    Socket openSocket(const sockaddr_storage& bindAddr, socklen_t bindLength, bool multicast);
+    int addStream(Socket sockfd, PacketHandler handler, const MulticastGroup* multicast);
+    void closeStream(Stream& stream);
+    size_t drain(Stream& stream);
+    size_t fillSpares();
+
+    std::map<int, std::unique_ptr<Stream>> streams_;
+    std::vector<std::unique_ptr<Stream>> removed_; // Kept until the dispatch that removed them ends
+    std::vector<int> ready_; // Ids, not pointers or iterators: handlers may add and remove streams
+    int nextId_;
+    std::atomic<bool> stopping_;
+    PacketPool& pool_;
+    std::vector<PacketBuffer> spare_;     // Acquired ahead for the next batch, any stream's
+    std::vector<unsigned char> discard_;  // Where datagrams go when the pool is empty
+    uint64_t dropped_;
+#ifdef NETWORK_HAVE_EPOLL
+    int epollfd_;
+    int wakefd_; // eventfd that stop() signals
+    std::vector<mmsghdr> msgs_;
+    std::vector<iovec> iovecs_;
+#endif
+};
+
+#endif // NETWORK_REACTOR_H
\ No newline at end of file
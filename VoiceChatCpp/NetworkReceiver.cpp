@@ -1,4 +1,5 @@
 #include "NetworkReceiver.h"
+#include <cstring>
 
 NetworkReceiver::NetworkReceiver(unsigned short listenPort) : listenPort_(listenPort), initialized(false), running(false) {
 #ifdef _WIN32
@@ -97,4 +98,58 @@ std::vector<unsigned char> NetworkReceiver::receivePacketBlocking() {
 #endif
     buffer.resize(bytesReceived);
     return buffer;
+}
+
+size_t NetworkReceiver::receiveBatch(PacketBatch& batch) {
+    batch.clear();
+    if (!running) return 0;
+
+#ifdef NETWORK_HAVE_MMSG
+    const size_t capacity = batch.capacity();
+    if (msgs_.size() < capacity) {
+        msgs_.resize(capacity);
+        iovecs_.resize(capacity);
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+        iovecs_[i].iov_base = batch.slot(i);
+        iovecs_[i].iov_len = PacketBatch::MAX_PACKET_SIZE;
+        std::memset(&msgs_[i], 0, sizeof(msgs_[i]));
+        msgs_[i].msg_hdr.msg_iov = &iovecs_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+    // MSG_WAITFORONE only blocks for the first datagram.
+    int received = recvmmsg(sockfd, msgs_.data(), static_cast<unsigned int>(capacity), MSG_WAITFORONE, nullptr);
+    if (received < 0) {
+        if (running) {
+            perror("recvmmsg failed");
+        }
+        return 0;
+    }
+    for (int i = 0; i < received; ++i) {
+        batch.setLength(i, msgs_[i].msg_len);
+    }
+    batch.setReceived(received);
+    return received;
+#else
+#ifdef _WIN32
+    int bytesReceived = recvfrom(sockfd, (char*)batch.slot(0), static_cast<int>(PacketBatch::MAX_PACKET_SIZE), 0, nullptr, nullptr);
+    if (bytesReceived == SOCKET_ERROR) {
+        if (running) {
+            std::cerr << "recvfrom failed: " << WSAGetLastError() << "\n";
+        }
+        return 0;
+    }
+#else
+    ssize_t bytesReceived = recvfrom(sockfd, batch.slot(0), PacketBatch::MAX_PACKET_SIZE, 0, nullptr, nullptr);
+    if (bytesReceived < 0) {
+        if (running) {
+            perror("recvfrom failed");
+        }
+        return 0;
+    }
+#endif
+    batch.setLength(0, static_cast<size_t>(bytesReceived));
+    batch.setReceived(1);
+    return 1;
+#endif
 }
\ No newline at end of file
@@ -12,12 +12,16 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#ifdef __linux__
+#define NETWORK_HAVE_MMSG // recvmmsg/sendmmsg
+#endif
 #endif
 
 #include <vector>
 #include <string>
 #include <iostream>
 #include <stdexcept> // For std::runtime_error etc.
+#include "PacketBatch.h"
 
 class NetworkReceiver {
 public:
@@ -27,6 +31,12 @@ public:
     void stop();
     std::vector<unsigned char> receivePacketBlocking();
 
+    // Blocks until a datagram arrives, then also takes those already queued
+    // behind it, up to batch.capacity(), in place of the batch's contents.
+    // Returns how many were received, 0 on error. One recvmmsg on Linux; one
+    // recvfrom (so one datagram) per call elsewhere.
+    size_t receiveBatch(PacketBatch& batch);
+
 private:
 #ifdef _WIN32
     SOCKET sockfd;
@@ -36,6 +46,10 @@ private:
     unsigned short listenPort_;
     bool initialized;
     bool running;
+#ifdef NETWORK_HAVE_MMSG
+    std::vector<mmsghdr> msgs_; // Grown to the largest batch, then reused
+    std::vector<iovec> iovecs_;
+#endif
 };
 
 #endif // NETWORK_RECEIVER_H
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "NetworkReceiverMulticast.h"
-#include <Ws2tcpip.h> // Add this include for InetPton
 
-NetworkReceiverMulticast::NetworkReceiverMulticast(const std::string& multicastGroup, unsigned short port) : initialized(false) {
+NetworkReceiverMulticast::NetworkReceiverMulticast(const std::string& multicastGroup, unsigned short port,
+    const MulticastOptions& options) : initialized(false), group(multicastGroup, port, options) {
 #ifdef _WIN32
     WSADATA wsaData;
 
@@ -10,37 +10,59 @@ NetworkReceiverMulticast::NetworkReceiverMulticast(const std::string& multicastG
         return;
     }
 #endif
-        
-    sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (!group.valid()) {
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return;
+    }
+
+    sockfd = socket(group.family(), SOCK_DGRAM, 0);
+#ifdef _WIN32
+    if (sockfd == INVALID_SOCKET) {
+        std::cerr << "Socket creation failed: " << WSAGetLastError() << "\n";
+        WSACleanup();
+        return;
+    }
+#else
     if (sockfd < 0) {
         perror("Socket creation failed");
         return;
     }
+#endif
 
     // Reuse address
     int reuse = 1;
     setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, (char*)&reuse, sizeof(reuse));
-
-    localAddr.sin_family = AF_INET;
-    localAddr.sin_port = htons(port);
-    localAddr.sin_addr.s_addr = INADDR_ANY;
-
-    if (bind(sockfd, (struct sockaddr*)&localAddr, sizeof(localAddr)) < 0) {
-        perror("Bind failed");
-        return;
+#ifdef IP_MULTICAST_ALL
+    // Otherwise Linux delivers every group any socket on the host joined on this port.
+    int multicastAll = 0;
+    if (group.family() == AF_INET6) {
+#ifdef IPV6_MULTICAST_ALL
+        setsockopt(sockfd, IPPROTO_IPV6, IPV6_MULTICAST_ALL, &multicastAll, sizeof(multicastAll));
+#endif
     }
-
-    // Join multicast group
-    struct in_addr addr;
-    if (InetPtonA(AF_INET, multicastGroup.c_str(), &addr) != 1) {
-        std::cerr << "Invalid multicast address.\n";
-        return;
+    else {
+        setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_ALL, &multicastAll, sizeof(multicastAll));
     }
-    multicastReq.imr_multiaddr.s_addr = addr.s_addr;
-    multicastReq.imr_interface.s_addr = htonl(INADDR_ANY);
+#endif
 
-    if (setsockopt(sockfd, IPPROTO_IP, IP_ADD_MEMBERSHIP, (char*)&multicastReq, sizeof(multicastReq)) < 0) {
-        perror("Multicast join failed");
+    sockaddr_storage localAddr = group.bindAddress();
+    bool ok = bind(sockfd, (struct sockaddr*)&localAddr, group.addressLength()) == 0;
+    if (!ok) {
+#ifdef _WIN32
+        std::cerr << "Bind failed: " << WSAGetLastError() << "\n";
+#else
+        perror("Bind failed");
+#endif
+    }
+    if (!ok || !group.join(sockfd)) {
+#ifdef _WIN32
+        closesocket(sockfd);
+        WSACleanup();
+#else
+        close(sockfd);
+#endif
         return;
     }
 
@@ -49,7 +71,7 @@ NetworkReceiverMulticast::NetworkReceiverMulticast(const std::string& multicastG
 
 NetworkReceiverMulticast::~NetworkReceiverMulticast() {
     if (initialized) {
-        setsockopt(sockfd, IPPROTO_IP, IP_DROP_MEMBERSHIP, (char*)&multicastReq, sizeof(multicastReq));
+        group.leave(sockfd);
 #ifdef _WIN32
         closesocket(sockfd);
         WSACleanup();
@@ -63,18 +85,19 @@ bool NetworkReceiverMulticast::receivePacket(std::vector<unsigned char>& data) {
     if (!initialized) return false;
 
     unsigned char buffer[4096];
-    struct sockaddr_in senderAddr {};
 #ifdef _WIN32
-    int addrLen = sizeof(senderAddr);
+    int bytesRead = recvfrom(sockfd, reinterpret_cast<char*>(buffer), sizeof(buffer), 0, nullptr, nullptr);
+    if (bytesRead == SOCKET_ERROR) {
+        std::cerr << "recvfrom failed: " << WSAGetLastError() << "\n";
+        return false;
+    }
 #else
-    socklen_t addrLen = sizeof(senderAddr);
-#endif
-
-    ssize_t bytesRead = recvfrom(sockfd, reinterpret_cast<char*>(buffer), sizeof(buffer), 0, (struct sockaddr*)&senderAddr, &addrLen);
+    ssize_t bytesRead = recvfrom(sockfd, buffer, sizeof(buffer), 0, nullptr, nullptr);
     if (bytesRead < 0) {
         perror("recvfrom failed");
         return false;
     }
+#endif
 
     data.assign(buffer, buffer + bytesRead);
     return true;
@@ -10,8 +10,6 @@
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #pragma comment(lib, "Ws2_32.lib")
-typedef int socklen_t;
-typedef SSIZE_T ssize_t;
 #else
 #include <unistd.h>
 #include <sys/socket.h>
@@ -21,12 +19,15 @@ typedef SSIZE_T ssize_t;
 #include <errno.h>
 #endif
 
+#include "MulticastGroup.h"
 
 
-
+// Receives from one IPv4 or IPv6 multicast group; see MulticastOptions for
+// source-specific joins and picking the interface.
 class NetworkReceiverMulticast {
 public:
-    NetworkReceiverMulticast(const std::string& multicastGroup, unsigned short port);
+    NetworkReceiverMulticast(const std::string& multicastGroup, unsigned short port,
+        const MulticastOptions& options = MulticastOptions());
     ~NetworkReceiverMulticast();
     bool receivePacket(std::vector<unsigned char>& data);
 
@@ -37,6 +38,5 @@ private:
         int sockfd;
     #endif
     bool initialized;
-    struct sockaddr_in localAddr {};
-    struct ip_mreq multicastReq {};
+    MulticastGroup group;
 };
@@ -1,4 +1,5 @@
 #include "NetworkSender.h"
+#include <cstring>
 
 NetworkSender::NetworkSender(const std::string& targetIp, unsigned short targetPort) : initialized(false) {
 #ifdef _WIN32
@@ -45,8 +46,7 @@ NetworkSender::~NetworkSender() {
 bool NetworkSender::sendPacket(const std::vector<unsigned char>& data) {
     if (!initialized) return false;
 
-    // For simplicity, directly send the raw data.
-    // In a real system, you'd add RTP headers here or at the encoding stage.
+    // data is a complete datagram; RTP framing is done by RtpPacketizer.
 #ifdef _WIN32
     int bytesSent = sendto(sockfd, (const char*)data.data(), static_cast<int>(data.size()), 0,
         (SOCKADDR*)&serverAddr, sizeof(serverAddr));
@@ -63,4 +63,92 @@ bool NetworkSender::sendPacket(const std::vector<unsigned char>& data) {
     }
 #endif
     return (size_t)bytesSent == data.size();
-}
\ No newline at end of file
+}
+
+size_t NetworkSender::sendBatch(const PacketBatch& batch) {
+    if (!initialized) return 0;
+
+    const size_t count = batch.size();
+#ifdef NETWORK_HAVE_MMSG
+    for (size_t i = 0; i < count; ++i) {
+        setMessage(i, batch.data(i), batch.length(i));
+    }
+    return sendMessages(count);
+#else
+    size_t sent = 0;
+    while (sent < count && sendOne(batch.data(sent), batch.length(sent))) {
+        ++sent;
+    }
+    return sent;
+#endif
+}
+
+size_t NetworkSender::sendBatch(const PacketBuffer* packets, size_t count) {
+    if (!initialized) return 0;
+
+#ifdef NETWORK_HAVE_MMSG
+    for (size_t i = 0; i < count; ++i) {
+        setMessage(i, packets[i].data(), packets[i].size());
+    }
+    return sendMessages(count);
+#else
+    size_t sent = 0;
+    while (sent < count && sendOne(packets[sent].data(), packets[sent].size())) {
+        ++sent;
+    }
+    return sent;
+#endif
+}
+
+#ifdef NETWORK_HAVE_MMSG
+void NetworkSender::setMessage(size_t i, const unsigned char* data, size_t length) {
+    if (iovecs_.size() <= i) {
+        iovecs_.resize(i + 1);
+    }
+    iovecs_[i].iov_base = const_cast<unsigned char*>(data);
+    iovecs_[i].iov_len = length;
+}
+
+// Sends the first count datagrams given to setMessage().
+size_t NetworkSender::sendMessages(size_t count) {
+    if (msgs_.size() < count) {
+        msgs_.resize(count);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        std::memset(&msgs_[i], 0, sizeof(msgs_[i]));
+        msgs_[i].msg_hdr.msg_name = &serverAddr;
+        msgs_[i].msg_hdr.msg_namelen = sizeof(serverAddr);
+        msgs_[i].msg_hdr.msg_iov = &iovecs_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+    size_t sent = 0;
+    while (sent < count) {
+        int n = sendmmsg(sockfd, msgs_.data() + sent, static_cast<unsigned int>(count - sent), 0);
+        if (n < 0) {
+            perror("sendmmsg failed");
+            break;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return sent;
+}
+#else
+bool NetworkSender::sendOne(const unsigned char* data, size_t length) {
+#ifdef _WIN32
+    int bytesSent = sendto(sockfd, (const char*)data, static_cast<int>(length), 0,
+        (SOCKADDR*)&serverAddr, sizeof(serverAddr));
+    if (bytesSent == SOCKET_ERROR) {
+        std::cerr << "sendto failed: " << WSAGetLastError() << "\n";
+        return false;
+    }
+#else
+    ssize_t bytesSent = sendto(sockfd, data, length, 0,
+        (struct sockaddr*)&serverAddr, sizeof(serverAddr));
+    if (bytesSent < 0) {
+        perror("sendto failed");
+        return false;
+    }
+#endif
+    return true;
+}
+#endif
\ No newline at end of file
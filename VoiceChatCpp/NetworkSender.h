@@ -14,12 +14,17 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#ifdef __linux__
+#define NETWORK_HAVE_MMSG // recvmmsg/sendmmsg
+#endif
 #endif
 
 #include <vector>
 #include <string>
 #include <iostream>
 #include <stdexcept> // For std::runtime_error etc.
+#include "PacketBatch.h"
+#include "PacketBuffer.h"
 
 
 
@@ -29,7 +34,21 @@ public:
     ~NetworkSender();
     bool sendPacket(const std::vector<unsigned char>& data);
 
+    // Sends every packet in the batch, in order: one sendmmsg on Linux (more if
+    // the kernel takes part of it), one sendto per packet elsewhere. Returns
+    // how many were sent; stops at the first failure.
+    size_t sendBatch(const PacketBatch& batch);
+    // The same, straight from pooled buffers, without copying them into a batch.
+    size_t sendBatch(const PacketBuffer* packets, size_t count);
+
 private:
+#ifdef NETWORK_HAVE_MMSG
+    void setMessage(size_t i, const unsigned char* data, size_t length);
+    size_t sendMessages(size_t count);
+#else
+    bool sendOne(const unsigned char* data, size_t length);
+#endif
+
 #ifdef _WIN32
     SOCKET sockfd;
     SOCKADDR_IN serverAddr;
@@ -40,6 +59,10 @@ private:
     sockaddr_in serverAddr;
 #endif
     bool initialized;
+#ifdef NETWORK_HAVE_MMSG
+    std::vector<mmsghdr> msgs_; // Grown to the largest batch, then reused
+    std::vector<iovec> iovecs_;
+#endif
 };
 
 #endif // NETWORK_SENDER_H
\ No newline at end of file
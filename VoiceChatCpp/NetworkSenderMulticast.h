@@ -3,26 +3,35 @@
 #include <string>
 #ifdef _WIN32
 #include <winsock2.h>
+#include <ws2tcpip.h>
 #else
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #endif
 #include <iostream>
-#include <ws2tcpip.h>
+#include "MulticastGroup.h"
+#include "PacketBuffer.h"
 
+// Sends to one IPv4 or IPv6 multicast group with the TTL, loopback and
+// interface from MulticastOptions.
 class NetworkSenderMulticast {
 public:
-    NetworkSenderMulticast(const std::string& multicastIp, unsigned short multicastPort);
+    NetworkSenderMulticast(const std::string& multicastIp, unsigned short multicastPort,
+        const MulticastOptions& options = MulticastOptions());
     ~NetworkSenderMulticast();
     bool sendPacket(const std::vector<unsigned char>& data);
+    // As NetworkSender::sendBatch(), one sendto per packet.
+    size_t sendBatch(const PacketBuffer* packets, size_t count);
 
 private:
+    bool sendOne(const unsigned char* data, size_t length);
+
     #ifdef _WIN32
         SOCKET sockfd ;
     #else
         int sockfd;
     #endif
-    struct sockaddr_in multicastAddr;
+    MulticastGroup group;
     bool initialized;
 };
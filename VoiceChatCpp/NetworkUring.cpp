@@ -0,0 +1,533 @@
+#include "NetworkUring.h"
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+// Built against the kernel's own header and raw syscalls, so there is no
+// liburing to install. Headers from before multishot receive (6.0, which
+// also has buffer rings) get the fallback.
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#ifdef IORING_RECV_MULTISHOT
+#define NETWORK_HAVE_URING
+#endif
+#endif
+#endif
+
+#ifdef NETWORK_HAVE_URING
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+namespace {
+
+const unsigned SQ_ENTRIES = 64;        // One PacketBatch of sends
+const unsigned RECV_CQ_ENTRIES = 4096; // Room for a burst of receive completions
+const unsigned RECV_BUFFERS = 1024;    // Buffers in the receive ring; a power of two
+const unsigned short BUFFER_GROUP = 0;
+const uint64_t RECV_TAG = ~0ull;
+const uint64_t WAKE_TAG = ~0ull - 1;
+
+int uringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uringEnter(int ringfd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ringfd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int uringRegister(int ringfd, unsigned opcode, void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, ringfd, opcode, arg, count));
+}
+
+} // namespace
+
+struct UringContext {
+    int ringfd = -1;
+    int sockfd = -1;
+    int wakefd = -1; // Receiver only: eventfd that stop() signals
+    unsigned sqEntries = 0;
+
+    void* sqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    void* cqRing = MAP_FAILED;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqLocalTail = 0; // Published to *sqTail by submit()
+    unsigned pending = 0;     // Queued but not yet taken by the kernel
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    // Receiver only: the provided buffer ring and the buffers it hands out.
+    io_uring_buf_ring* bufRing = static_cast<io_uring_buf_ring*>(MAP_FAILED);
+    size_t bufRingSize = 0;
+    unsigned char* buffers = static_cast<unsigned char*>(MAP_FAILED);
+    size_t buffersSize = 0;
+    unsigned short bufTail = 0;
+    bool received = false; // Whether multishot receive has ever worked
+
+    ~UringContext() {
+        if (ringfd >= 0) close(ringfd); // Cancels the armed receive
+        if (sockfd >= 0) close(sockfd);
+        if (wakefd >= 0) close(wakefd);
+        if (bufRing != MAP_FAILED) munmap(bufRing, bufRingSize);
+        if (buffers != MAP_FAILED) munmap(buffers, buffersSize);
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED) munmap(sqRing, sqRingSize);
+    }
+
+    bool init(unsigned cqEntries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = cqEntries;
+#ifdef IORING_SETUP_COOP_TASKRUN
+        // Completions are only reaped by the thread that submits, so the
+        // kernel needn't interrupt it to post them.
+        params.flags |= IORING_SETUP_COOP_TASKRUN;
+#endif
+        ringfd = uringSetup(SQ_ENTRIES, &params);
+        if (ringfd < 0 && errno == EINVAL) {
+            std::memset(&params, 0, sizeof(params)); // Before 5.19
+            params.flags = IORING_SETUP_CQSIZE;
+            params.cq_entries = cqEntries;
+            ringfd = uringSetup(SQ_ENTRIES, &params);
+        }
+        if (ringfd < 0) {
+            return false;
+        }
+
+        sqEntries = params.sq_entries;
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) return false;
+        if (singleMmap) {
+            cqRing = sqRing;
+        }
+        else {
+            cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) return false;
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringfd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) return false;
+
+        unsigned char* sq = static_cast<unsigned char*>(sqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sqLocalTail = *sqTail;
+        unsigned char* cq = static_cast<unsigned char*>(cqRing);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // Null if the submission queue is full.
+    io_uring_sqe* getSqe() {
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (sqLocalTail - head >= sqEntries) return nullptr;
+        unsigned index = sqLocalTail & sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqArray[index] = index;
+        ++sqLocalTail;
+        ++pending;
+        return sqe;
+    }
+
+    // Hands the kernel what getSqe() queued and waits for at least waitFor
+    // completions. -1 with errno on failure.
+    int submit(unsigned waitFor) {
+        __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+        int ret = uringEnter(ringfd, pending, waitFor, waitFor > 0 ? IORING_ENTER_GETEVENTS : 0);
+        if (ret >= 0) {
+            pending -= std::min(pending, static_cast<unsigned>(ret));
+        }
+        return ret;
+    }
+
+    // The oldest completion, read without a syscall; null if there is none.
+    io_uring_cqe* peek() {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) return nullptr;
+        return &cqes[head & cqMask];
+    }
+
+    void advance() {
+        __atomic_store_n(cqHead, *cqHead + 1, __ATOMIC_RELEASE);
+    }
+
+    bool setupBufferRing() {
+        bufRingSize = RECV_BUFFERS * sizeof(io_uring_buf);
+        bufRing = static_cast<io_uring_buf_ring*>(mmap(nullptr, bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        buffersSize = RECV_BUFFERS * PacketBatch::MAX_PACKET_SIZE;
+        buffers = static_cast<unsigned char*>(mmap(nullptr, buffersSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (bufRing == MAP_FAILED || buffers == MAP_FAILED) return false;
+
+        io_uring_buf_reg reg;
+        std::memset(&reg, 0, sizeof(reg));
+        reg.ring_addr = reinterpret_cast<uint64_t>(bufRing);
+        reg.ring_entries = RECV_BUFFERS;
+        reg.bgid = BUFFER_GROUP;
+        if (uringRegister(ringfd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) return false;
+
+        for (unsigned i = 0; i < RECV_BUFFERS; ++i) {
+            recycle(static_cast<unsigned short>(i));
+        }
+        return true;
+    }
+
+    unsigned char* buffer(unsigned short bid) {
+        return buffers + static_cast<size_t>(bid) * PacketBatch::MAX_PACKET_SIZE;
+    }
+
+    // Gives a buffer back to the kernel for the next datagram.
+    void recycle(unsigned short bid) {
+        // Not bufRing->bufs: compiled as C++, the header's flexible array
+        // starts 8 bytes in. Only the addr/len/bid fields, as the first
+        // entry's reserved field is the tail.
+        io_uring_buf* buf = reinterpret_cast<io_uring_buf*>(bufRing) + (bufTail & (RECV_BUFFERS - 1));
+        buf->addr = reinterpret_cast<uint64_t>(buffer(bid));
+        buf->len = PacketBatch::MAX_PACKET_SIZE;
+        buf->bid = bid;
+        ++bufTail;
+        __atomic_store_n(&bufRing->tail, bufTail, __ATOMIC_RELEASE);
+    }
+
+    // One receive that keeps posting a completion per datagram until it
+    // runs out of buffers.
+    bool armReceive() {
+        io_uring_sqe* sqe = getSqe();
+        if (!sqe) return false;
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = sockfd;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUFFER_GROUP;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->user_data = RECV_TAG;
+        return submit(0) >= 0;
+    }
+
+    // A poll on wakefd beside the receive, so that a thread waiting in
+    // submit() also wakes when stop() signals it. Only the receiving thread
+    // touches the submission queue; stop() just writes the eventfd.
+    bool armWake() {
+        io_uring_sqe* sqe = getSqe();
+        if (!sqe) return false;
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = wakefd;
+        sqe->poll32_events = POLLIN;
+        sqe->user_data = WAKE_TAG;
+        return submit(0) >= 0;
+    }
+};
+
+#else
+
+struct UringContext {};
+
+#endif
+
+NetworkReceiverUring::NetworkReceiverUring(unsigned short listenPort) : listenPort_(listenPort), running_(false) {
+#ifdef NETWORK_HAVE_URING
+    ring_.reset(new UringContext());
+    if (!ring_->init(RECV_CQ_ENTRIES)) {
+        useFallback();
+    }
+#else
+    useFallback();
+#endif
+}
+
+NetworkReceiverUring::~NetworkReceiverUring() {
+    stop();
+}
+
+void NetworkReceiverUring::useFallback() {
+    if (ring_) {
+        std::cerr << "io_uring unavailable (" << strerror(errno) << "), receiving with NetworkReceiver.\n";
+        ring_.reset();
+    }
+    if (!fallback_) {
+        fallback_.reset(new NetworkReceiver(listenPort_));
+    }
+}
+
+bool NetworkReceiverUring::startUring() {
+#ifdef NETWORK_HAVE_URING
+    ring_->sockfd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (ring_->sockfd < 0) {
+        return false;
+    }
+    sockaddr_in serverAddr {};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_addr.s_addr = INADDR_ANY;
+    serverAddr.sin_port = htons(listenPort_);
+    if (bind(ring_->sockfd, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+        return false;
+    }
+    ring_->wakefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (ring_->wakefd < 0) {
+        return false;
+    }
+    return ring_->setupBufferRing() && ring_->armReceive() && ring_->armWake();
+#else
+    return false;
+#endif
+}
+
+bool NetworkReceiverUring::start() {
+    if (running_) return true;
+    if (ring_ && !startUring()) {
+        useFallback(); // Frees the socket for NetworkReceiver to bind
+    }
+    running_ = ring_ ? true : fallback_->start();
+    return running_;
+}
+
+void NetworkReceiverUring::stop() {
+    running_ = false;
+#ifdef NETWORK_HAVE_URING
+    if (ring_ && ring_->wakefd >= 0) {
+        uint64_t one = 1;
+        if (write(ring_->wakefd, &one, sizeof(one)) < 0) {
+            perror("eventfd write failed");
+        }
+    }
+#endif
+    if (fallback_) {
+        fallback_->stop();
+    }
+}
+
+size_t NetworkReceiverUring::receive(const PacketHandler& handler, size_t maxPackets) {
+    if (!running_ || maxPackets == 0) return 0;
+
+    if (!ring_) {
+        if (fallbackBatch_.capacity() != maxPackets) {
+            fallbackBatch_ = PacketBatch(maxPackets);
+        }
+        size_t count = fallback_->receiveBatch(fallbackBatch_);
+        for (size_t i = 0; i < count; ++i) {
+            handler(fallbackBatch_.data(i), fallbackBatch_.length(i));
+        }
+        return count;
+    }
+
+#ifdef NETWORK_HAVE_URING
+    size_t count = 0;
+    while (count < maxPackets) {
+        io_uring_cqe* cqe = ring_->peek();
+        if (!cqe) {
+            if (count > 0 || !running_) break;
+            // Nothing received yet: sleep in the kernel until something is,
+            // or stop() is called.
+            if (ring_->submit(1) < 0 && errno != EINTR) {
+                perror("io_uring_enter failed");
+                return 0;
+            }
+            continue;
+        }
+        int res = cqe->res;
+        unsigned flags = cqe->flags;
+        uint64_t tag = cqe->user_data;
+        ring_->advance();
+
+        if (tag == WAKE_TAG) {
+            uint64_t value;
+            if (read(ring_->wakefd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                perror("eventfd read failed");
+            }
+            if (!ring_->armWake()) {
+                perror("io_uring wakeup re-arm failed");
+            }
+            continue;
+        }
+
+        if (flags & IORING_CQE_F_BUFFER) {
+            unsigned short bid = static_cast<unsigned short>(flags >> IORING_CQE_BUFFER_SHIFT);
+            if (res >= 0) {
+                ring_->received = true;
+                handler(ring_->buffer(bid), static_cast<size_t>(res));
+                ++count;
+            }
+            ring_->recycle(bid);
+        }
+        else if (res == -EINVAL && !ring_->received) {
+            // The kernel has buffer rings but not multishot receive.
+            errno = EINVAL;
+            useFallback();
+            return fallback_->start() ? receive(handler, maxPackets) : 0;
+        }
+        else if (res < 0 && res != -ENOBUFS) { // Out of buffers just ends the multishot
+            std::cerr << "io_uring receive failed: " << strerror(-res) << "\n";
+        }
+
+        if (!(flags & IORING_CQE_F_MORE) && !ring_->armReceive()) {
+            perror("io_uring receive re-arm failed");
+            return count;
+        }
+    }
+    return count;
+#else
+    return 0;
+#endif
+}
+
+size_t NetworkReceiverUring::receiveBatch(PacketBatch& batch) {
+    batch.clear();
+    if (!ring_) {
+        return running_ ? fallback_->receiveBatch(batch) : 0;
+    }
+    size_t count = receive([&batch](const unsigned char* data, size_t length) {
+        batch.append(data, length);
+    }, batch.capacity());
+    return count;
+}
+
+std::vector<unsigned char> NetworkReceiverUring::receivePacketBlocking() {
+    if (!ring_) {
+        return running_ ? fallback_->receivePacketBlocking() : std::vector<unsigned char>();
+    }
+    std::vector<unsigned char> packet;
+    receive([&packet](const unsigned char* data, size_t length) {
+        packet.assign(data, data + length);
+    }, 1);
+    return packet;
+}
+
+NetworkSenderUring::NetworkSenderUring(const std::string& targetIp, unsigned short targetPort) {
+#ifdef NETWORK_HAVE_URING
+    // A connected socket, so a plain fixed-buffer write sends a datagram to
+    // the target (sendmsg can't use registered buffers).
+    bool ok = false;
+    ring_.reset(new UringContext());
+    if (ring_->init(SQ_ENTRIES * 2)) {
+        sockaddr_in serverAddr {};
+        serverAddr.sin_family = AF_INET;
+        serverAddr.sin_port = htons(targetPort);
+        ring_->sockfd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        iovec registered;
+        registered.iov_base = batch_.slot(0);
+        registered.iov_len = batch_.capacity() * PacketBatch::MAX_PACKET_SIZE;
+        ok = ring_->sockfd >= 0 &&
+            inet_pton(AF_INET, targetIp.c_str(), &serverAddr.sin_addr) == 1 &&
+            connect(ring_->sockfd, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) == 0 &&
+            uringRegister(ring_->ringfd, IORING_REGISTER_BUFFERS, &registered, 1) == 0;
+    }
+    if (!ok) {
+        std::cerr << "io_uring unavailable (" << strerror(errno) << "), sending with NetworkSender.\n";
+        ring_.reset();
+    }
+#endif
+    if (!ring_) {
+        fallback_.reset(new NetworkSender(targetIp, targetPort));
+    }
+}
+
+NetworkSenderUring::~NetworkSenderUring() {
+}
+
+bool NetworkSenderUring::sendPacket(const std::vector<unsigned char>& data) {
+    if (!ring_) return fallback_->sendPacket(data);
+    batch_.clear();
+    return batch_.append(data.data(), data.size()) && sendRegistered(1) == 1;
+}
+
+size_t NetworkSenderUring::sendBatch(const PacketBatch& batch) {
+    if (!ring_) return fallback_->sendBatch(batch);
+    if (&batch == &batch_) return sendRegistered(batch_.size());
+
+    size_t sent = 0;
+    while (sent < batch.size()) {
+        batch_.clear();
+        for (size_t i = sent; i < batch.size() && batch_.append(batch.data(i), batch.length(i)); ++i) {}
+        size_t count = batch_.size();
+        size_t done = sendRegistered(count);
+        sent += done;
+        if (done < count) break;
+    }
+    return sent;
+}
+
+size_t NetworkSenderUring::sendRegistered(size_t count) {
+#ifdef NETWORK_HAVE_URING
+    size_t sent = 0;
+    while (sent < count) {
+        // Linked, so they go out in order; a failure cancels the rest.
+        size_t chunk = std::min<size_t>(count - sent, SQ_ENTRIES);
+        io_uring_sqe* last = nullptr;
+        for (size_t i = 0; i < chunk; ++i) {
+            io_uring_sqe* sqe = ring_->getSqe();
+            if (!sqe) { // Still holding sends an earlier failure left queued
+                chunk = i;
+                break;
+            }
+            sqe->opcode = IORING_OP_WRITE_FIXED;
+            sqe->fd = ring_->sockfd;
+            sqe->addr = reinterpret_cast<uint64_t>(batch_.slot(sent + i));
+            sqe->len = static_cast<unsigned>(batch_.length(sent + i));
+            sqe->buf_index = 0;
+            sqe->user_data = i;
+            sqe->flags = IOSQE_IO_LINK;
+            last = sqe;
+        }
+        if (!last) break;
+        last->flags = 0;
+
+        int results[SQ_ENTRIES];
+        size_t completed = 0;
+        while (completed < chunk) {
+            io_uring_cqe* cqe = ring_->peek();
+            if (!cqe) {
+                if (ring_->submit(static_cast<unsigned>(chunk - completed)) < 0 && errno != EINTR) {
+                    perror("io_uring_enter failed");
+                    return sent;
+                }
+                continue;
+            }
+            results[cqe->user_data] = cqe->res;
+            ring_->advance();
+            ++completed;
+        }
+
+        size_t i = 0;
+        while (i < chunk && results[i] == static_cast<int>(batch_.length(sent + i))) {
+            ++i;
+        }
+        sent += i;
+        if (i < chunk) {
+            if (results[i] != -ECONNREFUSED) {
+                std::cerr << "io_uring send failed: " << strerror(results[i] < 0 ? -results[i] : EIO) << "\n";
+                break;
+            }
+            // An ICMP error left by an earlier datagram: nobody listens at
+            // the target yet. sendto() would ignore it, so count this one as
+            // sent (and lost) and resubmit the ones the link cancelled.
+            ++sent;
+        }
+    }
+    return sent;
+#else
+    return 0;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef NETWORK_URING_H
+#define NETWORK_URING_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "NetworkReceiver.h"
+#include "NetworkSender.h"
+#include "PacketBatch.h"
+
+struct UringContext; // The ring, its socket and buffers; Linux only, see NetworkUring.cpp
+
+// NetworkReceiver and NetworkSender over io_uring, for relays carrying many
+// streams. The receiver keeps one multishot receive armed on the socket:
+// the kernel picks a buffer from a ring shared with us and posts a completion
+// per datagram, which receive() reads straight from memory, so while
+// packets keep arriving there is no syscall per packet (one per wait, when
+// the completion queue runs dry) and no copy out of the kernel's buffer.
+// The sender sends from buffers registered with the kernel once.
+//
+// Where io_uring is missing (other systems, or kernels before 6.0) or
+// refuses to set up, both quietly use NetworkReceiver and NetworkSender
+// instead; usingUring() says which.
+class NetworkReceiverUring {
+public:
+    // Called with each datagram, which is only valid during the call.
+    typedef std::function<void(const unsigned char* data, size_t length)> PacketHandler;
+
+    NetworkReceiverUring(unsigned short listenPort);
+    ~NetworkReceiverUring();
+    bool start();
+    // Also wakes a receive() blocked in another thread, which returns 0.
+    void stop();
+    bool usingUring() const { return ring_ != nullptr; }
+
+    std::vector<unsigned char> receivePacketBlocking();
+    // As NetworkReceiver::receiveBatch(); copies the datagrams into batch.
+    size_t receiveBatch(PacketBatch& batch);
+    // Blocks until a datagram arrives, then hands it and those already
+    // received behind it, up to maxPackets, to handler without copying them.
+    // Returns how many were handled, 0 on error.
+    size_t receive(const PacketHandler& handler, size_t maxPackets = 64);
+
+private:
+    bool startUring();
+    void useFallback();
+
+    unsigned short listenPort_;
+    std::atomic<bool> running_;
+    std::unique_ptr<UringContext> ring_;
+    std::unique_ptr<NetworkReceiver> fallback_;
+    PacketBatch fallbackBatch_; // Only for receive() on the fallback
+};
+
+class NetworkSenderUring {
+public:
+    NetworkSenderUring(const std::string& targetIp, unsigned short targetPort);
+    ~NetworkSenderUring();
+    bool usingUring() const { return ring_ != nullptr; }
+
+    bool sendPacket(const std::vector<unsigned char>& data);
+    // As NetworkSender::sendBatch(). A batch other than registeredBatch() is
+    // first copied into it.
+    size_t sendBatch(const PacketBatch& batch);
+    // The batch in the registered buffers: fill it and send it to skip the copy.
+    PacketBatch& registeredBatch() { return batch_; }
+
+private:
+    size_t sendRegistered(size_t count);
+
+    PacketBatch batch_;
+    std::unique_ptr<UringContext> ring_;
+    std::unique_ptr<NetworkSender> fallback_;
+};
+
+#endif // NETWORK_URING_H
\ No newline at end of file
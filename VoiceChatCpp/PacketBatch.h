@@ -0,0 +1,53 @@
+#ifndef PACKET_BATCH_H
+#define PACKET_BATCH_H
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+
+// A fixed number of datagram slots in one arena, allocated once and reused for
+// every batch: NetworkReceiver::receiveBatch() fills it with whatever has
+// arrived, NetworkSender::sendBatch() sends what was appended. On Linux each
+// batch is a single recvmmsg/sendmmsg call, so a busy socket costs one syscall
+// per batch instead of one per packet.
+class PacketBatch {
+public:
+    static const size_t MAX_PACKET_SIZE = 4096; // Same limit as receivePacketBlocking()
+
+    explicit PacketBatch(size_t capacity = 64)
+        : arena_(capacity * MAX_PACKET_SIZE), lengths_(capacity), count_(0) {}
+
+    size_t capacity() const { return lengths_.size(); }
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    bool full() const { return count_ == lengths_.size(); }
+    void clear() { count_ = 0; }
+
+    // Packet i of size(); valid until the batch is refilled.
+    const unsigned char* data(size_t i) const { return arena_.data() + i * MAX_PACKET_SIZE; }
+    size_t length(size_t i) const { return lengths_[i]; }
+
+    // Copies one datagram into the next free slot. False if the batch is full
+    // or the datagram is larger than MAX_PACKET_SIZE.
+    bool append(const unsigned char* data, size_t length) {
+        if (full() || length > MAX_PACKET_SIZE) {
+            return false;
+        }
+        std::memcpy(slot(count_), data, length);
+        lengths_[count_++] = length;
+        return true;
+    }
+
+    // For the socket classes, which receive straight into the slots: slot i
+    // holds MAX_PACKET_SIZE bytes, and setReceived() publishes the first count.
+    unsigned char* slot(size_t i) { return arena_.data() + i * MAX_PACKET_SIZE; }
+    void setLength(size_t i, size_t length) { lengths_[i] = length; }
+    void setReceived(size_t count) { count_ = count; }
+
+private:
+    std::vector<unsigned char> arena_;
+    std::vector<size_t> lengths_;
+    size_t count_;
+};
+
+#endif // PACKET_BATCH_H
@@ -0,0 +1,194 @@
+#ifndef PACKET_BUFFER_H
+#define PACKET_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "PacketBatch.h"
+
+class PacketPool;
+
+// A handle on one datagram-sized buffer from a PacketPool. Handles are
+// reference counted: copying one shares the buffer (sending one packet to
+// several destinations, or keeping it for FEC while it waits to be played,
+// copies no bytes), and the buffer goes back to its pool when the last handle
+// lets go, from whichever thread that is. A handle can also be a slice of
+// its buffer, e.g. the payload inside an RTP datagram.
+//
+// Only write through a handle nobody else holds yet: fill it, then share it.
+class PacketBuffer {
+public:
+    PacketBuffer() noexcept : block_(nullptr), offset_(0), size_(0) {}
+    PacketBuffer(const PacketBuffer& other) noexcept
+        : block_(other.block_), offset_(other.offset_), size_(other.size_) {
+        retain();
+    }
+    PacketBuffer(PacketBuffer&& other) noexcept
+        : block_(other.block_), offset_(other.offset_), size_(other.size_) {
+        other.block_ = nullptr;
+        other.offset_ = other.size_ = 0;
+    }
+    PacketBuffer& operator=(const PacketBuffer& other) noexcept {
+        if (block_ != other.block_) {
+            PacketBuffer copy(other);
+            swap(copy);
+        }
+        else {
+            offset_ = other.offset_;
+            size_ = other.size_;
+        }
+        return *this;
+    }
+    PacketBuffer& operator=(PacketBuffer&& other) noexcept {
+        PacketBuffer moved(std::move(other));
+        swap(moved);
+        return *this;
+    }
+    ~PacketBuffer() { release(); }
+
+    void swap(PacketBuffer& other) noexcept {
+        std::swap(block_, other.block_);
+        std::swap(offset_, other.offset_);
+        std::swap(size_, other.size_);
+    }
+
+    // Whether the handle holds a buffer at all (PacketPool::acquire() fails
+    // when the pool is exhausted).
+    bool valid() const { return block_ != nullptr; }
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    unsigned char* data();
+    const unsigned char* data() const;
+    // Bytes from data() to the end of the buffer.
+    size_t capacity() const;
+    // Sets size() within capacity().
+    void resize(size_t size) { size_ = size <= capacity() ? size : capacity(); }
+
+    // A handle on bytes [offset, offset + size) of this one, sharing the buffer.
+    PacketBuffer slice(size_t offset, size_t size) const {
+        PacketBuffer part(*this);
+        part.offset_ += offset < size_ ? offset : size_;
+        part.size_ = offset < size_ ? (size < size_ - offset ? size : size_ - offset) : 0;
+        return part;
+    }
+
+    // Drops this handle's reference.
+    void reset() {
+        release();
+        block_ = nullptr;
+        offset_ = size_ = 0;
+    }
+    long useCount() const;
+
+private:
+    friend class PacketPool;
+
+    struct Block {
+        std::atomic<long> refs;
+        unsigned char* data;
+        PacketPool* pool;
+    };
+
+    explicit PacketBuffer(Block* block, size_t size) : block_(block), offset_(0), size_(size) {}
+
+    void retain() {
+        if (block_) block_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    void release();
+
+    Block* block_;
+    size_t offset_;
+    size_t size_;
+};
+
+// A fixed number of fixed-size packet buffers, allocated once. acquire()
+// and the last release of a buffer take a short lock but never allocate, so
+// packets can go from socket to decoder and from encoder to socket without
+// touching the heap. The pool must outlive every buffer taken from it.
+class PacketPool {
+public:
+    explicit PacketPool(size_t count, size_t bufferSize = PacketBatch::MAX_PACKET_SIZE)
+        : bufferSize_(bufferSize),
+        arena_(count * bufferSize),
+        blocks_(new PacketBuffer::Block[count]),
+        exhausted_(0)
+    {
+        free_.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            blocks_[i].refs.store(0, std::memory_order_relaxed);
+            blocks_[i].data = arena_.data() + i * bufferSize;
+            blocks_[i].pool = this;
+            free_.push_back(&blocks_[i]);
+        }
+    }
+
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    // A buffer of bufferSize() bytes, all of it counted in size(); resize()
+    // it to what was written. Invalid if every buffer is in use.
+    PacketBuffer acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.empty()) {
+            ++exhausted_;
+            return PacketBuffer();
+        }
+        PacketBuffer::Block* block = free_.back();
+        free_.pop_back();
+        block->refs.store(1, std::memory_order_relaxed);
+        return PacketBuffer(block, bufferSize_);
+    }
+
+    size_t bufferSize() const { return bufferSize_; }
+    size_t available() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_.size();
+    }
+    // How many acquire() calls found the pool empty.
+    uint64_t exhaustedCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return exhausted_;
+    }
+
+private:
+    friend class PacketBuffer;
+
+    void recycle(PacketBuffer::Block* block) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(block); // Never grows: reserved for every block
+    }
+
+    const size_t bufferSize_;
+    std::vector<unsigned char> arena_;
+    std::unique_ptr<PacketBuffer::Block[]> blocks_;
+    mutable std::mutex mutex_;
+    std::vector<PacketBuffer::Block*> free_;
+    uint64_t exhausted_;
+};
+
+inline unsigned char* PacketBuffer::data() {
+    return block_ ? block_->data + offset_ : nullptr;
+}
+
+inline const unsigned char* PacketBuffer::data() const {
+    return block_ ? block_->data + offset_ : nullptr;
+}
+
+inline size_t PacketBuffer::capacity() const {
+    return block_ ? block_->pool->bufferSize() - offset_ : 0;
+}
+
+inline long PacketBuffer::useCount() const {
+    return block_ ? block_->refs.load(std::memory_order_relaxed) : 0;
+}
+
+inline void PacketBuffer::release() {
+    if (block_ && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        block_->pool->recycle(block_);
+    }
+}
+
+#endif // PACKET_BUFFER_H
\ No newline at end of file
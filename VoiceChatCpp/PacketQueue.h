@@ -1,52 +1,85 @@
 #ifndef PACKET_QUEUE_H
 #define PACKET_QUEUE_H
 
-#include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <vector>
+#include <utility>
+#include <cstddef>
 
+// Blocking FIFO between threads, over a ring of `capacity` slots allocated
+// up front: push() and pop() never allocate. A push() onto a full queue
+// drops the value and returns false.
 template <typename T>
 class PacketQueue {
 private:
-    std::queue<T> queue_;
+    std::vector<T> ring_;
+    size_t head_;  // Slot of the oldest value
+    size_t count_;
     mutable std::mutex mutex_;
     std::condition_variable cond_var_;
 
+    // Takes the oldest value out, leaving a default T behind so the slot
+    // doesn't keep anything (a pooled buffer, say) alive. Needs the lock.
+    T take() {
+        T value = std::move(ring_[head_]);
+        ring_[head_] = T();
+        head_ = (head_ + 1) % ring_.size();
+        --count_;
+        return value;
+    }
+
 public:
-    void push(const T& value) {
+    explicit PacketQueue(size_t capacity) : ring_(capacity > 0 ? capacity : 1), head_(0), count_(0) {}
+
+    bool push(const T& value) {
         std::lock_guard<std::mutex> lock(mutex_);
-        queue_.push(value);
+        if (count_ == ring_.size()) {
+            return false;
+        }
+        ring_[(head_ + count_++) % ring_.size()] = value;
         cond_var_.notify_one(); // Notify one waiting thread
+        return true;
+    }
+
+    bool push(T&& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (count_ == ring_.size()) {
+            return false;
+        }
+        ring_[(head_ + count_++) % ring_.size()] = std::move(value);
+        cond_var_.notify_one();
+        return true;
     }
 
     T pop() {
         std::unique_lock<std::mutex> lock(mutex_);
         // Wait until the queue is not empty
-        cond_var_.wait(lock, [this] { return !queue_.empty(); });
-        T value = queue_.front();
-        queue_.pop();
-        return value;
+        cond_var_.wait(lock, [this] { return count_ > 0; });
+        return take();
     }
 
     bool try_pop(T& value) {
         std::lock_guard<std::mutex> lock(mutex_);
-        if (queue_.empty()) {
+        if (count_ == 0) {
             return false;
         }
-        value = queue_.front();
-        queue_.pop();
+        value = take();
         return true;
     }
 
     size_t size() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.size();
+        return count_;
+    }
+
+    size_t capacity() const {
+        return ring_.size();
     }
 
     bool empty() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.empty();
+        return count_ == 0;
     }
 };
 
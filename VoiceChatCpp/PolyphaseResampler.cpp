@@ -0,0 +1,298 @@
+#include "PolyphaseResampler.h"
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define RESAMPLER_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC lets any function use any intrinsic; GCC and Clang need to be told
+// which functions may use AVX2/FMA (the rest of the file stays baseline).
+#if defined(RESAMPLER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RESAMPLER_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define RESAMPLER_TARGET_AVX2
+#endif
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+// Stopband attenuation of the Kaiser-windowed filter, and the window shape
+// that gives it (Kaiser's formula for A > 50 dB).
+const double STOPBAND_DB = 70.0;
+const double KAISER_BETA = 0.1102 * (STOPBAND_DB - 8.7);
+// L beyond this would make the coefficient table silly (e.g. 44100 <-> 44099).
+const int MAX_PHASES = 4096;
+
+int gcd(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Zeroth-order modified Bessel function of the first kind, for the Kaiser window.
+double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+float dotScalar(const float* a, const float* b, int n) {
+    float sum = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#ifdef RESAMPLER_X86
+float dotSse2(const float* a, const float* b, int n) {
+    // n is a multiple of 8: two independent accumulators hide the add latency.
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (int i = 0; i < n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 acc = _mm_add_ps(acc0, acc1);
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    return _mm_cvtss_f32(acc);
+}
+
+RESAMPLER_TARGET_AVX2 float dotAvx2(const float* a, const float* b, int n) {
+    __m256 acc = _mm256_setzero_ps();
+    for (int i = 0; i < n; i += 8) {
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+    }
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+void cpuid(int leaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, leaf, 0);
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned int>(info[i]);
+#else
+    __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+bool cpuHasSse2() {
+#if defined(_M_X64) || defined(__x86_64__)
+    return true; // Part of x86-64
+#else
+    unsigned int regs[4];
+    cpuid(1, regs);
+    return (regs[3] & (1u << 26)) != 0;
+#endif
+}
+
+bool cpuHasAvx2Fma() {
+    unsigned int regs[4];
+    cpuid(0, regs);
+    if (regs[0] < 7) return false;
+    cpuid(1, regs);
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0;
+    const bool fma = (regs[2] & (1u << 12)) != 0;
+    if (!osxsave || !avx || !fma) return false;
+    // The OS must save the YMM registers on context switches.
+#if defined(_MSC_VER)
+    const unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    const unsigned long long xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+    if ((xcr0 & 6) != 6) return false;
+    cpuid(7, regs);
+    return (regs[1] & (1u << 5)) != 0;
+}
+#endif // RESAMPLER_X86
+
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler(int inRate, int outRate, int channels, int tapsPerPhase)
+    : inRate_(inRate),
+    outRate_(outRate),
+    channels_(channels),
+    up_(1),
+    down_(1),
+    taps_(std::max(tapsPerPhase, 2)),
+    paddedTaps_(0),
+    dot_(dotScalar),
+    kernelName_("scalar"),
+    history_(std::max(channels, 1)),
+    historyLength_(0),
+    phase_(0)
+{
+    if (inRate <= 0 || outRate <= 0 || channels <= 0) {
+        throw std::runtime_error("Invalid resampler configuration");
+    }
+    const int g = gcd(inRate, outRate);
+    up_ = outRate / g;
+    down_ = inRate / g;
+    if (up_ > MAX_PHASES) {
+        throw std::runtime_error("Unsupported resampling ratio " + std::to_string(inRate) + " -> " + std::to_string(outRate));
+    }
+    // When decimating, the filter has to cut at the output's Nyquist
+    // frequency, a fraction up_/down_ of the input's, so it needs down_/up_
+    // times the taps for the same transition width relative to that Nyquist.
+    // This also keeps one output step from skipping a whole filter length.
+    if (down_ > up_) {
+        taps_ = static_cast<int>((static_cast<long long>(taps_) * down_ + up_ - 1) / up_);
+    }
+    paddedTaps_ = (taps_ + 7) & ~7;
+
+#ifdef RESAMPLER_X86
+    if (cpuHasAvx2Fma()) {
+        dot_ = dotAvx2;
+        kernelName_ = "AVX2";
+    }
+    else if (cpuHasSse2()) {
+        dot_ = dotSse2;
+        kernelName_ = "SSE2";
+    }
+#endif
+
+    if (!passthrough()) {
+        designFilter();
+        // Start with taps_ - 1 frames of silence so output begins right away;
+        // this is exactly the group delay, not extra buffering.
+        historyLength_ = static_cast<size_t>(taps_ - 1);
+        for (auto& channel : history_) {
+            channel.assign(historyLength_ + paddedTaps_, 0.0f);
+        }
+    }
+}
+
+void PolyphaseResampler::designFilter() {
+    // Windowed-sinc lowpass of up_ * taps_ taps at the upsampled rate inRate_ * up_.
+    // Its transition band (Kaiser's estimate for this length and attenuation)
+    // ends at the lower of the two Nyquist frequencies, so nothing above that
+    // frequency aliases or images back below it by more than -STOPBAND_DB.
+    const int length = up_ * taps_;
+    const double rate = static_cast<double>(inRate_) * up_;
+    const double nyquist = 0.5 * std::min(inRate_, outRate_);
+    const double transition = (STOPBAND_DB - 8.0) / (2.285 * (length - 1)) / (2.0 * PI) * rate;
+    const double cutoff = std::max(nyquist - 0.5 * transition, 0.5 * nyquist) / rate;
+    const double center = (length - 1) / 2.0;
+    const double i0Beta = besselI0(KAISER_BETA);
+    std::vector<double> prototype(length);
+    for (int j = 0; j < length; ++j) {
+        const double t = j - center;
+        const double x = 2.0 * cutoff * t;
+        const double sinc = (t == 0.0) ? 1.0 : std::sin(PI * x) / (PI * x);
+        const double r = t / center;
+        const double window = besselI0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0Beta;
+        prototype[j] = 2.0 * cutoff * sinc * window;
+    }
+
+    // Phase p uses every up_-th tap starting at p, reversed so the dot product
+    // walks the input forwards. Each phase is normalised to unity DC gain,
+    // which also takes care of the up_ gain factor of interpolation.
+    phases_.assign(static_cast<size_t>(up_) * paddedTaps_, 0.0f);
+    for (int p = 0; p < up_; ++p) {
+        double sum = 0.0;
+        for (int k = 0; k < taps_; ++k) {
+            sum += prototype[p + (taps_ - 1 - k) * up_];
+        }
+        for (int k = 0; k < taps_; ++k) {
+            phases_[static_cast<size_t>(p) * paddedTaps_ + k] =
+                static_cast<float>(prototype[p + (taps_ - 1 - k) * up_] / sum);
+        }
+    }
+}
+
+size_t PolyphaseResampler::maxOutputFrames(size_t inFrames) const {
+    if (passthrough()) {
+        return inFrames;
+    }
+    return ((inFrames + taps_) * static_cast<size_t>(up_) + down_ - 1) / down_ + 1;
+}
+
+size_t PolyphaseResampler::process(const float* in, size_t inFrames, float* out) {
+    if (passthrough()) {
+        std::memcpy(out, in, inFrames * channels_ * sizeof(float));
+        return inFrames;
+    }
+
+    // Deinterleave behind what is left of the previous call. The extra
+    // paddedTaps_ zeros at the end keep the SIMD kernels' over-read in bounds.
+    const size_t total = historyLength_ + inFrames;
+    for (int c = 0; c < channels_; ++c) {
+        std::vector<float>& channel = history_[c];
+        channel.resize(total + paddedTaps_);
+        float* dst = channel.data() + historyLength_;
+        const float* src = in + c;
+        for (size_t i = 0; i < inFrames; ++i) {
+            dst[i] = src[i * channels_];
+        }
+        std::fill(channel.begin() + total, channel.end(), 0.0f);
+    }
+
+    size_t produced = 0;
+    size_t start = 0;
+    int phase = phase_;
+    while (start + taps_ <= total) {
+        const float* coefficients = &phases_[static_cast<size_t>(phase) * paddedTaps_];
+        for (int c = 0; c < channels_; ++c) {
+            out[produced * channels_ + c] = dot_(coefficients, history_[c].data() + start, paddedTaps_);
+        }
+        ++produced;
+        phase += down_;
+        start += phase / up_;
+        phase %= up_;
+    }
+
+    // Keep the samples the next output still needs (fewer than taps_; since a
+    // step never exceeds taps_, start can't run past the end).
+    const size_t keep = total - start;
+    for (int c = 0; c < channels_; ++c) {
+        std::memmove(history_[c].data(), history_[c].data() + start, keep * sizeof(float));
+    }
+    historyLength_ = keep;
+    phase_ = phase;
+    return produced;
+}
+
+void PolyphaseResampler::process(const std::vector<float>& in, std::vector<float>& out) {
+    const size_t inFrames = in.size() / channels_;
+    out.resize(maxOutputFrames(inFrames) * channels_);
+    const size_t produced = process(in.data(), inFrames, out.data());
+    out.resize(produced * channels_);
+}
+
+double PolyphaseResampler::groupDelayFrames() const {
+    if (passthrough()) {
+        return 0.0;
+    }
+    // Linear-phase prototype of up_ * taps_ taps at the upsampled rate.
+    return (static_cast<double>(up_) * taps_ - 1.0) / (2.0 * up_);
+}
+
+double PolyphaseResampler::groupDelayMs() const {
+    return 1000.0 * groupDelayFrames() / inRate_;
+}
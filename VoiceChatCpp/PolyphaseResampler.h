@@ -0,0 +1,74 @@
+#ifndef POLYPHASE_RESAMPLER_H
+#define POLYPHASE_RESAMPLER_H
+
+#include <vector>
+#include <cstddef>
+
+// Streaming rational-ratio resampler for interleaved float audio, used between
+// the device rate (e.g. 44.1 kHz) and the rates Opus accepts (8/12/16/24/48 kHz).
+//
+// The ratio outRate/inRate is reduced to L/M and a windowed-sinc lowpass is
+// split into L phases, so every output sample is a single short dot product
+// over contiguous input. Those dot products run on AVX2/FMA or SSE2 when the
+// CPU has them (picked once at runtime), scalar otherwise. The delay is fixed
+// and known up front: see groupDelayMs().
+//
+// The filter attenuates everything above the lower Nyquist frequency by
+// about 70 dB; its passband ends where the transition band starts. That is
+// set by tapsPerPhase, the taps per phase for rates up to 1:1, scaled up by
+// M/L when decimating so the transition keeps its width relative to the
+// output band. Fewer taps mean less latency and CPU but a wider transition.
+// With the default of 64 the passband reaches about 86% of the lower
+// Nyquist frequency, at a delay of about 0.7 ms for 44.1 -> 48 kHz and 4 ms
+// for 48 -> 8 kHz.
+class PolyphaseResampler {
+public:
+    PolyphaseResampler(int inRate, int outRate, int channels, int tapsPerPhase = 64); // Throws std::runtime_error
+
+    // Consumes inFrames frames (per channel) and writes the output produced so
+    // far to out, which must hold maxOutputFrames(inFrames) frames.
+    // Returns the number of frames written. Allocation-free once warmed up.
+    size_t process(const float* in, size_t inFrames, float* out);
+
+    // Convenience overload; resizes out to what was produced.
+    void process(const std::vector<float>& in, std::vector<float>& out);
+
+    size_t maxOutputFrames(size_t inFrames) const;
+
+    int inputRate() const { return inRate_; }
+    int outputRate() const { return outRate_; }
+    bool passthrough() const { return inRate_ == outRate_; }
+
+    // Delay the filter adds, in input frames and in milliseconds.
+    double groupDelayFrames() const;
+    double groupDelayMs() const;
+
+    // Name of the dot-product kernel in use: "AVX2", "SSE2" or "scalar".
+    const char* kernelName() const { return kernelName_; }
+
+private:
+    typedef float (*DotFunction)(const float* a, const float* b, int n);
+
+    void designFilter();
+
+    const int inRate_;
+    const int outRate_;
+    const int channels_;
+    int up_;   // L
+    int down_; // M
+    int taps_;        // Taps per phase as designed, after scaling for decimation
+    int paddedTaps_;  // Rounded up to a multiple of 8 for the SIMD kernels
+
+    // phases_[p * paddedTaps_ + k] multiplies input sample i + k for phase p.
+    std::vector<float> phases_;
+    DotFunction dot_;
+    const char* kernelName_;
+
+    // Per-channel (planar) input: the unconsumed tail of the previous call
+    // followed by the new samples, so every dot product reads contiguously.
+    std::vector<std::vector<float>> history_;
+    size_t historyLength_; // Same for all channels
+    int phase_;            // Phase of the next output sample
+};
+
+#endif // POLYPHASE_RESAMPLER_H
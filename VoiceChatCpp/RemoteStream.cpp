@@ -0,0 +1,118 @@
+#include "RemoteStream.h"
+#include <iostream>
+#include <algorithm>
+
+RemoteStream::RemoteStream(uint32_t ssrc, int sampleRate, int channels, int clockRate, int minDelayMs, int maxDelayMs,
+    int dredMs)
+    : ssrc(ssrc),
+    clockRate(clockRate),
+    jitterBuffer(clockRate, minDelayMs, maxDelayMs),
+    decoder(sampleRate, channels),
+    pendingPos(0),
+    lastPacket(std::chrono::steady_clock::now())
+{
+    if (dredMs > 0) {
+        decoder.enableDred(dredMs);
+    }
+}
+
+bool RemoteStream::mixInto(float* out, size_t samples) {
+    const size_t channels = static_cast<size_t>(decoder.channels());
+    MediaPacket packet;
+    while (pending.size() - pendingPos < samples) {
+        if (pendingPos > 0) {
+            pending.erase(pending.begin(), pending.begin() + pendingPos);
+            pendingPos = 0;
+        }
+        JitterBuffer::Result result = jitterBuffer.pop(packet);
+        if (result == JitterBuffer::Result::Empty) {
+            break;
+        }
+        const size_t old = pending.size();
+        if (result == JitterBuffer::Result::Packet) {
+            int frames = decoder.getFrameCount(packet.payload.data(), packet.payload.size());
+            if (frames <= 0) {
+                continue;
+            }
+            pending.resize(old + frames * channels);
+            int decoded = decoder.decodeInto(packet.payload.data(), packet.payload.size(), &pending[old], frames);
+            pending.resize(old + std::max(decoded, 0) * channels);
+        }
+        else {
+            size_t frames = static_cast<size_t>(static_cast<int64_t>(packet.duration) * decoder.sampleRate() / clockRate);
+            pending.resize(old + frames * channels, 0.0f);
+            const unsigned char* next = packet.payload.empty() ? nullptr : packet.payload.data();
+            int nextOffset = static_cast<int>(static_cast<int64_t>(packet.nextOffset) * decoder.sampleRate() / clockRate);
+            int concealed = decoder.concealInto(next, packet.payload.size(), nextOffset, &pending[old], static_cast<int>(frames));
+            if (concealed < 0) {
+                std::fill(pending.begin() + old, pending.end(), 0.0f); // Silence as a last resort
+            }
+        }
+    }
+
+    const size_t available = std::min(samples, pending.size() - pendingPos);
+    for (size_t i = 0; i < available; ++i) {
+        out[i] += pending[pendingPos + i];
+    }
+    pendingPos += available;
+    return available > 0;
+}
+
+RemoteStreamSet::RemoteStreamSet(int sampleRate, int channels, int clockRate, int minDelayMs, int maxDelayMs,
+    std::chrono::milliseconds idleTimeout, int dredMs)
+    : sampleRate_(sampleRate),
+    channels_(channels),
+    clockRate_(clockRate),
+    minDelayMs_(minDelayMs),
+    maxDelayMs_(maxDelayMs),
+    idleTimeout_(idleTimeout),
+    dredMs_(dredMs)
+{
+}
+
+void RemoteStreamSet::push(MediaPacket&& packet) {
+    std::shared_ptr<RemoteStream> stream;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = streams_.find(packet.ssrc);
+        if (it == streams_.end()) {
+            try {
+                stream = std::make_shared<RemoteStream>(packet.ssrc, sampleRate_, channels_,
+                    clockRate_, minDelayMs_, maxDelayMs_, dredMs_);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Cannot open stream " << packet.ssrc << ": " << e.what() << std::endl;
+                return;
+            }
+            streams_.emplace(packet.ssrc, stream);
+            std::cout << "Receiving RTP stream, SSRC " << packet.ssrc << "\n";
+            condVar_.notify_one();
+        }
+        else {
+            stream = it->second;
+        }
+        stream->lastPacket = std::chrono::steady_clock::now();
+    }
+    stream->jitterBuffer.push(std::move(packet));
+}
+
+void RemoteStreamSet::snapshot(std::vector<std::shared_ptr<RemoteStream>>& streams) {
+    const auto now = std::chrono::steady_clock::now();
+    streams.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = streams_.begin(); it != streams_.end();) {
+        if (now - it->second->lastPacket > idleTimeout_) {
+            std::cout << "RTP stream " << it->first << " went idle\n";
+            it = streams_.erase(it);
+        }
+        else {
+            streams.push_back(it->second);
+            ++it;
+        }
+    }
+}
+
+void RemoteStreamSet::waitForStream(std::chrono::milliseconds maxWait) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condVar_.wait_for(lock, maxWait, [this] { return !streams_.empty(); });
+}
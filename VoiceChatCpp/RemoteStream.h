@@ -0,0 +1,69 @@
+#ifndef REMOTE_STREAM_H
+#define REMOTE_STREAM_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include "MediaPacket.h"
+#include "JitterBuffer.h"
+#include "AudioCodec.h"
+
+// Everything we keep per remote talker: its own jitter buffer and its own
+// Opus decoder, so several talkers can be decoded side by side.
+struct RemoteStream {
+    // dredMs > 0 lets the decoder rebuild lost bursts from DRED (see AudioDecoder::enableDred).
+    RemoteStream(uint32_t ssrc, int sampleRate, int channels, int clockRate, int minDelayMs, int maxDelayMs,
+        int dredMs = 0);
+
+    // Adds the next `samples` interleaved samples of this talker into out,
+    // decoding as many frames as that takes (lost frames are concealed).
+    // Returns false if the stream had nothing to contribute.
+    bool mixInto(float* out, size_t samples);
+
+    const uint32_t ssrc;
+    const int clockRate;
+    JitterBuffer jitterBuffer;
+    AudioDecoder decoder;
+
+    // Decoded audio not yet handed to the mixer (playback thread only).
+    std::vector<float> pending;
+    size_t pendingPos;
+
+    std::chrono::steady_clock::time_point lastPacket; // Guarded by RemoteStreamSet
+};
+
+// The set of remote talkers, demultiplexed by RTP SSRC. The network thread
+// push()es into it; the playback thread takes snapshot()s to decode and mix.
+class RemoteStreamSet {
+public:
+    RemoteStreamSet(int sampleRate, int channels, int clockRate, int minDelayMs, int maxDelayMs,
+        std::chrono::milliseconds idleTimeout, int dredMs = 0);
+
+    // Routes the packet to its talker, creating the stream on first sight.
+    void push(MediaPacket&& packet);
+
+    // Current talkers; streams idle for longer than idleTimeout are dropped here.
+    void snapshot(std::vector<std::shared_ptr<RemoteStream>>& streams);
+
+    // Blocks until at least one stream exists, or maxWait.
+    void waitForStream(std::chrono::milliseconds maxWait);
+
+private:
+    const int sampleRate_;
+    const int channels_;
+    const int clockRate_;
+    const int minDelayMs_;
+    const int maxDelayMs_;
+    const std::chrono::milliseconds idleTimeout_;
+    const int dredMs_;
+
+    std::mutex mutex_;
+    std::condition_variable condVar_;
+    std::map<uint32_t, std::shared_ptr<RemoteStream>> streams_;
+};
+
+#endif // REMOTE_STREAM_H
@@ -0,0 +1,126 @@
+#include "RtpPacket.h"
+#include <random>
+#include <algorithm>
+
+namespace {
+
+void writeBigEndian16(unsigned char* out, uint16_t value) {
+    out[0] = static_cast<unsigned char>(value >> 8);
+    out[1] = static_cast<unsigned char>(value);
+}
+
+void writeBigEndian32(unsigned char* out, uint32_t value) {
+    out[0] = static_cast<unsigned char>(value >> 24);
+    out[1] = static_cast<unsigned char>(value >> 16);
+    out[2] = static_cast<unsigned char>(value >> 8);
+    out[3] = static_cast<unsigned char>(value);
+}
+
+uint16_t readBigEndian16(const unsigned char* in) {
+    return static_cast<uint16_t>((in[0] << 8) | in[1]);
+}
+
+uint32_t readBigEndian32(const unsigned char* in) {
+    return (static_cast<uint32_t>(in[0]) << 24) | (static_cast<uint32_t>(in[1]) << 16) |
+        (static_cast<uint32_t>(in[2]) << 8) | in[3];
+}
+
+} // namespace
+
+RtpPacketizer::RtpPacketizer(int sampleRate, uint8_t payloadType)
+    : sampleRate_(sampleRate),
+    payloadType_(payloadType),
+    frameRemainder_(0)
+{
+    // RFC 3550 wants the SSRC and the initial sequence/timestamp to be random.
+    std::random_device rd;
+    ssrc_ = rd();
+    sequence_ = static_cast<uint16_t>(rd());
+    timestamp_ = rd();
+}
+
+void RtpPacketizer::packetize(const unsigned char* payload, size_t size, int frames, bool marker,
+    std::vector<unsigned char>& out) {
+    out.resize(RTP_HEADER_SIZE + size);
+    writeHeader(out.data(), marker);
+    std::copy(payload, payload + size, out.begin() + RTP_HEADER_SIZE);
+
+    ++sequence_;
+    timestamp_ += ticksFor(frames);
+}
+
+void RtpPacketizer::packetizeInPlace(PacketBuffer& packet, size_t payloadSize, int frames, bool marker) {
+    packet.resize(RTP_HEADER_SIZE + payloadSize);
+    writeHeader(packet.data(), marker);
+
+    ++sequence_;
+    timestamp_ += ticksFor(frames);
+}
+
+void RtpPacketizer::writeHeader(unsigned char* header, bool marker) {
+    header[0] = static_cast<unsigned char>(RTP_VERSION << 6); // No padding, extension or CSRCs
+    header[1] = static_cast<unsigned char>((marker ? 0x80 : 0x00) | (payloadType_ & 0x7F));
+    writeBigEndian16(header + 2, sequence_);
+    writeBigEndian32(header + 4, timestamp_);
+    writeBigEndian32(header + 8, ssrc_);
+}
+
+void RtpPacketizer::skip(int frames) {
+    timestamp_ += ticksFor(frames);
+}
+
+uint32_t RtpPacketizer::ticksFor(int frames) {
+    // Exact conversion to the 48 kHz media clock, carrying any remainder.
+    uint64_t scaled = static_cast<uint64_t>(frames) * RTP_OPUS_CLOCK_RATE + frameRemainder_;
+    frameRemainder_ = scaled % static_cast<uint64_t>(sampleRate_);
+    return static_cast<uint32_t>(scaled / static_cast<uint64_t>(sampleRate_));
+}
+
+bool RtpDepacketizer::parse(const unsigned char* data, size_t size, RtpHeader& header,
+    const unsigned char*& payload, size_t& payloadSize) {
+    if (size < RTP_HEADER_SIZE || (data[0] >> 6) != RTP_VERSION) {
+        return false;
+    }
+    const bool padding = (data[0] & 0x20) != 0;
+    const bool extension = (data[0] & 0x10) != 0;
+    const size_t csrcCount = data[0] & 0x0F;
+
+    header.marker = (data[1] & 0x80) != 0;
+    header.payloadType = data[1] & 0x7F;
+    header.sequence = readBigEndian16(data + 2);
+    header.timestamp = readBigEndian32(data + 4);
+    header.ssrc = readBigEndian32(data + 8);
+
+    size_t offset = RTP_HEADER_SIZE + 4 * csrcCount;
+    if (extension) {
+        if (size < offset + 4) return false;
+        offset += 4 + 4 * static_cast<size_t>(readBigEndian16(data + offset + 2));
+    }
+    size_t end = size;
+    if (padding) {
+        const size_t padBytes = data[size - 1];
+        if (padBytes == 0 || padBytes > end) return false;
+        end -= padBytes;
+    }
+    if (offset >= end) {
+        return false; // No room left for an Opus packet
+    }
+    payload = data + offset;
+    payloadSize = end - offset;
+    return true;
+}
+
+bool RtpDepacketizer::depacketize(const PacketBuffer& datagram, MediaPacket& packet) {
+    RtpHeader header;
+    const unsigned char* payload;
+    size_t payloadSize;
+    if (!parse(datagram.data(), datagram.size(), header, payload, payloadSize)) {
+        return false;
+    }
+    packet.sequence = header.sequence;
+    packet.timestamp = header.timestamp;
+    packet.marker = header.marker;
+    packet.ssrc = header.ssrc;
+    packet.payload = datagram.slice(static_cast<size_t>(payload - datagram.data()), payloadSize);
+    return true;
+}
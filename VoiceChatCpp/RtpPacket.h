@@ -0,0 +1,74 @@
+#ifndef RTP_PACKET_H
+#define RTP_PACKET_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "MediaPacket.h"
+
+// RTP framing for Opus (RFC 3550 header, RFC 7587 payload format).
+//
+// Opus packets are carried one per RTP packet with no payload header, and the
+// RTP timestamp always runs at 48 kHz regardless of the rate the codec was
+// opened at. We use a single dynamic payload type for the stream.
+const int RTP_VERSION = 2;
+const size_t RTP_HEADER_SIZE = 12; // Fixed header, no CSRCs or extension
+const int RTP_OPUS_CLOCK_RATE = 48000;
+const uint8_t RTP_OPUS_PAYLOAD_TYPE = 111;
+
+struct RtpHeader {
+    bool marker = false;
+    uint8_t payloadType = 0;
+    uint16_t sequence = 0;
+    uint32_t timestamp = 0;
+    uint32_t ssrc = 0;
+};
+
+// Sender side: owns the SSRC, sequence number and media timestamp of one stream.
+class RtpPacketizer {
+public:
+    // sampleRate is the rate of the frames handed to packetize()/skip(); the
+    // timestamp is advanced in 48 kHz units as RFC 7587 requires.
+    RtpPacketizer(int sampleRate, uint8_t payloadType = RTP_OPUS_PAYLOAD_TYPE);
+
+    // Writes header + payload into out (resized to fit) for a frame of
+    // `frames` samples per channel, then advances sequence and timestamp.
+    void packetize(const unsigned char* payload, size_t size, int frames, bool marker,
+        std::vector<unsigned char>& out);
+
+    // Same for a payload already in place at packet.data() + RTP_HEADER_SIZE
+    // (encode straight there): writes only the header and sizes packet to
+    // header + payloadSize.
+    void packetizeInPlace(PacketBuffer& packet, size_t payloadSize, int frames, bool marker);
+
+    // Advances the timestamp over frames that were captured but not sent.
+    void skip(int frames);
+
+    uint32_t ssrc() const { return ssrc_; }
+
+private:
+    uint32_t ticksFor(int frames);
+    void writeHeader(unsigned char* header, bool marker);
+
+    int sampleRate_;
+    uint8_t payloadType_;
+    uint32_t ssrc_;
+    uint16_t sequence_;
+    uint32_t timestamp_;
+    uint64_t frameRemainder_; // Sub-tick carry when sampleRate_ doesn't divide 48 kHz evenly
+};
+
+// Receiver side.
+class RtpDepacketizer {
+public:
+    // Validates and parses an RTP datagram. On success the payload is what's left
+    // after the fixed header, CSRC list, header extension and padding.
+    static bool parse(const unsigned char* data, size_t size, RtpHeader& header,
+        const unsigned char*& payload, size_t& payloadSize);
+
+    // parse() into a MediaPacket (everything but duration/arrival). The
+    // payload is a slice of datagram, sharing its buffer rather than copied.
+    static bool depacketize(const PacketBuffer& datagram, MediaPacket& packet);
+};
+
+#endif // RTP_PACKET_H
@@ -0,0 +1,148 @@
+#ifndef SPSC_RING_BUFFER_H
+#define SPSC_RING_BUFFER_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+
+// Wait-free single-producer/single-consumer ring buffer.
+//
+// Exactly one thread may call the write side (writeAvailable/write) and exactly
+// one other thread the read side (readAvailable/read). Neither side ever takes a
+// lock, so it is safe to use from a PortAudio callback. This is the same scheme
+// as PaUtilRingBuffer (lib/portaudio/src/common/pa_ringbuffer.h), which we can't
+// use directly because it isn't exported from the PortAudio DLL.
+//
+// The indices run over [0, 2 * capacity) so that a full buffer can be told apart
+// from an empty one without requiring a power-of-two capacity. The storage is one
+// contiguous, cache-line aligned block, so any transfer is at most two memcpys,
+// and the get*Regions/commit* calls give direct access to it (zero-copy).
+template <typename T>
+class SpscRingBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRingBuffer elements are copied with memcpy");
+
+public:
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    explicit SpscRingBuffer(size_t capacity)
+        : storage_(capacity + CACHE_LINE_SIZE / sizeof(T) + 1),
+        buffer_(alignStorage(storage_.data())),
+        capacity_(capacity), writeIndex_(0), readIndex_(0) {}
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t capacity() const { return capacity_; }
+
+    // Number of elements that can be read right now (consumer side).
+    size_t readAvailable() const {
+        return distance(readIndex_.load(std::memory_order_relaxed), writeIndex_.load(std::memory_order_acquire));
+    }
+
+    // Number of elements that can be written right now (producer side).
+    size_t writeAvailable() const {
+        return capacity_ - distance(readIndex_.load(std::memory_order_acquire), writeIndex_.load(std::memory_order_relaxed));
+    }
+
+    // Copies up to count elements in, returns how many were written.
+    size_t write(const T* data, size_t count) {
+        const size_t w = writeIndex_.load(std::memory_order_relaxed);
+        const size_t r = readIndex_.load(std::memory_order_acquire);
+        count = std::min(count, capacity_ - distance(r, w));
+        if (count == 0) return 0;
+
+        const size_t pos = w % capacity_;
+        const size_t first = std::min(count, capacity_ - pos);
+        std::memcpy(buffer_ + pos, data, first * sizeof(T));
+        if (count > first) {
+            std::memcpy(buffer_, data + first, (count - first) * sizeof(T));
+        }
+        writeIndex_.store(advance(w, count), std::memory_order_release);
+        return count;
+    }
+
+    // Copies up to count elements out, returns how many were read.
+    size_t read(T* data, size_t count) {
+        const size_t r = readIndex_.load(std::memory_order_relaxed);
+        const size_t w = writeIndex_.load(std::memory_order_acquire);
+        count = std::min(count, distance(r, w));
+        if (count == 0) return 0;
+
+        const size_t pos = r % capacity_;
+        const size_t first = std::min(count, capacity_ - pos);
+        std::memcpy(data, buffer_ + pos, first * sizeof(T));
+        if (count > first) {
+            std::memcpy(data + first, buffer_, (count - first) * sizeof(T));
+        }
+        readIndex_.store(advance(r, count), std::memory_order_release);
+        return count;
+    }
+
+    // Zero-copy write: exposes up to count free elements as one or two regions
+    // (the second is only used when the free space wraps around the end).
+    // Returns the total exposed; call commitWrite() with what was filled in.
+    size_t getWriteRegions(size_t count, T** data1, size_t* size1, T** data2, size_t* size2) {
+        const size_t w = writeIndex_.load(std::memory_order_relaxed);
+        count = std::min(count, writeAvailable());
+        const size_t pos = w % capacity_;
+        *data1 = buffer_ + pos;
+        *size1 = std::min(count, capacity_ - pos);
+        *data2 = buffer_;
+        *size2 = count - *size1;
+        return count;
+    }
+
+    void commitWrite(size_t count) {
+        writeIndex_.store(advance(writeIndex_.load(std::memory_order_relaxed), count), std::memory_order_release);
+    }
+
+    // Zero-copy read counterpart of getWriteRegions(); finish with commitRead().
+    size_t getReadRegions(size_t count, const T** data1, size_t* size1, const T** data2, size_t* size2) {
+        const size_t r = readIndex_.load(std::memory_order_relaxed);
+        count = std::min(count, readAvailable());
+        const size_t pos = r % capacity_;
+        *data1 = buffer_ + pos;
+        *size1 = std::min(count, capacity_ - pos);
+        *data2 = buffer_;
+        *size2 = count - *size1;
+        return count;
+    }
+
+    void commitRead(size_t count) {
+        readIndex_.store(advance(readIndex_.load(std::memory_order_relaxed), count), std::memory_order_release);
+    }
+
+private:
+    static T* alignStorage(T* p) {
+        const uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+        const uintptr_t aligned = (addr + CACHE_LINE_SIZE - 1) & ~static_cast<uintptr_t>(CACHE_LINE_SIZE - 1);
+        return reinterpret_cast<T*>(aligned);
+    }
+
+    size_t distance(size_t from, size_t to) const {
+        return (to >= from) ? (to - from) : (to + 2 * capacity_ - from);
+    }
+
+    size_t advance(size_t index, size_t count) const {
+        index += count;
+        return (index >= 2 * capacity_) ? (index - 2 * capacity_) : index;
+    }
+
+    std::vector<T> storage_; // Over-allocated so buffer_ can start on a cache line
+    T* buffer_;
+    const size_t capacity_;
+
+    // Keep the two indices on separate cache lines so the producer and the
+    // consumer don't keep stealing the line from each other.
+    char pad0_[64];
+    std::atomic<size_t> writeIndex_;
+    char pad1_[64];
+    std::atomic<size_t> readIndex_;
+    char pad2_[64];
+};
+
+#endif // SPSC_RING_BUFFER_H
@@ -0,0 +1,45 @@
+#include "TransmitGate.h"
+#include <algorithm>
+
+TransmitGate::TransmitGate(double frameMs, float voiceThreshold, int hangoverMs, int keepaliveMs)
+    : frameUs_(static_cast<long long>(frameMs * 1000.0 + 0.5)),
+    voiceThreshold_(voiceThreshold),
+    hangoverUs_(hangoverMs * 1000LL),
+    keepaliveUs_(keepaliveMs * 1000LL),
+    holdUs_(0),
+    sinceSentUs_(0),
+    active_(true),
+    keepaliveDue_(false),
+    lastSent_(false),
+    sentCount_(0),
+    suppressedCount_(0)
+{
+}
+
+bool TransmitGate::shouldEncode(float voiceProbability) {
+    if (voiceProbability >= voiceThreshold_) {
+        holdUs_ = hangoverUs_;
+    }
+    else {
+        holdUs_ = std::max(0LL, holdUs_ - frameUs_);
+    }
+    active_ = voiceProbability >= voiceThreshold_ || holdUs_ > 0;
+    keepaliveDue_ = sinceSentUs_ + frameUs_ >= keepaliveUs_;
+    return active_ || keepaliveDue_;
+}
+
+bool TransmitGate::shouldSend(int packetBytes) const {
+    return (active_ && packetBytes > DTX_PACKET_BYTES) || keepaliveDue_;
+}
+
+void TransmitGate::frameDone(bool sent) {
+    if (sent) {
+        sinceSentUs_ = 0;
+        ++sentCount_;
+    }
+    else {
+        sinceSentUs_ += frameUs_;
+        ++suppressedCount_;
+    }
+    lastSent_ = sent;
+}
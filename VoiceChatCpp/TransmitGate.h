@@ -0,0 +1,47 @@
+#ifndef TRANSMIT_GATE_H
+#define TRANSMIT_GATE_H
+
+// Decides, frame by frame, whether the capture thread encodes and sends at all.
+//
+// Two signals close the gate: the RNNoise voice probability (when the denoiser
+// runs) and Opus DTX, which shrinks frames the encoder considers silent to a
+// byte or two. The gate stays open for hangoverMs after the last voiced frame
+// so word endings aren't clipped, and while closed it still lets one frame
+// through every keepaliveMs so receivers (and NATs) know the stream is alive.
+// Frames that aren't sent still advance the RTP timestamp, and the first one
+// sent after a gap carries the marker bit, as RFC 3550/7587 expect.
+class TransmitGate {
+public:
+    TransmitGate(double frameMs, float voiceThreshold, int hangoverMs, int keepaliveMs);
+
+    // Before encoding a frame: false means skip it entirely (no encode, no send).
+    bool shouldEncode(float voiceProbability);
+    // After encoding: false means the packet is a DTX frame nobody needs.
+    bool shouldSend(int packetBytes) const;
+    // The frame about to be sent follows a gap (set the RTP marker bit).
+    bool resuming() const { return !lastSent_; }
+    // Report what happened to the frame, once per frame.
+    void frameDone(bool sent);
+
+    unsigned long long sentCount() const { return sentCount_; }
+    unsigned long long suppressedCount() const { return suppressedCount_; }
+
+private:
+    // Opus DTX frames are at most this big (TOC byte plus nothing, or plus one).
+    static const int DTX_PACKET_BYTES = 2;
+
+    const long long frameUs_;
+    const float voiceThreshold_;
+    const long long hangoverUs_;
+    const long long keepaliveUs_;
+
+    long long holdUs_;      // Hangover left
+    long long sinceSentUs_; // Time since the last packet went out
+    bool active_;           // Voice, or still in hangover
+    bool keepaliveDue_;
+    bool lastSent_;
+    unsigned long long sentCount_;
+    unsigned long long suppressedCount_;
+};
+
+#endif // TRANSMIT_GATE_H
@@ -16,6 +16,8 @@
 #include <chrono>
 #include <vector>
 #include <stdexcept>
+#include <memory>
+#include <algorithm>
 #include <objbase.h>
 
 
@@ -24,31 +26,84 @@
 #include "AudioCapture.h"
 #include "AudioPlayback.h"
 #include "NetworkSender.h"
-#include "NetworkReceiver.h"
+#include "NetworkReactor.h"
+#include "NetworkSenderMulticast.h"
 #include "AudioCodec.h" // For Opus
 #include "PacketQueue.h" // A thread-safe queue for audio packets
-
-// Global queues for inter-thread communication
-PacketQueue<std::vector<unsigned char>> sendQueue; // Raw audio frames or encoded packets
-PacketQueue<std::vector<unsigned char>> recvQueue; // Received network packets
+#include "MediaPacket.h"
+#include "RtpPacket.h"
+#include "JitterBuffer.h"
+#include "RemoteStream.h"
+#include "FrameAdapter.h"
+#include "PacketBuffer.h"
+#include "PolyphaseResampler.h"
+#include "Denoiser.h"
+#include "TransmitGate.h"
+
+// Bounds for the adaptive playout delay chosen by the jitter buffers.
+const int JITTER_MIN_DELAY_MS = 0;
+const int JITTER_MAX_DELAY_MS = 200;
+// A remote talker that sends nothing for this long is forgotten.
+const std::chrono::milliseconds STREAM_IDLE_TIMEOUT(5000);
+// Transmit gate: RNNoise voice probability that counts as speech, how long to
+// keep sending after it, and how often a silent sender still sends one frame
+// (well inside STREAM_IDLE_TIMEOUT; 400 ms is the cadence Opus DTX itself uses).
+const float GATE_VOICE_THRESHOLD = 0.5f;
+const int GATE_HANGOVER_MS = 300;
+const int GATE_KEEPALIVE_MS = 400;
+
+// Every datagram sent or received lives in one of these buffers, from the
+// encoder to sendto() and from the socket to the decoder; nothing is copied
+// or allocated per packet on the way. 4 KB each.
+const size_t PACKET_POOL_SIZE = 1024;
+// Most packets the sender thread takes from sendQueue per sendBatch().
+const size_t SEND_BATCH_SIZE = 64;
+
+PacketPool packetPool(PACKET_POOL_SIZE); // Declared first: it must outlive the queue's packets
+
+// Global queues for inter-thread communication. A queued packet holds a pool
+// buffer, so the queue can never need more slots than the pool has.
+PacketQueue<PacketBuffer> sendQueue(PACKET_POOL_SIZE); // RTP packets ready to send
 
 // Example configuration (you'd make this dynamic)
-int SAMPLE_RATE_ENCODE = 48000;
+int CAPTURE_DEVICE_RATE = 48000;  // What the devices run at...
+int PLAYBACK_DEVICE_RATE = 48000;
+int SAMPLE_RATE_ENCODE = 48000;   // ...and what Opus runs at; PolyphaseResampler bridges the two
 int SAMPLE_RATE_DECODE = 48000;
 int INPUT_NUM_CHANNELS = 2; // Mono input
 int OUTPUT_NUM_CHANNELS = 2; // Stereo output (for playback)
 int FRAMES_PER_BUFFER = 240; // 10ms of audio at 48kHz
 // For ultra-low latency, could go to 240 (5ms) or 120 (2.5ms)
 int BITRATE = 64000;       // Opus bitrate (20kbps is good for speech)
+int DRED_DURATION_MS = 0;  // Opus Deep REDundancy per packet, 0 = off (optional 4th line of ip.txt)
+double OPUS_FRAME_MS = 10; // Opus frame length, independent of FRAMES_PER_BUFFER (optional 5th line)
+int DENOISE = 0;           // 1 = run RNNoise on the microphone before encoding (optional 6th line)
+int TRANSMIT_GATE = 1;     // 1 = stop sending during silence (DTX, plus RNNoise VAD if DENOISE) (optional 7th line)
+std::string MULTICAST_GROUPS; // Comma-separated groups to also listen to on LISTEN_PORT, "-" = none;
+                              // "source@group" only takes that sender's traffic (optional 8th line)
+std::string MULTICAST_INTERFACE; // Interface name or index for multicast, "-" = the system's choice (optional 9th line)
+int MULTICAST_TTL = 1;      // Routers that multicast sent to a TARGET_IP group may cross (optional 10th line)
+int MULTICAST_LOOPBACK = 1; // 1 = multicast we send also reaches listeners on this machine (optional 11th line)
+int AUDIO_BANDWIDTH_HZ = 4000; // Audio the encoder keeps: 4000 (narrowband), 6000, 8000, 12000 or 20000 Hz (optional 12th line)
 
 // Target IP address and port for destination (hardcoded for simplicity)
 // In a real app, this would come from a discovery mechanism
 // *** IMPORTANT: Change these IPs to the actual IP addresses of your LAN computers! ***
-std::string TARGET_IP = "192.168.1.34"; // Replace with actual peer IP
+std::string TARGET_IP = "192.168.1.34"; // Replace with actual peer IP; comma-separated to send to several
 const unsigned short TARGET_PORT = 12345;
 const unsigned short LISTEN_PORT = 12345;
 
 
+// Opus only takes 8/12/16/24/48 kHz; any other device rate is resampled to 48 kHz.
+int opusSampleRateFor(int deviceRate) {
+    switch (deviceRate) {
+    case 8000: case 12000: case 16000: case 24000: case 48000:
+        return deviceRate;
+    default:
+        return 48000;
+    }
+}
+
 int getsamplerates() {
 
     // Initialize COM before using PortAudio on Windows with WASAPI
@@ -76,12 +131,13 @@ int getsamplerates() {
         return 1;
     }
 
-    SAMPLE_RATE_ENCODE = static_cast<int>(inputInfo->defaultSampleRate);
+    CAPTURE_DEVICE_RATE = static_cast<int>(inputInfo->defaultSampleRate);
+    SAMPLE_RATE_ENCODE = opusSampleRateFor(CAPTURE_DEVICE_RATE);
     INPUT_NUM_CHANNELS = inputInfo->maxInputChannels;
 
     std::cout << "   Default Microphone:" << std::endl;
     std::cout << "   Name: " << inputInfo->name << std::endl;
-    std::cout << "   Default Sample Rate: " << SAMPLE_RATE_ENCODE << std::endl;
+    std::cout << "   Default Sample Rate: " << CAPTURE_DEVICE_RATE << std::endl;
     std::cout << "   Max Input Channels: " << INPUT_NUM_CHANNELS << std::endl;
 
 
@@ -97,15 +153,17 @@ int getsamplerates() {
         return 1;
     }
 
-    SAMPLE_RATE_DECODE = static_cast<int>(outputInfo->defaultSampleRate);
+    PLAYBACK_DEVICE_RATE = static_cast<int>(outputInfo->defaultSampleRate);
+    SAMPLE_RATE_DECODE = opusSampleRateFor(PLAYBACK_DEVICE_RATE);
     OUTPUT_NUM_CHANNELS = outputInfo->maxOutputChannels;
 
     std::cout << "   Default Speaker:" << std::endl;
     std::cout << "   Name: " << outputInfo->name << std::endl;
-    std::cout << "   Default Sample Rate: " << SAMPLE_RATE_DECODE << std::endl;
+    std::cout << "   Default Sample Rate: " << PLAYBACK_DEVICE_RATE << std::endl;
     std::cout << "   Max Output Channels: " << outputInfo->maxOutputChannels << std::endl;
 
-	SAMPLE_RATE_DECODE = SAMPLE_RATE_ENCODE; // For simplicity, use the same sample rate for encoding and decoding
+    // Each device keeps its native rate; the resamplers in the capture and
+    // playback threads convert to and from the Opus rates chosen above.
 
 }
 
@@ -125,6 +183,35 @@ int main() {
     configFile >> FRAMES_PER_BUFFER;
     configFile >> BITRATE;
     configFile >> TARGET_IP;
+    if (!(configFile >> DRED_DURATION_MS)) {
+        DRED_DURATION_MS = 0;
+    }
+    else if (!(configFile >> OPUS_FRAME_MS)) {
+        OPUS_FRAME_MS = 10;
+    }
+    else if (!(configFile >> DENOISE)) {
+        DENOISE = 0;
+    }
+    else if (!(configFile >> TRANSMIT_GATE)) {
+        TRANSMIT_GATE = 1;
+    }
+    else if (!(configFile >> MULTICAST_GROUPS)) {
+        MULTICAST_GROUPS.clear();
+    }
+    else if (!(configFile >> MULTICAST_INTERFACE)) {
+        MULTICAST_INTERFACE.clear();
+    }
+    else if (!(configFile >> MULTICAST_TTL)) {
+        MULTICAST_TTL = 1;
+    }
+    else if (!(configFile >> MULTICAST_LOOPBACK)) {
+        MULTICAST_LOOPBACK = 1;
+    }
+    else if (!(configFile >> AUDIO_BANDWIDTH_HZ)) {
+        AUDIO_BANDWIDTH_HZ = 4000;
+    }
+    if (MULTICAST_GROUPS == "-") MULTICAST_GROUPS.clear();
+    if (MULTICAST_INTERFACE == "-") MULTICAST_INTERFACE.clear();
     //std::getline(inputFile, TARGET_IP);
 
 
@@ -139,24 +226,58 @@ int main() {
    // std::cout << "  NUM_CHANNELS = " << NUM_CHANNELS << "\n";
     std::cout << "  BITRATE = " << BITRATE << "\n";
     std::cout << "  TARGET_IP = " << TARGET_IP << "\n";
+    std::cout << "  DRED_DURATION_MS = " << DRED_DURATION_MS << "\n";
+    std::cout << "  OPUS_FRAME_MS = " << OPUS_FRAME_MS << "\n";
+    std::cout << "  DENOISE = " << DENOISE << "\n";
+    std::cout << "  TRANSMIT_GATE = " << TRANSMIT_GATE << "\n";
+    std::cout << "  MULTICAST_GROUPS = " << (MULTICAST_GROUPS.empty() ? "-" : MULTICAST_GROUPS) << "\n";
+    std::cout << "  MULTICAST_INTERFACE = " << (MULTICAST_INTERFACE.empty() ? "-" : MULTICAST_INTERFACE) << "\n";
+    std::cout << "  MULTICAST_TTL = " << MULTICAST_TTL << "\n";
+    std::cout << "  MULTICAST_LOOPBACK = " << MULTICAST_LOOPBACK << "\n";
+    std::cout << "  AUDIO_BANDWIDTH_HZ = " << AUDIO_BANDWIDTH_HZ << "\n";
+
+    // The encoder runs at the lowest rate that carries the audio it keeps (no
+    // higher than the microphone's), so capture is resampled straight to that
+    // and the denoiser only works on what is sent: 8 kHz for narrowband.
+    const int bandwidthRate = AudioEncoder::sampleRateForBandwidth(AUDIO_BANDWIDTH_HZ);
+    if (bandwidthRate < 0) {
+        std::cerr << "Error: Opus can't limit audio to " << AUDIO_BANDWIDTH_HZ << " Hz\n";
+        return 1;
+    }
+    SAMPLE_RATE_ENCODE = std::min(SAMPLE_RATE_ENCODE, bandwidthRate);
+    // RNNoise has 8, 16 and 48 kHz modes only; at 12 or 24 kHz both run at
+    // the next of those up, and the encoder still keeps to its bandwidth.
+    if (DENOISE && !Denoiser::supportsSampleRate(SAMPLE_RATE_ENCODE)) {
+        SAMPLE_RATE_ENCODE = SAMPLE_RATE_ENCODE < 16000 ? 16000 : 48000;
+    }
+
+    // The device period (FRAMES_PER_BUFFER) can be anything the hardware likes;
+    // the capture thread re-blocks it into Opus frames of this size.
+    const int OPUS_FRAME_SIZE = AudioEncoder::frameSizeFor(SAMPLE_RATE_ENCODE, OPUS_FRAME_MS);
+    if (OPUS_FRAME_SIZE < 0) {
+        std::cerr << "Error: Opus can't use " << OPUS_FRAME_MS << " ms frames at " << SAMPLE_RATE_ENCODE << " Hz\n";
+        return 1;
+    }
 
   
 
     // Initialize modules (basic error checking)
+    // The encoder belongs to the capture thread; each remote talker gets its own
+    // decoder (and jitter buffer) when its first packet arrives.
+    AudioEncoder encoder;
     try {
-        if (!AudioCodec::initializeEncoder(SAMPLE_RATE_ENCODE, INPUT_NUM_CHANNELS, BITRATE)) {
-            std::cerr << "Failed to initialize Opus encoder.\n";
-            return 1;
-        }
-        if (!AudioCodec::initializeDecoder(SAMPLE_RATE_DECODE, OUTPUT_NUM_CHANNELS)) {
-            std::cerr << "Failed to initialize Opus decoder.\n";
-            return 1;
+        encoder = AudioEncoder(SAMPLE_RATE_ENCODE, INPUT_NUM_CHANNELS, BITRATE, AUDIO_BANDWIDTH_HZ);
+        if (DRED_DURATION_MS > 0 && !encoder.setDredDuration(DRED_DURATION_MS)) {
+            DRED_DURATION_MS = 0; // This libopus has no DRED; carry on with FEC and PLC only
         }
+        encoder.setDtx(TRANSMIT_GATE != 0);
     }
     catch (const std::exception& e) {
         std::cerr << "Initialization error: " << e.what() << std::endl;
         return 1;
     }
+    RemoteStreamSet remoteStreams(SAMPLE_RATE_DECODE, OUTPUT_NUM_CHANNELS, RTP_OPUS_CLOCK_RATE,
+        JITTER_MIN_DELAY_MS, JITTER_MAX_DELAY_MS, STREAM_IDLE_TIMEOUT, DRED_DURATION_MS);
 
 
     // --- Create and start threads ---
@@ -166,20 +287,79 @@ int main() {
         try {
 
           
-            AudioCapture capture(SAMPLE_RATE_ENCODE, FRAMES_PER_BUFFER, INPUT_NUM_CHANNELS);
+            AudioCapture capture(CAPTURE_DEVICE_RATE, FRAMES_PER_BUFFER, INPUT_NUM_CHANNELS);
             if (!capture.start()) {
                 std::cerr << "Failed to start audio capture.\n";
                 return;
             }
             std::cout << "Audio capture started.\n";
+            PolyphaseResampler resampler(CAPTURE_DEVICE_RATE, SAMPLE_RATE_ENCODE, INPUT_NUM_CHANNELS);
+            if (!resampler.passthrough()) {
+                std::cout << "Capture resampling " << CAPTURE_DEVICE_RATE << " -> " << SAMPLE_RATE_ENCODE
+                    << " Hz (" << resampler.kernelName() << "), group delay " << resampler.groupDelayMs() << " ms\n";
+            }
+            // RNNoise cleans the signal before it is encoded, so fan and keyboard
+            // noise doesn't eat into the bitrate.
+            std::unique_ptr<Denoiser> denoiser;
+            if (DENOISE) {
+                try {
+                    denoiser.reset(new Denoiser(SAMPLE_RATE_ENCODE, INPUT_NUM_CHANNELS));
+                    std::cout << "Denoising the microphone with RNNoise at " << SAMPLE_RATE_ENCODE << " Hz.\n";
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Denoiser disabled: " << e.what() << std::endl;
+                }
+            }
+            // Reused for every period, so encoding doesn't allocate once running.
+            std::vector<float> audioData;
+            std::vector<float> resampled;
+            std::vector<float> denoised;
+            FrameAdapter frameAdapter(static_cast<size_t>(OPUS_FRAME_SIZE) * INPUT_NUM_CHANNELS);
+            RtpPacketizer packetizer(SAMPLE_RATE_ENCODE);
+            std::cout << "Sending RTP stream, SSRC " << packetizer.ssrc() << "\n";
+            // Without the denoiser there is no VAD and every frame counts as voice,
+            // leaving Opus DTX alone to decide what is silence.
+            TransmitGate gate(OPUS_FRAME_MS, TRANSMIT_GATE ? GATE_VOICE_THRESHOLD : 0.0f,
+                GATE_HANGOVER_MS, GATE_KEEPALIVE_MS);
+            float voiceProbability = 1.0f;
+            auto encodeFrame = [&](const float* frame) {
+                bool sent = false;
+                // Frames the gate rejects up front aren't even encoded.
+                // The packet is encoded in place behind room for its RTP header.
+                PacketBuffer packet = gate.shouldEncode(voiceProbability) ? packetPool.acquire() : PacketBuffer();
+                if (packet.valid()) {
+                    int maxLen = static_cast<int>(std::min<size_t>(packet.capacity() - RTP_HEADER_SIZE, AudioEncoder::MAX_PACKET_SIZE));
+                    int len = encoder.encodeInto(frame, OPUS_FRAME_SIZE,
+                        packet.data() + RTP_HEADER_SIZE, maxLen);
+                    if (len > 0 && gate.shouldSend(len)) {
+                        // The marker bit tells receivers a talk-spurt starts here.
+                        packetizer.packetizeInPlace(packet, static_cast<size_t>(len),
+                            OPUS_FRAME_SIZE, gate.resuming());
+                        sendQueue.push(std::move(packet));
+                        sent = true;
+                    }
+                }
+                if (!sent) {
+                    packetizer.skip(OPUS_FRAME_SIZE); // The media clock runs even if a frame isn't sent
+                }
+                gate.frameDone(sent);
+            };
             while (true) { // Loop indefinitely (add a stop condition for a real app)
-                std::vector<float> audioData = capture.readBlocking();
-                if (!audioData.empty()) {
-                    // Encode and push to send queue (simplified, might need separate thread for encoding)
-                    std::vector<unsigned char> encodedPacket = AudioCodec::encode(audioData);
-                    if (!encodedPacket.empty()) {
-                        sendQueue.push(encodedPacket);
+                if (capture.readBlocking(audioData)) {
+                    const std::vector<float>* pcm = &audioData;
+                    if (!resampler.passthrough()) {
+                        resampler.process(*pcm, resampled);
+                        pcm = &resampled;
+                    }
+                    if (denoiser) {
+                        denoiser->process(pcm->data(), pcm->size(), denoised);
+                        pcm = &denoised;
+                        if (TRANSMIT_GATE) {
+                            voiceProbability = denoiser->voiceProbability();
+                        }
                     }
+                    // One device period may complete zero, one or several Opus frames.
+                    frameAdapter.push(pcm->data(), pcm->size(), encodeFrame);
                 }
             }
             capture.stop();
@@ -192,12 +372,43 @@ int main() {
     // 2. Network Send Thread
     std::thread senderThread([&]() {
         try {
-            NetworkSender sender(TARGET_IP, TARGET_PORT);
-            std::cout << "Network sender started.\n";
+            // One sender per target; they all send the same pooled buffers.
+            MulticastOptions multicastOptions;
+            multicastOptions.interfaceName = MULTICAST_INTERFACE;
+            multicastOptions.ttl = MULTICAST_TTL;
+            multicastOptions.loopback = MULTICAST_LOOPBACK != 0;
+            std::vector<std::unique_ptr<NetworkSender>> senders;
+            std::vector<std::unique_ptr<NetworkSenderMulticast>> multicastSenders; // Targets that are groups
+            size_t start = 0;
+            while (start < TARGET_IP.size()) {
+                size_t end = TARGET_IP.find(',', start);
+                if (end == std::string::npos) end = TARGET_IP.size();
+                std::string target = TARGET_IP.substr(start, end - start);
+                if (MulticastGroup::isMulticast(target)) {
+                    multicastSenders.emplace_back(new NetworkSenderMulticast(target, TARGET_PORT, multicastOptions));
+                }
+                else if (!target.empty()) {
+                    senders.emplace_back(new NetworkSender(target, TARGET_PORT));
+                }
+                start = end + 1;
+            }
+            std::cout << "Network sender started, " << senders.size() + multicastSenders.size() << " target(s).\n";
+            std::vector<PacketBuffer> packets;
+            packets.reserve(SEND_BATCH_SIZE);
+            PacketBuffer packet;
             while (true) {
-                std::vector<unsigned char> packet = sendQueue.pop(); // Blocks until data available
-                if (!packet.empty()) {
-                    sender.sendPacket(packet);
+                // Whatever queued up behind the first packet goes out with it in
+                // one sendBatch().
+                packets.clear(); // Returns the last batch's buffers to the pool
+                packets.push_back(sendQueue.pop()); // Blocks until data available
+                while (packets.size() < SEND_BATCH_SIZE && sendQueue.try_pop(packet)) {
+                    packets.push_back(std::move(packet));
+                }
+                for (const auto& sender : senders) {
+                    sender->sendBatch(packets.data(), packets.size());
+                }
+                for (const auto& sender : multicastSenders) {
+                    sender->sendBatch(packets.data(), packets.size());
                 }
             }
         }
@@ -206,22 +417,44 @@ int main() {
         }
         });
 
-    // 3. Network Receive Thread
+    // 3. Network Receive Thread: one reactor for the unicast port and every
+    // multicast group, however many there are.
     std::thread receiverThread([&]() {
         try {
-            NetworkReceiver receiver(LISTEN_PORT);
-            if (!receiver.start()) {
+            NetworkReactor reactor(packetPool);
+            auto onPacket = [&](PacketBuffer&& datagram) {
+                MediaPacket mediaPacket; // Its payload keeps the datagram's buffer
+                if (RtpDepacketizer::depacketize(datagram, mediaPacket)) {
+                    int frames = AudioDecoder::getFrameCount(mediaPacket.payload.data(), mediaPacket.payload.size(), RTP_OPUS_CLOCK_RATE);
+                    if (frames > 0) {
+                        mediaPacket.duration = static_cast<uint32_t>(frames);
+                        remoteStreams.push(std::move(mediaPacket)); // Demultiplexed by SSRC
+                    }
+                }
+            };
+            if (reactor.addUnicast(LISTEN_PORT, onPacket) < 0) {
                 std::cerr << "Failed to start network receiver.\n";
                 return;
             }
-            std::cout << "Network receiver started.\n";
-            while (true) {
-                std::vector<unsigned char> packet = receiver.receivePacketBlocking();
-                if (!packet.empty()) {
-                    recvQueue.push(packet);
+            size_t start = 0;
+            while (start < MULTICAST_GROUPS.size()) {
+                size_t end = MULTICAST_GROUPS.find(',', start);
+                if (end == std::string::npos) end = MULTICAST_GROUPS.size();
+                std::string group = MULTICAST_GROUPS.substr(start, end - start);
+                MulticastOptions options;
+                options.interfaceName = MULTICAST_INTERFACE;
+                size_t at = group.find('@');
+                if (at != std::string::npos) {
+                    options.source = group.substr(0, at);
+                    group = group.substr(at + 1);
                 }
+                if (!group.empty() && reactor.addMulticast(group, LISTEN_PORT, onPacket, options) < 0) {
+                    std::cerr << "Not listening to multicast group " << group << "\n";
+                }
+                start = end + 1;
             }
-            receiver.stop();
+            std::cout << "Network receiver started on " << reactor.streamCount() << " socket(s).\n";
+            reactor.run();
         }
         catch (const std::exception& e) {
             std::cerr << "Network receiver thread error: " << e.what() << std::endl;
@@ -231,19 +464,127 @@ int main() {
     // 4. Audio Playback Thread
     std::thread playbackThread([&]() {
         try {
-            AudioPlayback playback(SAMPLE_RATE_DECODE, FRAMES_PER_BUFFER, OUTPUT_NUM_CHANNELS);
+            // The ring must take the longest Opus frame in one piece, resampled to
+            // the device rate (plus a frame of resampler rounding).
+            const int maxFrameFrames = static_cast<int>(static_cast<int64_t>(AudioDecoder::maxFrameSizeFor(SAMPLE_RATE_DECODE))
+                * PLAYBACK_DEVICE_RATE / SAMPLE_RATE_DECODE) + 1;
+            AudioPlayback playback(PLAYBACK_DEVICE_RATE, FRAMES_PER_BUFFER, OUTPUT_NUM_CHANNELS, maxFrameFrames);
             if (!playback.start()) {
                 std::cerr << "Failed to start audio playback.\n";
                 return;
             }
             std::cout << "Audio playback started.\n";
+            PolyphaseResampler resampler(SAMPLE_RATE_DECODE, PLAYBACK_DEVICE_RATE, OUTPUT_NUM_CHANNELS);
+            if (!resampler.passthrough()) {
+                std::cout << "Playback resampling " << SAMPLE_RATE_DECODE << " -> " << PLAYBACK_DEVICE_RATE
+                    << " Hz (" << resampler.kernelName() << "), group delay " << resampler.groupDelayMs() << " ms\n";
+            }
+            // Decoding straight into the ring only works when no rate conversion is needed.
+            const bool direct = resampler.passthrough();
+            const size_t periodSamples = static_cast<size_t>(FRAMES_PER_BUFFER) * OUTPUT_NUM_CHANNELS;
+            const size_t mixSamples = static_cast<size_t>(
+                static_cast<int64_t>(FRAMES_PER_BUFFER) * SAMPLE_RATE_DECODE / PLAYBACK_DEVICE_RATE) * OUTPUT_NUM_CHANNELS;
+            const auto frameTime = std::chrono::milliseconds(std::max(1, 1000 * FRAMES_PER_BUFFER / PLAYBACK_DEVICE_RATE));
+            std::vector<float> scratch;
+            std::vector<float> resampled;
+            std::vector<float> mix(mixSamples);
+            // Each frame waits for room for all of it, so none is cut short.
+            auto play = [&](const std::vector<float>& pcm) {
+                if (direct) {
+                    playback.waitForSpace(pcm.size());
+                    playback.playBlocking(pcm);
+                    return;
+                }
+                resampler.process(pcm, resampled);
+                playback.waitForSpace(resampled.size());
+                playback.playBlocking(resampled);
+            };
+            std::vector<std::shared_ptr<RemoteStream>> streams;
+            MediaPacket packet;
             while (true) {
-                std::vector<unsigned char> encodedPacket = recvQueue.pop(); // Blocks
-                if (!encodedPacket.empty()) {
-                    std::vector<float> decodedAudio = AudioCodec::decode(encodedPacket);
-                    if (!decodedAudio.empty()) {
-                        playback.playBlocking(decodedAudio);
+                // Only pull the next frame when the device is about to run dry, so the
+                // playout delay lives in the jitter buffers and not in the playback ring.
+                playback.waitForRoom(periodSamples);
+
+                remoteStreams.snapshot(streams);
+                if (streams.empty()) {
+                    remoteStreams.waitForStream(frameTime);
+                    continue;
+                }
+
+                if (streams.size() > 1 || streams[0]->pendingPos < streams[0]->pending.size()) {
+                    // Several talkers: each decodes with its own decoder, one device
+                    // period from every stream is summed into the output.
+                    std::fill(mix.begin(), mix.end(), 0.0f);
+                    bool any = false;
+                    for (const auto& stream : streams) {
+                        any = stream->mixInto(mix.data(), mixSamples) || any;
+                    }
+                    if (any) {
+                        play(mix);
+                    }
+                    else {
+                        std::this_thread::sleep_for(frameTime);
+                    }
+                    continue;
+                }
+
+                RemoteStream& stream = *streams[0];
+                switch (stream.jitterBuffer.pop(packet)) {
+                case JitterBuffer::Result::Packet: {
+                    // Decode straight into the playback ring when there is room for the
+                    // whole frame; otherwise go through a temporary buffer.
+                    int frames = stream.decoder.getFrameCount(packet.payload.data(), packet.payload.size());
+                    size_t samples = (frames > 0) ? static_cast<size_t>(frames) * OUTPUT_NUM_CHANNELS : 0;
+                    if (direct && samples > 0) {
+                        playback.waitForSpace(samples);
                     }
+                    float* slot = (direct && samples > 0) ? playback.acquireWrite(samples) : nullptr;
+                    if (slot) {
+                        int decoded = stream.decoder.decodeInto(packet.payload.data(), packet.payload.size(), slot, frames);
+                        if (decoded > 0) {
+                            playback.commitWrite(static_cast<size_t>(decoded) * OUTPUT_NUM_CHANNELS);
+                        }
+                        break;
+                    }
+                    scratch.resize(static_cast<size_t>(stream.decoder.maxFrameSize()) * OUTPUT_NUM_CHANNELS);
+                    int decoded = stream.decoder.decodeInto(packet.payload.data(), packet.payload.size(),
+                        scratch.data(), stream.decoder.maxFrameSize());
+                    if (decoded > 0) {
+                        scratch.resize(static_cast<size_t>(decoded) * OUTPUT_NUM_CHANNELS);
+                        play(scratch);
+                    }
+                    break;
+                }
+                case JitterBuffer::Result::Lost: {
+                    // Keep the timeline intact: a missing frame is rebuilt from the FEC or
+                    // DRED of a later packet if one is already here, otherwise concealed (PLC).
+                    int frames = static_cast<int>(
+                        static_cast<int64_t>(packet.duration) * SAMPLE_RATE_DECODE / RTP_OPUS_CLOCK_RATE);
+                    int nextOffset = static_cast<int>(
+                        static_cast<int64_t>(packet.nextOffset) * SAMPLE_RATE_DECODE / RTP_OPUS_CLOCK_RATE);
+                    size_t samples = static_cast<size_t>(frames) * OUTPUT_NUM_CHANNELS;
+                    const unsigned char* next = packet.payload.empty() ? nullptr : packet.payload.data();
+                    if (direct && samples > 0) {
+                        playback.waitForSpace(samples);
+                    }
+                    float* slot = (direct && samples > 0) ? playback.acquireWrite(samples) : nullptr;
+                    if (slot) {
+                        int concealed = stream.decoder.concealInto(next, packet.payload.size(), nextOffset, slot, frames);
+                        if (concealed < 0) {
+                            std::fill(slot, slot + samples, 0.0f); // Silence as a last resort
+                        }
+                        playback.commitWrite(samples);
+                        break;
+                    }
+                    scratch.assign(samples, 0.0f);
+                    stream.decoder.concealInto(next, packet.payload.size(), nextOffset, scratch.data(), frames);
+                    play(scratch);
+                    break;
+                }
+                case JitterBuffer::Result::Empty:
+                    stream.jitterBuffer.wait(frameTime);
+                    break;
                 }
             }
             playback.stop();
@@ -260,8 +601,6 @@ int main() {
     receiverThread.join();
     playbackThread.join();
 
-    AudioCodec::cleanupEncoder();
-    AudioCodec::cleanupDecoder();
 	Pa_Terminate(); // Terminate PortAudio if used
 
     std::cout << "System shutdown.\n";
@@ -0,0 +1,172 @@
+// Loopback benchmark of the UDP transports: receiving with recvfrom
+// (NetworkReceiver::receivePacketBlocking), recvmmsg (receiveBatch) and
+// io_uring (NetworkReceiverUring::receive), then sending with sendto,
+// sendmmsg and io_uring. Linux only; not part of the Visual Studio project.
+//
+//   g++ -std=c++14 -O2 -I.. UdpReceiveBench.cpp ../NetworkReceiver.cpp ../NetworkSender.cpp ../NetworkUring.cpp -o udp_bench -lpthread
+//   ./udp_bench [seconds per run] [payload bytes]
+//
+// Each receive run floods one port from another thread for the given time
+// and reports the packets the receiver got per second and its CPU time per
+// packet. Each send run sends to a port nobody reads, so only the sender's
+// cost is measured.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <time.h>
+#include "NetworkReceiver.h"
+#include "NetworkSender.h"
+#include "NetworkUring.h"
+
+namespace {
+
+const unsigned short BENCH_PORT = 23456;
+const unsigned short SINK_PORT = 23457; // A closed io_uring releases its socket asynchronously
+const unsigned char STOP_MARK = 0xFF; // First byte of the packets that end a receive run
+
+double threadCpuSeconds() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// receiveSome blocks for the next packets, returns how many arrived and
+// sets stop once it sees STOP_MARK.
+void benchReceive(const char* name, double seconds, size_t payload,
+    const std::function<size_t(bool& stop)>& receiveSome) {
+    std::atomic<bool> finished(false);
+    size_t received = 0;
+    double cpu = 0;
+    double wall = 0;
+
+    std::thread receiver([&]() {
+        bool stop = false;
+        double cpuStart = threadCpuSeconds();
+        auto start = std::chrono::steady_clock::now();
+        while (!stop) {
+            received += receiveSome(stop);
+        }
+        wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        cpu = threadCpuSeconds() - cpuStart;
+        finished = true;
+    });
+
+    NetworkSender sender("127.0.0.1", BENCH_PORT);
+    PacketBatch batch;
+    std::vector<unsigned char> packet(payload, 0);
+    while (!batch.full()) {
+        batch.append(packet.data(), packet.size());
+    }
+    size_t sent = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < end) {
+        sent += sender.sendBatch(batch);
+    }
+    packet[0] = STOP_MARK;
+    while (!finished) {
+        sender.sendPacket(packet);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    receiver.join();
+
+    std::printf("  %-10s %9.0f packets/s received (%5.1f%% of sent), %6.0f ns CPU per packet\n",
+        name, received / wall, 100.0 * received / sent, cpu * 1e9 / received);
+}
+
+void benchSend(const char* name, double seconds, const std::function<size_t()>& sendSome) {
+    double cpuStart = threadCpuSeconds();
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::duration<double>(seconds);
+    size_t sent = 0;
+    while (std::chrono::steady_clock::now() < end) {
+        sent += sendSome();
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpu = threadCpuSeconds() - cpuStart;
+    std::printf("  %-10s %9.0f packets/s sent, %6.0f ns CPU per packet\n", name, sent / wall, cpu * 1e9 / sent);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? std::atof(argv[1]) : 2.0;
+    size_t payload = argc > 2 ? static_cast<size_t>(std::atoi(argv[2])) : 160; // ~Opus 10 ms at 64 kbps plus RTP
+    if (payload < 1 || payload > PacketBatch::MAX_PACKET_SIZE) {
+        std::fprintf(stderr, "payload must be 1..%zu bytes\n", PacketBatch::MAX_PACKET_SIZE);
+        return 1;
+    }
+    std::printf("Receive, %zu-byte datagrams, %.1f s per run:\n", payload, seconds);
+
+    {
+        NetworkReceiver receiver(BENCH_PORT);
+        receiver.start();
+        benchReceive("recvfrom", seconds, payload, [&](bool& stop) -> size_t {
+            std::vector<unsigned char> packet = receiver.receivePacketBlocking();
+            stop = !packet.empty() && packet[0] == STOP_MARK;
+            return packet.empty() || stop ? 0 : 1;
+        });
+    }
+    {
+        NetworkReceiver receiver(BENCH_PORT);
+        receiver.start();
+        PacketBatch batch;
+        benchReceive("recvmmsg", seconds, payload, [&](bool& stop) -> size_t {
+            size_t count = receiver.receiveBatch(batch);
+            size_t data = 0;
+            for (size_t i = 0; i < count; ++i) {
+                if (batch.data(i)[0] == STOP_MARK) stop = true;
+                else ++data;
+            }
+            return data;
+        });
+    }
+    {
+        NetworkReceiverUring receiver(BENCH_PORT);
+        receiver.start();
+        if (!receiver.usingUring()) {
+            std::printf("  io_uring   unavailable here; skipped\n");
+        }
+        else {
+            benchReceive("io_uring", seconds, payload, [&](bool& stop) -> size_t {
+                size_t data = 0;
+                receiver.receive([&](const unsigned char* packet, size_t) {
+                    if (packet[0] == STOP_MARK) stop = true;
+                    else ++data;
+                });
+                return data;
+            });
+        }
+    }
+
+    std::printf("Send, %zu-byte datagrams, %.1f s per run:\n", payload, seconds);
+    NetworkReceiver sink(SINK_PORT); // Bound so the datagrams are queued and dropped, not refused
+    sink.start();
+    std::vector<unsigned char> packet(payload, 0);
+    {
+        NetworkSender sender("127.0.0.1", SINK_PORT);
+        benchSend("sendto", seconds, [&]() -> size_t { return sender.sendPacket(packet) ? 1 : 0; });
+    }
+    {
+        NetworkSender sender("127.0.0.1", SINK_PORT);
+        PacketBatch batch;
+        while (!batch.full()) batch.append(packet.data(), packet.size());
+        benchSend("sendmmsg", seconds, [&]() -> size_t { return sender.sendBatch(batch); });
+    }
+    {
+        NetworkSenderUring sender("127.0.0.1", SINK_PORT);
+        PacketBatch& batch = sender.registeredBatch();
+        batch.clear();
+        while (!batch.full()) batch.append(packet.data(), packet.size());
+        if (!sender.usingUring()) {
+            std::printf("  io_uring   unavailable here; skipped\n");
+        }
+        else {
+            benchSend("io_uring", seconds, [&]() -> size_t { return sender.sendBatch(batch); });
+        }
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+// Checks that NetworkReactor hands out each datagram in a buffer of its own:
+// payloads kept as slices (as RtpDepacketizer makes them and the jitter
+// buffer holds them) must still read back intact after later drains, and a
+// datagram too large for a pool buffer must be dropped rather than delivered
+// cut short. Uses UDP over loopback. Not part of the Visual Studio project;
+// exits 1 on failure.
+//
+//   g++ -std=c++14 -O2 -I.. NetworkReactorTest.cpp ../NetworkReactor.cpp ../MulticastGroup.cpp ../NetworkSender.cpp ../RtpPacket.cpp -o reactor_test
+//   ./reactor_test
+
+#include <cstdio>
+#include <vector>
+#include "MediaPacket.h"
+#include "NetworkReactor.h"
+#include "NetworkSender.h"
+#include "RtpPacket.h"
+
+namespace {
+
+const unsigned short TEST_PORT = 47321;
+const size_t PAYLOAD_SIZE = 100;
+const int WAIT_MS = 1000;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+    std::printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok) ++failures;
+}
+
+// Sends an RTP packet whose payload is PAYLOAD_SIZE copies of fill.
+void sendPayload(NetworkSender& sender, RtpPacketizer& packetizer, unsigned char fill) {
+    std::vector<unsigned char> payload(PAYLOAD_SIZE, fill);
+    std::vector<unsigned char> packet;
+    packetizer.packetize(payload.data(), payload.size(), 480, false, packet);
+    sender.sendPacket(packet);
+}
+
+bool payloadIs(const MediaPacket& packet, unsigned char fill) {
+    if (packet.payload.size() != PAYLOAD_SIZE) return false;
+    for (size_t i = 0; i < packet.payload.size(); ++i) {
+        if (packet.payload.data()[i] != fill) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    PacketPool pool(32);
+    NetworkReactor reactor(pool);
+    std::vector<MediaPacket> kept;
+    // The app's handler: the payload is a slice of the datagram's buffer, and
+    // the buffer itself is not moved from.
+    int id = reactor.addUnicast(TEST_PORT, [&](PacketBuffer&& datagram) {
+        MediaPacket packet;
+        if (RtpDepacketizer::depacketize(datagram, packet)) {
+            kept.push_back(packet);
+        }
+    });
+    if (id < 0) {
+        std::printf("can't listen on port %u\n", TEST_PORT);
+        return 2;
+    }
+    NetworkSender sender("127.0.0.1", TEST_PORT);
+    RtpPacketizer packetizer(48000);
+
+    // One datagram per drain, then several in one drain.
+    const unsigned char fills[] = { 'A', 'B', 'C', 'D', 'E', 'F' };
+    for (int i = 0; i < 3; ++i) {
+        sendPayload(sender, packetizer, fills[i]);
+        reactor.runOnce(WAIT_MS);
+    }
+    for (int i = 3; i < 6; ++i) {
+        sendPayload(sender, packetizer, fills[i]);
+    }
+    for (int tries = 0; tries < 3 && kept.size() < 6; ++tries) {
+        reactor.runOnce(WAIT_MS);
+    }
+    check(kept.size() == 6, "every datagram delivered");
+    bool intact = kept.size() == 6;
+    for (size_t i = 0; i < kept.size() && i < 6; ++i) {
+        intact = intact && payloadIs(kept[i], fills[i]);
+    }
+    check(intact, "kept payloads unchanged by later drains");
+
+    kept.clear();
+    std::vector<unsigned char> oversized(pool.bufferSize() + 100, 'X');
+    sender.sendPacket(oversized);
+    sendPayload(sender, packetizer, 'G');
+    for (int tries = 0; tries < 3 && kept.empty(); ++tries) {
+        reactor.runOnce(WAIT_MS);
+    }
+    check(reactor.droppedCount() == 1, "datagram larger than a buffer dropped");
+    check(kept.size() == 1 && payloadIs(kept[0], 'G'), "only the datagram that fit delivered");
+
+    if (failures) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+// Checks PolyphaseResampler's frequency response at the ratios the app uses:
+// tones in the passband must come through at full level, and whatever a
+// tone aliases or images to must be at least MAX_ALIAS_DB down. Not part of
+// the Visual Studio project; exits 1 on failure.
+//
+//   g++ -std=c++14 -O2 -I.. PolyphaseResamplerTest.cpp ../PolyphaseResampler.cpp -o resampler_test
+//   ./resampler_test
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "PolyphaseResampler.h"
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+const double MAX_PASSBAND_DB = 0.5; // Allowed gain error for passband tones
+const double MAX_ALIAS_DB = -65.0;  // The filter is designed for -70 dB
+
+// Level in dB (relative to a full-scale sine) of frequency hz in the second
+// half of x, measured through a Blackman-Harris window (-92 dB sidelobes).
+double levelDb(const std::vector<float>& x, int rate, double hz) {
+    const size_t start = x.size() / 2;
+    const size_t n = x.size() - start;
+    double re = 0, im = 0, windowSum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const double t = 2.0 * PI * i / (n - 1);
+        const double w = 0.35875 - 0.48829 * std::cos(t) + 0.14128 * std::cos(2 * t) - 0.01168 * std::cos(3 * t);
+        const double phase = 2.0 * PI * hz * i / rate;
+        re += w * x[start + i] * std::cos(phase);
+        im += w * x[start + i] * std::sin(phase);
+        windowSum += w;
+    }
+    return 20.0 * std::log10(2.0 * std::sqrt(re * re + im * im) / windowSum + 1e-12);
+}
+
+// Resamples one second of a full-scale tone in uneven blocks, as the device
+// callbacks would deliver it.
+std::vector<float> resampleTone(int inRate, int outRate, double hz) {
+    PolyphaseResampler resampler(inRate, outRate, 1);
+    std::vector<float> in(static_cast<size_t>(inRate));
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = static_cast<float>(std::sin(2.0 * PI * hz * i / inRate));
+    }
+    std::vector<float> out;
+    std::vector<float> block;
+    std::vector<float> produced;
+    size_t pos = 0;
+    for (size_t step = 0; pos < in.size(); ++step) {
+        size_t frames = std::min<size_t>(97 + 31 * (step % 5), in.size() - pos);
+        block.assign(in.begin() + pos, in.begin() + pos + frames);
+        resampler.process(block, produced);
+        out.insert(out.end(), produced.begin(), produced.end());
+        pos += frames;
+    }
+    return out;
+}
+
+int failures = 0;
+
+void checkPassband(int inRate, int outRate, double hz) {
+    double db = levelDb(resampleTone(inRate, outRate, hz), outRate, hz);
+    bool ok = std::fabs(db) <= MAX_PASSBAND_DB;
+    std::printf("%6d -> %6d Hz: %7.0f Hz tone passes at %7.2f dB  %s\n", inRate, outRate, hz, db, ok ? "ok" : "FAIL");
+    failures += ok ? 0 : 1;
+}
+
+// A tone at hz (above the lower Nyquist frequency, or the image of one below
+// it) must not show up at `at` in the output.
+void checkRejected(int inRate, int outRate, double hz, double at) {
+    double db = levelDb(resampleTone(inRate, outRate, hz), outRate, at);
+    bool ok = db <= MAX_ALIAS_DB;
+    std::printf("%6d -> %6d Hz: %7.0f Hz tone leaves %7.2f dB at %5.0f Hz  %s\n", inRate, outRate, hz, db, at, ok ? "ok" : "FAIL");
+    failures += ok ? 0 : 1;
+}
+
+} // namespace
+
+int main() {
+    // Capture, decimating to a narrowband Opus rate
+    checkPassband(48000, 8000, 1000);
+    checkPassband(48000, 8000, 3000);
+    checkRejected(48000, 8000, 5000, 3000);
+    checkRejected(48000, 8000, 4500, 3500);
+    checkRejected(48000, 8000, 7000, 1000);
+    checkPassband(48000, 16000, 6500);
+    checkRejected(48000, 16000, 10000, 6000);
+    checkRejected(44100, 16000, 9000, 7000);
+    // 44.1 kHz devices in both directions
+    checkPassband(44100, 48000, 15000);
+    checkRejected(44100, 48000, 15000, 48000 - (44100 - 15000));
+    checkRejected(44100, 48000, 21000, 44100 - 21000);
+    checkPassband(48000, 44100, 15000);
+    checkRejected(48000, 44100, 23000, 44100 - 23000);
+    // Playback, interpolating from a narrowband Opus rate
+    checkPassband(8000, 48000, 3000);
+    checkRejected(8000, 48000, 3000, 5000);
+
+    if (failures) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("OK\n");
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+/* Regression check for rnnoise_process_frames(): denoises a set of streams
+   once frame by frame with rnnoise_process_frame() and once batched, and
+   requires bit-identical output and VAD. The streams are synthetic (voiced
+   tones in noise, with silent stretches so that batches lose and regain
+   members), more than one batch long, and mix float and int8 states and
+   rates, so every way the batch is split is exercised. Exits with status 1
+   on the first difference. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "rnnoise.h"
+
+#define STREAMS 19
+#define FRAMES 300
+#define MAX_FRAME_SIZE 480
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static unsigned int lcg(unsigned int *seed) {
+  *seed = *seed*1103515245u + 12345u;
+  return *seed >> 8;
+}
+
+/* One frame of stream k: a harmonic tone whose pitch drifts, in white noise,
+   switched off for a while every second so the stream goes silent. */
+static void make_frame(float *x, int n, int rate, int k, int frame, unsigned int *seed) {
+  int i;
+  int on = (frame + 7*k) % 100 < 80;
+  double f0 = 110 + 15*k + 20*sin(.05*frame);
+  for (i=0;i<n;i++) {
+    double t = ((double)frame*n + i)/rate;
+    double v = 0;
+    int h;
+    if (on) {
+      for (h=1;h<=4;h++) v += 3000./h*sin(2*M_PI*h*f0*t);
+      v += 600.*(((lcg(seed) & 0xffff)/32768.) - 1);
+    }
+    x[i] = (float)v;
+  }
+}
+
+int main(void) {
+  static const int rates[3] = {48000, 16000, 8000};
+  DenoiseState *seq[STREAMS], *batch[STREAMS];
+  unsigned int seed[STREAMS];
+  static float in[STREAMS][MAX_FRAME_SIZE];
+  static float out_seq[STREAMS][MAX_FRAME_SIZE], out_batch[STREAMS][MAX_FRAME_SIZE];
+  const float *in_ptr[STREAMS];
+  float *out_ptr[STREAMS];
+  float vad_seq[STREAMS], vad_batch[STREAMS];
+  int frame, k;
+  for (k=0;k<STREAMS;k++) {
+    /* Mostly 48 kHz float, with some int8 and lower-rate states in between. */
+    int rate = k % 5 == 3 ? rates[1 + k % 2] : rates[0];
+    int int8 = k % 3 == 1;
+    seq[k] = rnnoise_create_rate(NULL, rate);
+    batch[k] = rnnoise_create_rate(NULL, rate);
+    if (!seq[k] || !batch[k]) {
+      fprintf(stderr, "cannot create a %d Hz state\n", rate);
+      return 2;
+    }
+    if (int8 && (rnnoise_set_quantized(seq[k], 1) != 0 || rnnoise_set_quantized(batch[k], 1) != 0)) {
+      fprintf(stderr, "cannot enable the int8 mode\n");
+      return 2;
+    }
+    seed[k] = 1 + k;
+    in_ptr[k] = in[k];
+    out_ptr[k] = out_batch[k];
+  }
+  for (frame=0;frame<FRAMES;frame++) {
+    for (k=0;k<STREAMS;k++) {
+      int n = rnnoise_get_frame_size(seq[k]);
+      make_frame(in[k], n, n*100, k, frame, &seed[k]);
+      vad_seq[k] = rnnoise_process_frame(seq[k], out_seq[k], in[k]);
+    }
+    rnnoise_process_frames(batch, out_ptr, in_ptr, vad_batch, STREAMS);
+    for (k=0;k<STREAMS;k++) {
+      int n = rnnoise_get_frame_size(seq[k]);
+      if (memcmp(out_seq[k], out_batch[k], n*sizeof(float)) != 0 || vad_seq[k] != vad_batch[k]) {
+        printf("FAIL: stream %d differs at frame %d (VAD %g sequential, %g batched)\n",
+            k, frame, vad_seq[k], vad_batch[k]);
+        return 1;
+      }
+    }
+  }
+  for (k=0;k<STREAMS;k++) {
+    rnnoise_destroy(seq[k]);
+    rnnoise_destroy(batch[k]);
+  }
+  printf("%d streams, %d frames: batched output identical\n", STREAMS, FRAMES);
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,153 @@
+/* Check of the model loaders: writes the built-in model as a text model and
+   as a binary one, loads the binary file twice and requires both loads to
+   return the one shared mapping, with the int8 weights not packed until a
+   state asks for them. Then denoises the same synthetic audio with the
+   built-in, text and binary models, in float and in int8, and requires
+   bit-identical output. Exits with status 1 on failure.
+
+   Uses the library's internal model layout, so it links against a static
+   build. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "rnnoise.h"
+#include "rnn.h"
+#include "rnn_data.h"
+#include "rnn_binary.h"
+
+#define BINARY_PATH "rnnoise_model_check.bin"
+#define FRAMES 200
+#define FRAME_SIZE 480
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+extern const struct RNNModel rnnoise_model_orig;
+
+static int failures = 0;
+
+static void check(int ok, const char *what) {
+  printf("%s: %s\n", ok ? "ok  " : "FAIL", what);
+  if (!ok) failures++;
+}
+
+static int file_activation(int activation) {
+  switch (activation) {
+    case ACTIVATION_SIGMOID: return F_ACTIVATION_SIGMOID;
+    case ACTIVATION_RELU: return F_ACTIVATION_RELU;
+    default: return F_ACTIVATION_TANH;
+  }
+}
+
+static void write_array(FILE *f, const rnn_weight *w, int len) {
+  int i;
+  for (i=0;i<len;i++) fprintf(f, "%d%c", w[i], i + 1 < len ? ' ' : '\n');
+}
+
+static void write_dense(FILE *f, const DenseLayer *d) {
+  fprintf(f, "%d %d %d\n", d->nb_inputs, d->nb_neurons, file_activation(d->activation));
+  write_array(f, d->input_weights, d->nb_inputs*d->nb_neurons);
+  write_array(f, d->bias, d->nb_neurons);
+}
+
+static void write_gru(FILE *f, const GRULayer *g) {
+  fprintf(f, "%d %d %d\n", g->nb_inputs, g->nb_neurons, file_activation(g->activation));
+  write_array(f, g->input_weights, 3*g->nb_inputs*g->nb_neurons);
+  write_array(f, g->recurrent_weights, 3*g->nb_neurons*g->nb_neurons);
+  write_array(f, g->bias, 3*g->nb_neurons);
+}
+
+/* The text format rnnoise_model_from_file() reads, as dump_rnn.py writes it. */
+static void write_text(FILE *f, const struct RNNModel *m) {
+  fprintf(f, "rnnoise-nu model file version 1\n");
+  write_dense(f, m->input_dense);
+  write_gru(f, m->vad_gru);
+  write_gru(f, m->noise_gru);
+  write_gru(f, m->denoise_gru);
+  write_dense(f, m->denoise_output);
+  write_dense(f, m->vad_output);
+}
+
+/* Denoises a noisy tone with model into out (FRAMES*FRAME_SIZE samples);
+   returns 0 if the state can't be set up. */
+static int denoise(RNNModel *model, int int8, float *out) {
+  DenoiseState *st = rnnoise_create(model);
+  unsigned int seed = 1;
+  int frame, i;
+  if (!st) return 0;
+  if (int8 && rnnoise_set_quantized(st, 1) != 0) {
+    rnnoise_destroy(st);
+    return 0;
+  }
+  for (frame=0;frame<FRAMES;frame++) {
+    float x[FRAME_SIZE];
+    for (i=0;i<FRAME_SIZE;i++) {
+      double t = (double)(frame*FRAME_SIZE + i)/48000;
+      seed = seed*1103515245u + 12345u;
+      x[i] = (float)(3000*sin(2*M_PI*220*t) + 600*(((seed >> 8) & 0xffff)/32768. - 1));
+    }
+    rnnoise_process_frame(st, &out[frame*FRAME_SIZE], x);
+  }
+  rnnoise_destroy(st);
+  return 1;
+}
+
+int main(void) {
+  static float ref[FRAMES*FRAME_SIZE], out[FRAMES*FRAME_SIZE];
+  RNNModel *text, *binary, *again;
+  FILE *f;
+  int int8;
+
+  f = tmpfile();
+  if (!f) {
+    fprintf(stderr, "cannot create a temporary file\n");
+    return 2;
+  }
+  write_text(f, &rnnoise_model_orig);
+  rewind(f);
+  text = rnnoise_model_from_file(f);
+  fclose(f);
+  check(text != NULL, "text model loads");
+
+  f = fopen(BINARY_PATH, "wb");
+  if (!f) {
+    fprintf(stderr, "cannot create %s\n", BINARY_PATH);
+    return 2;
+  }
+  check(rnnoise_model_write(NULL, f) == 0, "binary model written");
+  fclose(f);
+  binary = rnnoise_model_load(BINARY_PATH);
+  again = rnnoise_model_load(BINARY_PATH);
+  check(binary != NULL && again == binary, "second load shares the first one's mapping");
+  if (!text || !binary) {
+    remove(BINARY_PATH);
+    return 1;
+  }
+  check(text->int8 == NULL && binary->int8 == NULL, "int8 weights not packed at load");
+
+  for (int8=0;int8<=1;int8++) {
+    int same;
+    denoise(NULL, int8, ref);
+    same = denoise(text, int8, out) && memcmp(ref, out, sizeof(ref)) == 0;
+    check(same, int8 ? "text model output matches the built-in one in int8" :
+        "text model output matches the built-in one");
+    same = denoise(binary, int8, out) && memcmp(ref, out, sizeof(ref)) == 0;
+    check(same, int8 ? "binary model output matches the built-in one in int8" :
+        "binary model output matches the built-in one");
+  }
+  check(binary->int8 != NULL && again->int8 == binary->int8, "int8 weights packed once, on first use");
+
+  rnnoise_model_free(again);
+  rnnoise_model_free(binary);
+  rnnoise_model_free(text);
+  remove(BINARY_PATH);
+  if (failures) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,40 @@
+/* Converts a text model (rnnoise_model_from_file()) to the binary format
+   rnnoise_model_load() maps. */
+
+#include <stdio.h>
+#include "rnnoise.h"
+
+int main(int argc, char **argv) {
+  FILE *fin, *fout;
+  RNNModel *model;
+  int ret;
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <text model> <binary model>\n", argv[0]);
+    return 1;
+  }
+  fin = fopen(argv[1], "r");
+  if (!fin) {
+    fprintf(stderr, "cannot open %s\n", argv[1]);
+    return 1;
+  }
+  model = rnnoise_model_from_file(fin);
+  fclose(fin);
+  if (!model) {
+    fprintf(stderr, "%s is not a valid model\n", argv[1]);
+    return 1;
+  }
+  fout = fopen(argv[2], "wb");
+  if (!fout) {
+    fprintf(stderr, "cannot open %s\n", argv[2]);
+    rnnoise_model_free(model);
+    return 1;
+  }
+  ret = rnnoise_model_write(model, fout);
+  if (fclose(fout) != 0) ret = -1;
+  rnnoise_model_free(model);
+  if (ret != 0) {
+    fprintf(stderr, "cannot write %s\n", argv[2]);
+    return 1;
+  }
+  return 0;
+}
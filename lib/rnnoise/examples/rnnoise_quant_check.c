@@ -0,0 +1,81 @@
+/* Quality check for the int8 mode (rnnoise_set_quantized()): denoises the
+   same audio in float and in int8 and reports how far apart the outputs
+   are, and the time each took. Exits with status 1 if the output SNR of
+   int8 against float is below the threshold, so it can gate model or
+   kernel changes. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "rnnoise.h"
+
+#define FRAME_SIZE 480
+#define DEFAULT_MIN_SNR 30.
+
+int main(int argc, char **argv) {
+  int i;
+  int frames = 0;
+  double min_snr = DEFAULT_MIN_SNR;
+  double signal = 0, noise = 0, snr;
+  double vad_diff = 0, vad_diff_max = 0;
+  clock_t float_time = 0, int8_time = 0;
+  FILE *f1;
+  DenoiseState *ref, *q;
+  if (argc != 2 && argc != 3) {
+    fprintf(stderr, "usage: %s <noisy speech> [min SNR in dB, default %g]\n", argv[0], DEFAULT_MIN_SNR);
+    return 2;
+  }
+  if (argc == 3) min_snr = atof(argv[2]);
+  f1 = fopen(argv[1], "rb");
+  if (!f1) {
+    fprintf(stderr, "cannot open %s\n", argv[1]);
+    return 2;
+  }
+  ref = rnnoise_create(NULL);
+  q = rnnoise_create(NULL);
+  if (rnnoise_set_quantized(q, 1) != 0) {
+    fprintf(stderr, "cannot enable the int8 mode\n");
+    return 2;
+  }
+  while (1) {
+    short tmp[FRAME_SIZE];
+    float x[FRAME_SIZE], y_ref[FRAME_SIZE], y_q[FRAME_SIZE];
+    float vad_ref, vad_q;
+    clock_t t;
+    if (fread(tmp, sizeof(short), FRAME_SIZE, f1) != FRAME_SIZE) break;
+    for (i=0;i<FRAME_SIZE;i++) x[i] = tmp[i];
+    t = clock();
+    vad_ref = rnnoise_process_frame(ref, y_ref, x);
+    float_time += clock() - t;
+    t = clock();
+    vad_q = rnnoise_process_frame(q, y_q, x);
+    int8_time += clock() - t;
+    for (i=0;i<FRAME_SIZE;i++) {
+      signal += (double)y_ref[i]*y_ref[i];
+      noise += (double)(y_q[i] - y_ref[i])*(y_q[i] - y_ref[i]);
+    }
+    vad_diff += fabs(vad_q - vad_ref);
+    if (fabs(vad_q - vad_ref) > vad_diff_max) vad_diff_max = fabs(vad_q - vad_ref);
+    frames++;
+  }
+  rnnoise_destroy(ref);
+  rnnoise_destroy(q);
+  fclose(f1);
+  if (frames == 0) {
+    fprintf(stderr, "no complete %d-sample frame in %s\n", FRAME_SIZE, argv[1]);
+    return 2;
+  }
+  snr = noise > 0 ? 10*log10(signal/noise) : INFINITY;
+  printf("frames:           %d\n", frames);
+  printf("int8 vs float:    %.2f dB SNR\n", snr);
+  printf("VAD difference:   %.4f mean, %.4f max\n", vad_diff/frames, vad_diff_max);
+  printf("time per frame:   %.2f us float, %.2f us int8\n",
+      1e6*float_time/CLOCKS_PER_SEC/frames, 1e6*int8_time/CLOCKS_PER_SEC/frames);
+  if (snr < min_snr) {
+    printf("FAIL: below %g dB\n", min_snr);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
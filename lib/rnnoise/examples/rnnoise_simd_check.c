@@ -0,0 +1,350 @@
+/* Numerical check of the SIMD kernels, at every arch level from RNN_ARCH_C
+   up to the one this CPU supports. The pitch correlations (rnn_pitch_xcorr()
+   and the inner and dual inner products) and the real FFT are compared with
+   double-precision references, and must be within float rounding of them.
+   The dense and GRU layer kernels are compared with rnn_gemv_accum_c() and
+   rnn_gemm_accum_c(), on every matrix of the built-in model and on ragged
+   sizes, and the int8 kernels with rnn_int8_gemv_c(), also through
+   rnn_int8_gemm_accum() on a GRU as wide as a model may have; all must
+   match bit for bit. Exits with status 1 on any failure.
+
+   Uses the library's internal functions, so it links against a static
+   build. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cpu_support.h"
+#include "pitch.h"
+#include "real_fft.h"
+#include "rnn.h"
+#include "rnn_data.h"
+#include "rnn_int8.h"
+
+#if defined(RNN_X86_MAY_HAVE_AVX2) && !defined(FIXED_POINT)
+#define RNN_PITCH_X86
+#include "x86/pitch_x86.h"
+#endif
+#ifdef RNN_X86_MAY_HAVE_AVX2
+#include "x86/rnn_x86.h"
+#endif
+
+extern const struct RNNModel rnnoise_model_orig;
+
+/* Relative to the size of the terms summed; float accumulation over the
+   lengths here stays well below this, a wrong index or lane does not. */
+#define PITCH_TOLERANCE 1e-5
+/* Relative RMS error of a transform; float transforms of these sizes are
+   around 3e-7. */
+#define FFT_TOLERANCE 1e-5
+
+#define MAX_LEN 1024
+#define MAX_FFT 960
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static const char *const arch_names[3] = {"C", "SSE4.1", "AVX2"};
+
+static unsigned int seed = 1;
+
+static float uni_rand(void) {
+  seed = seed*1103515245u + 12345u;
+  return ((seed >> 8) & 0xffff)/32768.f - 1;
+}
+
+/* The same dispatch as the static inner_prod() and dual_prod() in pitch.c. */
+static float inner_prod(const float *x, const float *y, int N, int arch) {
+#ifdef RNN_PITCH_X86
+  if (arch >= RNN_ARCH_AVX2) return rnn_inner_prod_avx2(x, y, N);
+  if (arch >= RNN_ARCH_SSE4_1) return rnn_inner_prod_sse4_1(x, y, N);
+#endif
+  (void)arch;
+  return celt_inner_prod(x, y, N);
+}
+
+static void dual_prod(const float *x, const float *y01, const float *y02, int N,
+    float *xy1, float *xy2, int arch) {
+#ifdef RNN_PITCH_X86
+  if (arch >= RNN_ARCH_AVX2) {
+    rnn_dual_inner_prod_avx2(x, y01, y02, N, xy1, xy2);
+    return;
+  }
+  if (arch >= RNN_ARCH_SSE4_1) {
+    rnn_dual_inner_prod_sse4_1(x, y01, y02, N, xy1, xy2);
+    return;
+  }
+#endif
+  (void)arch;
+  dual_inner_prod(x, y01, y02, N, xy1, xy2);
+}
+
+/* Error of got against the exact dot product of x and y, relative to the sum
+   of the magnitudes of its terms. */
+static double prod_error(float got, const float *x, const float *y, int N) {
+  int i;
+  double sum = 0, mag = 1e-30;
+  for (i=0;i<N;i++) {
+    sum += (double)x[i]*y[i];
+    mag += fabs((double)x[i]*y[i]);
+  }
+  return fabs(got - sum)/mag;
+}
+
+static double check_pitch(int arch) {
+  /* Lengths and lag counts of the coarse and fine searches at each rate,
+     and odd ones for the tails. */
+  static const int sizes[][2] = {{240, 147}, {480, 3}, {80, 49}, {40, 25}, {61, 13}, {7, 9}, {1, 1}};
+  static float x[MAX_LEN], y[2*MAX_LEN], xcorr[MAX_LEN];
+  double worst = 0, err;
+  int s, i;
+  for (i=0;i<MAX_LEN;i++) x[i] = uni_rand();
+  for (i=0;i<2*MAX_LEN;i++) y[i] = uni_rand();
+  for (s=0;s<(int)(sizeof(sizes)/sizeof(sizes[0]));s++) {
+    int len = sizes[s][0], max_pitch = sizes[s][1];
+    float xy1, xy2;
+    rnn_pitch_xcorr(x, y, xcorr, len, max_pitch, arch);
+    for (i=0;i<max_pitch;i++) {
+      err = prod_error(xcorr[i], x, y+i, len);
+      if (err > worst) worst = err;
+    }
+    err = prod_error(inner_prod(x, y+3, len, arch), x, y+3, len);
+    if (err > worst) worst = err;
+    dual_prod(x, y+1, y+5, len, &xy1, &xy2, arch);
+    err = prod_error(xy1, x, y+1, len);
+    if (err > worst) worst = err;
+    err = prod_error(xy2, x, y+5, len);
+    if (err > worst) worst = err;
+  }
+  return worst;
+}
+
+/* Relative RMS error of the forward and inverse transforms of length n
+   against a direct DFT; the larger of the two. */
+static double check_fft(int n, int arch) {
+  static float in[MAX_FFT], out[MAX_FFT];
+  static kiss_fft_cpx spec[MAX_FFT/2+1];
+  double err = 0, ref_energy = 1e-30, fwd, inv;
+  rnn_rfft_state *st;
+  int k, t;
+  st = rnn_rfft_alloc(n, arch);
+  if (!st) return INFINITY;
+  for (t=0;t<n;t++) in[t] = uni_rand();
+  rnn_rfft_forward(st, spec, in);
+  for (k=0;k<=n/2;k++) {
+    double re = 0, im = 0;
+    for (t=0;t<n;t++) {
+      double w = -2*M_PI*(double)((long)k*t % n)/n;
+      re += in[t]*cos(w);
+      im += in[t]*sin(w);
+    }
+    re /= n;
+    im /= n;
+    err += (spec[k].r - re)*(spec[k].r - re) + (spec[k].i - im)*(spec[k].i - im);
+    ref_energy += re*re + im*im;
+  }
+  fwd = sqrt(err/ref_energy);
+
+  for (k=0;k<=n/2;k++) {
+    spec[k].r = uni_rand();
+    spec[k].i = uni_rand();
+  }
+  rnn_rfft_inverse(st, out, spec);
+  err = 0;
+  ref_energy = 1e-30;
+  for (t=0;t<n;t++) {
+    /* The Hermitian extension: bins 0 and n/2 count once and are real. */
+    double v = spec[0].r + ((t & 1) ? -spec[n/2].r : spec[n/2].r);
+    for (k=1;k<n/2;k++) {
+      double w = 2*M_PI*(double)((long)k*t % n)/n;
+      v += 2*(spec[k].r*cos(w) - spec[k].i*sin(w));
+    }
+    err += (out[t] - v)*(out[t] - v);
+    ref_energy += v*v;
+  }
+  inv = sqrt(err/ref_energy);
+  rnn_rfft_free(st);
+  return fwd > inv ? fwd : inv;
+}
+
+/* The same dispatch as the float path of gemm_accum() in rnn.c. */
+static void gemm_accum(float *out, int out_stride, const rnn_weight *weights, int stride,
+    int N, int M, const float *x, const float *x2, int x_stride, int K, int arch) {
+#ifdef RNN_X86_MAY_HAVE_AVX2
+  if (arch >= RNN_ARCH_AVX2) {
+    if (K == 1) rnn_gemv_accum_avx2(out, weights, stride, N, M, x, x2);
+    else rnn_gemm_accum_avx2(out, out_stride, weights, stride, N, M, x, x2, x_stride, K);
+    return;
+  }
+#endif
+  (void)arch;
+  rnn_gemm_accum_c(out, out_stride, weights, stride, N, M, x, x2, x_stride, K);
+}
+
+/* Whether the arch's kernel gives exactly the bits of the C one for an N by
+   M product (scaled by a second input if with_x2), for one stream and for
+   batches. */
+static int gemm_matches(const rnn_weight *weights, int stride, int N, int M, int with_x2, int arch) {
+  static const int batches[3] = {1, 3, RNN_MAX_BATCH};
+  static float x[RNN_MAX_BATCH*MAX_NEURONS], x2[RNN_MAX_BATCH*MAX_NEURONS];
+  static float ref[RNN_MAX_BATCH*3*MAX_NEURONS], out[RNN_MAX_BATCH*3*MAX_NEURONS];
+  int b, i;
+  for (b=0;b<3;b++) {
+    int K = batches[b];
+    for (i=0;i<K*MAX_NEURONS;i++) {
+      x[i] = uni_rand();
+      x2[i] = .5f + .5f*uni_rand();
+    }
+    for (i=0;i<K*3*MAX_NEURONS;i++) ref[i] = out[i] = uni_rand();
+    rnn_gemm_accum_c(ref, 3*MAX_NEURONS, weights, stride, N, M, x, with_x2 ? x2 : NULL, MAX_NEURONS, K);
+    gemm_accum(out, 3*MAX_NEURONS, weights, stride, N, M, x, with_x2 ? x2 : NULL, MAX_NEURONS, K, arch);
+    if (memcmp(ref, out, sizeof(ref)) != 0) return 0;
+  }
+  return 1;
+}
+
+static int dense_matches(const DenseLayer *layer, int arch) {
+  return gemm_matches(layer->input_weights, layer->nb_neurons, layer->nb_neurons, layer->nb_inputs, 0, arch);
+}
+
+/* The three products compute_gru() splits a GRU into. */
+static int gru_matches(const GRULayer *gru, int arch) {
+  int N = gru->nb_neurons;
+  return gemm_matches(gru->input_weights, 3*N, 3*N, gru->nb_inputs, 0, arch)
+      && gemm_matches(gru->recurrent_weights, 3*N, 2*N, N, 0, arch)
+      && gemm_matches(&gru->recurrent_weights[2*N], 3*N, N, N, 1, arch);
+}
+
+/* Counts the shapes whose results differ from the C kernel's. */
+static int check_gemm(int arch) {
+  /* Neuron counts around the 8-, 16- and 32-wide blocks of the AVX2
+     kernel, and input counts around its unrolling. */
+  static const int ragged_n[] = {1, 7, 8, 9, 15, 17, 31, 33, 47, 3*MAX_NEURONS};
+  static const int ragged_m[] = {1, 2, 3, 5, 42, MAX_NEURONS};
+  static rnn_weight weights[(3*MAX_NEURONS + 5)*MAX_NEURONS];
+  const struct RNNModel *m = &rnnoise_model_orig;
+  int failures = 0;
+  int i, j;
+  failures += !dense_matches(m->input_dense, arch);
+  failures += !gru_matches(m->vad_gru, arch);
+  failures += !gru_matches(m->noise_gru, arch);
+  failures += !gru_matches(m->denoise_gru, arch);
+  failures += !dense_matches(m->denoise_output, arch);
+  failures += !dense_matches(m->vad_output, arch);
+  for (i=0;i<(int)sizeof(weights);i++) weights[i] = (rnn_weight)(uni_rand()*128);
+  for (i=0;i<(int)(sizeof(ragged_n)/sizeof(ragged_n[0]));i++) {
+    for (j=0;j<(int)(sizeof(ragged_m)/sizeof(ragged_m[0]));j++) {
+      int N = ragged_n[i], M = ragged_m[j];
+      failures += !gemm_matches(weights, N, N, M, 0, arch);
+      failures += !gemm_matches(weights, N + 5, N, M, 1, arch);
+    }
+  }
+  return failures;
+}
+
+/* The same dispatch as gemv() in rnn_int8.c. */
+static void int8_gemv(int *acc, const signed char *w, int N, int M, const signed char *q, int arch) {
+#ifdef RNN_X86_MAY_HAVE_AVX2
+  if (arch >= RNN_ARCH_AVX2) {
+    rnn_int8_gemv_avx2(acc, w, N, M, q);
+    return;
+  }
+  if (arch >= RNN_ARCH_SSE4_1) {
+    rnn_int8_gemv_sse4_1(acc, w, N, M, q);
+    return;
+  }
+#endif
+  (void)arch;
+  rnn_int8_gemv_c(acc, w, N, M, q);
+}
+
+/* Counts the cases whose results differ from the C kernel's: the raw int8
+   products on whole blocks, then the full int8 layer product on a GRU with
+   the most neurons and inputs allowed. */
+static int check_int8(int arch) {
+  static const int sizes_n[] = {8, 16, 24, 40, 72, 3*MAX_NEURONS};
+  static const int sizes_m[] = {4, 8, 12, 44, MAX_NEURONS, 3*MAX_NEURONS};
+  static signed char w[9*MAX_NEURONS*MAX_NEURONS];
+  static signed char q[3*MAX_NEURONS];
+  static int ref[3*MAX_NEURONS], acc[3*MAX_NEURONS];
+  static rnn_weight gru_weights[3*MAX_NEURONS*3*MAX_NEURONS];
+  static float x[RNN_MAX_BATCH*3*MAX_NEURONS];
+  static float out_ref[RNN_MAX_BATCH*3*MAX_NEURONS], out[RNN_MAX_BATCH*3*MAX_NEURONS];
+  struct RNNModel wide = rnnoise_model_orig;
+  GRULayer gru;
+  RNNInt8Model *packed;
+  int failures = 0;
+  int i, j, K;
+  for (i=0;i<(int)sizeof(w);i++) w[i] = (signed char)(uni_rand()*128);
+  for (i=0;i<(int)(sizeof(sizes_n)/sizeof(sizes_n[0]));i++) {
+    for (j=0;j<(int)(sizeof(sizes_m)/sizeof(sizes_m[0]));j++) {
+      int N = sizes_n[i], M = sizes_m[j], k;
+      for (k=0;k<M;k++) q[k] = (signed char)(uni_rand()*127);
+      for (k=0;k<N;k++) ref[k] = acc[k] = (int)(uni_rand()*100000);
+      rnn_int8_gemv_c(ref, w, N, M, q);
+      int8_gemv(acc, w, N, M, q, arch);
+      failures += memcmp(ref, acc, N*sizeof(int)) != 0;
+    }
+  }
+
+  for (i=0;i<(int)sizeof(gru_weights);i++) gru_weights[i] = (rnn_weight)(uni_rand()*128);
+  gru.bias = gru_weights;
+  gru.input_weights = gru_weights;
+  gru.recurrent_weights = gru_weights;
+  gru.nb_inputs = 3*MAX_NEURONS;
+  gru.nb_neurons = MAX_NEURONS;
+  gru.activation = ACTIVATION_TANH;
+  wide.denoise_gru = &gru;
+  packed = rnn_int8_model_create(&wide);
+  if (!packed) return failures + 1;
+  for (K=1;K<=RNN_MAX_BATCH;K+=RNN_MAX_BATCH-1) {
+    for (i=0;i<K*3*MAX_NEURONS;i++) {
+      x[i] = uni_rand();
+      out_ref[i] = out[i] = uni_rand();
+    }
+    rnn_int8_gemm_accum(out_ref, 3*MAX_NEURONS, &packed->denoise_gru.input, x, NULL, 3*MAX_NEURONS, K, RNN_ARCH_C);
+    rnn_int8_gemm_accum(out, 3*MAX_NEURONS, &packed->denoise_gru.input, x, NULL, 3*MAX_NEURONS, K, arch);
+    failures += memcmp(out_ref, out, sizeof(out)) != 0;
+  }
+  rnn_int8_model_free(packed);
+  return failures;
+}
+
+int main(void) {
+  /* The 48, 16 and 8 kHz window sizes. */
+  static const int fft_sizes[3] = {960, 320, 160};
+  int max_arch = rnn_select_arch();
+  int arch, i;
+  int failed = 0;
+  for (arch=RNN_ARCH_C;arch<=RNN_ARCH_AVX2;arch++) {
+    double err;
+    int mismatches;
+    if (arch > max_arch) {
+      printf("%-7s skipped, not supported here\n", arch_names[arch]);
+      continue;
+    }
+    mismatches = check_gemm(arch);
+    printf("%-7s dense/GRU kernels: %s\n", arch_names[arch], mismatches ? "DIFFER" : "bit-exact");
+    if (mismatches) failed = 1;
+    mismatches = check_int8(arch);
+    printf("%-7s int8 kernels: %s\n", arch_names[arch], mismatches ? "DIFFER" : "bit-exact");
+    if (mismatches) failed = 1;
+    err = check_pitch(arch);
+    printf("%-7s pitch correlations: %.2e\n", arch_names[arch], err);
+    if (!(err <= PITCH_TOLERANCE)) failed = 1;
+    for (i=0;i<3;i++) {
+      err = check_fft(fft_sizes[i], arch);
+      printf("%-7s real FFT, n = %d: %.2e\n", arch_names[arch], fft_sizes[i], err);
+      if (!(err <= FFT_TOLERANCE)) failed = 1;
+    }
+  }
+  if (failed) {
+    printf("FAIL: a kernel differs from C, or errors above %g (pitch) or %g (FFT)\n",
+        PITCH_TOLERANCE, FFT_TOLERANCE);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -59,10 +59,56 @@ RNNOISE_EXPORT DenoiseState *rnnoise_create(RNNModel *model);
 
 RNNOISE_EXPORT void rnnoise_destroy(DenoiseState *st);
 
+/* Like rnnoise_init() and rnnoise_create(), which work at 48 kHz, for input
+   at sample_rate: 48000, 16000 or 8000. Lower rates process their own
+   bandwidth only, with proportionally less work per frame, and the same
+   models; narrowband and wideband callers need not resample to 48 kHz.
+   rnnoise_init_rate() returns 0, or -1 for another rate (where
+   rnnoise_create_rate() returns NULL). */
+RNNOISE_EXPORT int rnnoise_init_rate(DenoiseState *st, RNNModel *model, int sample_rate);
+
+RNNOISE_EXPORT DenoiseState *rnnoise_create_rate(RNNModel *model, int sample_rate);
+
+/* Samples per frame in and out of rnnoise_process_frame(): 10 ms at the
+   state's rate, so 480 at 48 kHz. */
+RNNOISE_EXPORT int rnnoise_get_frame_size(const DenoiseState *st);
+
 RNNOISE_EXPORT float rnnoise_process_frame(DenoiseState *st, float *out, const float *in);
 
+/* Runs the network with 8-bit activations against its 8-bit weights (enabled
+   != 0) rather than in float (0, the default). Cheaper, and the output
+   differs from float only by the rounding of the activations; the
+   rnnoise_quant_check example measures by how much on real audio. Can be
+   changed between frames. The first call for a model packs its weights for
+   the int8 kernels, once for all states sharing it. Returns 0, or -1 if out
+   of memory or the model has a layer too large to run in int8. */
+RNNOISE_EXPORT int rnnoise_set_quantized(DenoiseState *st, int enabled);
+
+/* Same as calling rnnoise_process_frame(st[k], out[k], in[k]) for each of the
+   count states and storing the returns in vad[k], with identical results,
+   but the network runs on several streams at once (those sharing a model),
+   reading its weights once for all of them. For servers denoising many
+   participants; each state still belongs to one stream. */
+RNNOISE_EXPORT void rnnoise_process_frames(DenoiseState **st, float **out, const float *const *in, float *vad, int count);
+
+/* Parses a text model file (as written by training/dump_rnn.py) into a new
+   heap copy of the weights. */
 RNNOISE_EXPORT RNNModel *rnnoise_model_from_file(FILE *f);
 
+/* Loads a binary model file (see rnnoise_model_write()) by mapping it
+   read-only, without copying or parsing the weights. Loading a file that is
+   already loaded, from any thread, returns the same model with one more
+   reference, so every state in the process shares one copy. Replace model
+   files rather than rewriting them in place while they are loaded. NULL if
+   the file can't be opened or is not a valid model. */
+RNNOISE_EXPORT RNNModel *rnnoise_model_load(const char *path);
+
+/* Writes model (NULL for the built-in one) in the binary format. Returns 0,
+   or -1 on a write error or a model the format can't hold. */
+RNNOISE_EXPORT int rnnoise_model_write(const RNNModel *model, FILE *f);
+
+/* Frees a model from rnnoise_model_from_file(), or drops a reference to one
+   from rnnoise_model_load(). No state may still be using it. */
 RNNOISE_EXPORT void rnnoise_model_free(RNNModel *model);
 
 #ifdef __cplusplus
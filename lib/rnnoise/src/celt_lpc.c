@@ -34,7 +34,7 @@
 #include "common.h"
 #include "pitch.h"
 
-void _celt_lpc(
+void rnn_lpc(
       opus_val16       *_lpc, /* out: [0...p-1] LPC coefficients      */
 const opus_val32 *ac,  /* in:  [0...p] autocorrelation values  */
 int          p
@@ -88,7 +88,7 @@ int          p
 }
 
 
-void celt_fir(
+void rnn_fir(
          const opus_val16 *x,
          const opus_val16 *num,
          opus_val16 *y,
@@ -122,7 +122,7 @@ void celt_fir(
    free(rnum);
 }
 
-void celt_iir(const opus_val32 *_x,
+void rnn_iir(const opus_val32 *_x,
          const opus_val16 *den,
          opus_val32 *_y,
          int N,
@@ -198,13 +198,14 @@ void celt_iir(const opus_val32 *_x,
 #endif
 }
 
-int _celt_autocorr(
+int rnn_autocorr(
                    const opus_val16 *x,   /*  in: [0...n-1] samples x   */
                    opus_val32       *ac,  /* out: [0...lag-1] ac values */
                    const opus_val16       *window,
                    int          overlap,
                    int          lag,
-                   int          n)
+                   int          n,
+                   int          arch)
 {
    opus_val32 d;
    int i, k;
@@ -250,7 +251,7 @@ int _celt_autocorr(
          shift = 0;
    }
 #endif
-   celt_pitch_xcorr(xptr, xptr, ac, fastN, lag+1);
+   rnn_pitch_xcorr(xptr, xptr, ac, fastN, lag+1, arch);
    for (k=0;k<=lag;k++)
    {
       for (i = k+fastN, d = 0; i < n; i++)
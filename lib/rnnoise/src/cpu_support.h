@@ -0,0 +1,23 @@
+/* Run-time CPU feature selection, after celt/cpu_support.h in Opus.
+   rnnoise_init() picks an arch once per state and the RNN kernels dispatch
+   on it, so there is no global state to initialize. */
+
+#ifndef CPU_SUPPORT_H
+#define CPU_SUPPORT_H
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define RNN_X86_MAY_HAVE_AVX2
+#endif
+
+/* Ordered: each level implies the ones below it. */
+#define RNN_ARCH_C      0
+#define RNN_ARCH_SSE4_1 1
+#define RNN_ARCH_AVX2   2
+
+#ifdef RNN_X86_MAY_HAVE_AVX2
+int rnn_select_arch(void);
+#else
+#define rnn_select_arch() (RNN_ARCH_C)
+#endif
+
+#endif
@@ -35,6 +35,7 @@
 #include <string.h>
 #include <stdio.h>
 #include "kiss_fft.h"
+#include "real_fft.h"
 #include "common.h"
 #include <math.h>
 #include "rnnoise.h"
@@ -42,7 +43,12 @@
 #include "arch.h"
 #include "rnn.h"
 #include "rnn_data.h"
+#include "rnn_int8.h"
+#include "cpu_support.h"
+#include "rnn_once.h"
 
+/* Sizes at 48 kHz, the highest supported rate; buffers are sized for it.
+   Everything else comes from the state's DenoiseMode. */
 #define FRAME_SIZE_SHIFT 2
 #define FRAME_SIZE (120<<FRAME_SIZE_SHIFT)
 #define WINDOW_SIZE (2*FRAME_SIZE)
@@ -78,14 +84,50 @@ static const opus_int16 eband5ms[] = {
 };
 
 
+/* What depends on the sample rate. Frames are 10 ms and windows 20 ms at
+   every rate, so the FFT bins are always 50 Hz apart and eband5ms bin i is
+   the same frequency everywhere: a lower rate just has fewer bins, and the
+   bands above its Nyquist frequency come out empty, as they do for the
+   band-limited input the model is trained on (see lowpass in main()). The
+   features mean the same at every rate, so one model serves all of them.
+   The pitch search runs at the input rate, on periods scaled down to it. */
 typedef struct {
-  int init;
-  kiss_fft_state *kfft;
+  int rate;
+  int frame_size;
+  int freq_size;
+  int period_scale; /* 48 kHz samples per input sample */
+  int pitch_min_period;
+  int pitch_max_period;
+  int pitch_frame_size;
+  int pitch_buf_size;
+  float a_hp[2]; /* DC-blocking highpass, ~19 Hz at every rate */
+  rnn_rfft_state *rfft;
   float half_window[FRAME_SIZE];
+} DenoiseMode;
+
+#define NB_MODES 3
+
+/* Highpass poles for each rate: those of the 48 kHz filter, moved to keep
+   their frequency and bandwidth. */
+static const struct {
+  int rate;
+  float a_hp[2];
+} mode_params[NB_MODES] = {
+  {48000, {-1.99599, 0.99600}},
+  {16000, {-1.98795830, 0.98804794}},
+  {8000,  {-1.97588232, 0.97623872}},
+};
+
+/* Tables shared by every state. The first rnnoise_init(), on whatever
+   thread, builds them (see check_init()); they are read-only after that, so
+   states can be created and run on any number of threads at once. */
+typedef struct {
+  DenoiseMode modes[NB_MODES];
   float dct_table[NB_BANDS*NB_BANDS];
 } CommonState;
 
 struct DenoiseState {
+  const DenoiseMode *mode;
   float analysis_mem[FRAME_SIZE];
   float cepstral_mem[CEPS_MEM][NB_BANDS];
   int memid;
@@ -97,21 +139,28 @@ struct DenoiseState {
   float mem_hp_x[2];
   float lastg[NB_BANDS];
   RNNState rnn;
+#if TRAINING
+  int lowpass; /* Bins from here up are zeroed, to train on band-limited input */
+#endif
 };
 
-void compute_band_energy(float *bandE, const kiss_fft_cpx *X) {
+void compute_band_energy(const DenoiseMode *m, float *bandE, const kiss_fft_cpx *X) {
   int i;
   float sum[NB_BANDS] = {0};
   for (i=0;i<NB_BANDS-1;i++)
   {
     int j;
     int band_size;
+    int band_start;
+    band_start = eband5ms[i]<<FRAME_SIZE_SHIFT;
     band_size = (eband5ms[i+1]-eband5ms[i])<<FRAME_SIZE_SHIFT;
-    for (j=0;j<band_size;j++) {
+    /* Bins past Nyquist at lower rates */
+    if (band_start >= m->freq_size) break;
+    for (j=0;j<band_size && band_start+j<m->freq_size;j++) {
       float tmp;
       float frac = (float)j/band_size;
-      tmp = SQUARE(X[(eband5ms[i]<<FRAME_SIZE_SHIFT) + j].r);
-      tmp += SQUARE(X[(eband5ms[i]<<FRAME_SIZE_SHIFT) + j].i);
+      tmp = SQUARE(X[band_start + j].r);
+      tmp += SQUARE(X[band_start + j].i);
       sum[i] += (1-frac)*tmp;
       sum[i+1] += frac*tmp;
     }
@@ -124,19 +173,23 @@ void compute_band_energy(float *bandE, const kiss_fft_cpx *X) {
   }
 }
 
-void compute_band_corr(float *bandE, const kiss_fft_cpx *X, const kiss_fft_cpx *P) {
+void compute_band_corr(const DenoiseMode *m, float *bandE, const kiss_fft_cpx *X, const kiss_fft_cpx *P) {
   int i;
   float sum[NB_BANDS] = {0};
   for (i=0;i<NB_BANDS-1;i++)
   {
     int j;
     int band_size;
+    int band_start;
+    band_start = eband5ms[i]<<FRAME_SIZE_SHIFT;
     band_size = (eband5ms[i+1]-eband5ms[i])<<FRAME_SIZE_SHIFT;
-    for (j=0;j<band_size;j++) {
+    /* Bins past Nyquist at lower rates */
+    if (band_start >= m->freq_size) break;
+    for (j=0;j<band_size && band_start+j<m->freq_size;j++) {
       float tmp;
       float frac = (float)j/band_size;
-      tmp = X[(eband5ms[i]<<FRAME_SIZE_SHIFT) + j].r * P[(eband5ms[i]<<FRAME_SIZE_SHIFT) + j].r;
-      tmp += X[(eband5ms[i]<<FRAME_SIZE_SHIFT) + j].i * P[(eband5ms[i]<<FRAME_SIZE_SHIFT) + j].i;
+      tmp = X[band_start + j].r * P[band_start + j].r;
+      tmp += X[band_start + j].i * P[band_start + j].i;
       sum[i] += (1-frac)*tmp;
       sum[i+1] += frac*tmp;
     }
@@ -149,30 +202,51 @@ void compute_band_corr(float *bandE, const kiss_fft_cpx *X, const kiss_fft_cpx *
   }
 }
 
-void interp_band_gain(float *g, const float *bandE) {
+void interp_band_gain(const DenoiseMode *m, float *g, const float *bandE) {
   int i;
-  memset(g, 0, FREQ_SIZE);
+  RNN_CLEAR(g, m->freq_size);
   for (i=0;i<NB_BANDS-1;i++)
   {
     int j;
     int band_size;
+    int band_start;
+    band_start = eband5ms[i]<<FRAME_SIZE_SHIFT;
     band_size = (eband5ms[i+1]-eband5ms[i])<<FRAME_SIZE_SHIFT;
-    for (j=0;j<band_size;j++) {
+    /* Bins past Nyquist at lower rates */
+    if (band_start >= m->freq_size) break;
+    for (j=0;j<band_size && band_start+j<m->freq_size;j++) {
       float frac = (float)j/band_size;
-      g[(eband5ms[i]<<FRAME_SIZE_SHIFT) + j] = (1-frac)*bandE[i] + frac*bandE[i+1];
+      g[band_start + j] = (1-frac)*bandE[i] + frac*bandE[i+1];
     }
   }
 }
 
 
-CommonState common;
+static CommonState common;
+static rnn_once_flag common_once = RNN_ONCE_INIT;
 
-static void check_init() {
+static void init_mode(DenoiseMode *m, int k) {
+  int i;
+  int n;
+  m->rate = mode_params[k].rate;
+  m->period_scale = 48000/m->rate;
+  n = m->frame_size = FRAME_SIZE/m->period_scale;
+  m->freq_size = n + 1;
+  m->pitch_min_period = PITCH_MIN_PERIOD/m->period_scale;
+  m->pitch_max_period = PITCH_MAX_PERIOD/m->period_scale;
+  m->pitch_frame_size = PITCH_FRAME_SIZE/m->period_scale;
+  m->pitch_buf_size = m->pitch_max_period + m->pitch_frame_size;
+  m->a_hp[0] = mode_params[k].a_hp[0];
+  m->a_hp[1] = mode_params[k].a_hp[1];
+  m->rfft = rnn_rfft_alloc(2*n, rnn_select_arch());
+  for (i=0;i<n;i++)
+    m->half_window[i] = sin(.5*M_PI*sin(.5*M_PI*(i+.5)/n) * sin(.5*M_PI*(i+.5)/n));
+}
+
+static void init_common(void) {
   int i;
-  if (common.init) return;
-  common.kfft = opus_fft_alloc_twiddles(2*FRAME_SIZE, NULL, NULL, NULL, 0);
-  for (i=0;i<FRAME_SIZE;i++)
-    common.half_window[i] = sin(.5*M_PI*sin(.5*M_PI*(i+.5)/FRAME_SIZE) * sin(.5*M_PI*(i+.5)/FRAME_SIZE));
+  for (i=0;i<NB_MODES;i++)
+    init_mode(&common.modes[i], i);
   for (i=0;i<NB_BANDS;i++) {
     int j;
     for (j=0;j<NB_BANDS;j++) {
@@ -180,12 +254,14 @@ static void check_init() {
       if (j==0) common.dct_table[i*NB_BANDS + j] *= sqrt(.5);
     }
   }
-  common.init = 1;
+}
+
+static void check_init() {
+  rnn_call_once(&common_once, init_common);
 }
 
 static void dct(float *out, const float *in) {
   int i;
-  check_init();
   for (i=0;i<NB_BANDS;i++) {
     int j;
     float sum = 0;
@@ -199,7 +275,6 @@ static void dct(float *out, const float *in) {
 #if 0
 static void idct(float *out, const float *in) {
   int i;
-  check_init();
   for (i=0;i<NB_BANDS;i++) {
     int j;
     float sum = 0;
@@ -211,47 +286,20 @@ static void idct(float *out, const float *in) {
 }
 #endif
 
-static void forward_transform(kiss_fft_cpx *out, const float *in) {
-  int i;
-  kiss_fft_cpx x[WINDOW_SIZE];
-  kiss_fft_cpx y[WINDOW_SIZE];
-  check_init();
-  for (i=0;i<WINDOW_SIZE;i++) {
-    x[i].r = in[i];
-    x[i].i = 0;
-  }
-  opus_fft(common.kfft, x, y, 0);
-  for (i=0;i<FREQ_SIZE;i++) {
-    out[i] = y[i];
-  }
+static void forward_transform(const DenoiseMode *m, kiss_fft_cpx *out, const float *in) {
+  rnn_rfft_forward(m->rfft, out, in);
 }
 
-static void inverse_transform(float *out, const kiss_fft_cpx *in) {
-  int i;
-  kiss_fft_cpx x[WINDOW_SIZE];
-  kiss_fft_cpx y[WINDOW_SIZE];
-  check_init();
-  for (i=0;i<FREQ_SIZE;i++) {
-    x[i] = in[i];
-  }
-  for (;i<WINDOW_SIZE;i++) {
-    x[i].r = x[WINDOW_SIZE - i].r;
-    x[i].i = -x[WINDOW_SIZE - i].i;
-  }
-  opus_fft(common.kfft, x, y, 0);
-  /* output in reverse order for IFFT. */
-  out[0] = WINDOW_SIZE*y[0].r;
-  for (i=1;i<WINDOW_SIZE;i++) {
-    out[i] = WINDOW_SIZE*y[WINDOW_SIZE - i].r;
-  }
+static void inverse_transform(const DenoiseMode *m, float *out, const kiss_fft_cpx *in) {
+  rnn_rfft_inverse(m->rfft, out, in);
 }
 
-static void apply_window(float *x) {
+static void apply_window(const DenoiseMode *m, float *x) {
   int i;
-  check_init();
-  for (i=0;i<FRAME_SIZE;i++) {
-    x[i] *= common.half_window[i];
-    x[WINDOW_SIZE - 1 - i] *= common.half_window[i];
+  int n = m->frame_size;
+  for (i=0;i<n;i++) {
+    x[i] *= m->half_window[i];
+    x[2*n - 1 - i] *= m->half_window[i];
   }
 }
 
@@ -260,24 +308,63 @@ int rnnoise_get_size() {
 }
 
 int rnnoise_init(DenoiseState *st, RNNModel *model) {
+  return rnnoise_init_rate(st, model, 48000);
+}
+
+int rnnoise_init_rate(DenoiseState *st, RNNModel *model, int sample_rate) {
+  int i;
   memset(st, 0, sizeof(*st));
+  check_init();
+  for (i=0;i<NB_MODES;i++) {
+    if (common.modes[i].rate == sample_rate)
+      st->mode = &common.modes[i];
+  }
+  if (!st->mode)
+    return -1;
   if (model)
     st->rnn.model = model;
   else
     st->rnn.model = &rnnoise_model_orig;
+  st->rnn.arch = rnn_select_arch();
+#if TRAINING
+  st->lowpass = st->mode->freq_size;
+#endif
   st->rnn.vad_gru_state = calloc(sizeof(float), st->rnn.model->vad_gru_size);
   st->rnn.noise_gru_state = calloc(sizeof(float), st->rnn.model->noise_gru_size);
   st->rnn.denoise_gru_state = calloc(sizeof(float), st->rnn.model->denoise_gru_size);
   return 0;
 }
 
+int rnnoise_set_quantized(DenoiseState *st, int enabled) {
+  const RNNInt8Model *q = NULL;
+  if (enabled) {
+    q = rnn_int8_model_get(st->rnn.model);
+    if (!q) return -1;
+  }
+  st->rnn.int8 = q;
+  return 0;
+}
+
 DenoiseState *rnnoise_create(RNNModel *model) {
+  return rnnoise_create_rate(model, 48000);
+}
+
+DenoiseState *rnnoise_create_rate(RNNModel *model, int sample_rate) {
   DenoiseState *st;
   st = malloc(rnnoise_get_size());
-  rnnoise_init(st, model);
+  if (!st)
+    return NULL;
+  if (rnnoise_init_rate(st, model, sample_rate) != 0) {
+    free(st);
+    return NULL;
+  }
   return st;
 }
 
+int rnnoise_get_frame_size(const DenoiseState *st) {
+  return st->mode->frame_size;
+}
+
 void rnnoise_destroy(DenoiseState *st) {
   free(st->rnn.vad_gru_state);
   free(st->rnn.noise_gru_state);
@@ -285,24 +372,21 @@ void rnnoise_destroy(DenoiseState *st) {
   free(st);
 }
 
-#if TRAINING
-int lowpass = FREQ_SIZE;
-int band_lp = NB_BANDS;
-#endif
-
 static void frame_analysis(DenoiseState *st, kiss_fft_cpx *X, float *Ex, const float *in) {
   int i;
+  const DenoiseMode *m = st->mode;
+  int n = m->frame_size;
   float x[WINDOW_SIZE];
-  RNN_COPY(x, st->analysis_mem, FRAME_SIZE);
-  for (i=0;i<FRAME_SIZE;i++) x[FRAME_SIZE + i] = in[i];
-  RNN_COPY(st->analysis_mem, in, FRAME_SIZE);
-  apply_window(x);
-  forward_transform(X, x);
+  RNN_COPY(x, st->analysis_mem, n);
+  for (i=0;i<n;i++) x[n + i] = in[i];
+  RNN_COPY(st->analysis_mem, in, n);
+  apply_window(m, x);
+  forward_transform(m, X, x);
 #if TRAINING
-  for (i=lowpass;i<FREQ_SIZE;i++)
+  for (i=st->lowpass;i<m->freq_size;i++)
     X[i].r = X[i].i = 0;
 #endif
-  compute_band_energy(Ex, X);
+  compute_band_energy(m, Ex, X);
 }
 
 static int compute_frame_features(DenoiseState *st, kiss_fft_cpx *X, kiss_fft_cpx *P,
@@ -319,31 +403,35 @@ static int compute_frame_features(DenoiseState *st, kiss_fft_cpx *X, kiss_fft_cp
   float *(pre[1]);
   float tmp[NB_BANDS];
   float follow, logMax;
+  const DenoiseMode *m = st->mode;
+  int n = m->frame_size;
+  int buf_size = m->pitch_buf_size;
   frame_analysis(st, X, Ex, in);
-  RNN_MOVE(st->pitch_buf, &st->pitch_buf[FRAME_SIZE], PITCH_BUF_SIZE-FRAME_SIZE);
-  RNN_COPY(&st->pitch_buf[PITCH_BUF_SIZE-FRAME_SIZE], in, FRAME_SIZE);
+  RNN_MOVE(st->pitch_buf, &st->pitch_buf[n], buf_size-n);
+  RNN_COPY(&st->pitch_buf[buf_size-n], in, n);
   pre[0] = &st->pitch_buf[0];
-  pitch_downsample(pre, pitch_buf, PITCH_BUF_SIZE, 1);
-  pitch_search(pitch_buf+(PITCH_MAX_PERIOD>>1), pitch_buf, PITCH_FRAME_SIZE,
-               PITCH_MAX_PERIOD-3*PITCH_MIN_PERIOD, &pitch_index);
-  pitch_index = PITCH_MAX_PERIOD-pitch_index;
+  rnn_pitch_downsample(pre, pitch_buf, buf_size, 1, st->rnn.arch);
+  rnn_pitch_search(pitch_buf+(m->pitch_max_period>>1), pitch_buf, m->pitch_frame_size,
+               m->pitch_max_period-3*m->pitch_min_period, &pitch_index, st->rnn.arch);
+  pitch_index = m->pitch_max_period-pitch_index;
 
-  gain = remove_doubling(pitch_buf, PITCH_MAX_PERIOD, PITCH_MIN_PERIOD,
-          PITCH_FRAME_SIZE, &pitch_index, st->last_period, st->last_gain);
+  gain = rnn_remove_doubling(pitch_buf, m->pitch_max_period, m->pitch_min_period,
+          m->pitch_frame_size, &pitch_index, st->last_period, st->last_gain, st->rnn.arch);
   st->last_period = pitch_index;
   st->last_gain = gain;
-  for (i=0;i<WINDOW_SIZE;i++)
-    p[i] = st->pitch_buf[PITCH_BUF_SIZE-WINDOW_SIZE-pitch_index+i];
-  apply_window(p);
-  forward_transform(P, p);
-  compute_band_energy(Ep, P);
-  compute_band_corr(Exp, X, P);
+  for (i=0;i<2*n;i++)
+    p[i] = st->pitch_buf[buf_size-2*n-pitch_index+i];
+  apply_window(m, p);
+  forward_transform(m, P, p);
+  compute_band_energy(m, Ep, P);
+  compute_band_corr(m, Exp, X, P);
   for (i=0;i<NB_BANDS;i++) Exp[i] = Exp[i]/sqrt(.001+Ex[i]*Ep[i]);
   dct(tmp, Exp);
   for (i=0;i<NB_DELTA_CEPS;i++) features[NB_BANDS+2*NB_DELTA_CEPS+i] = tmp[i];
   features[NB_BANDS+2*NB_DELTA_CEPS] -= 1.3;
   features[NB_BANDS+2*NB_DELTA_CEPS+1] -= 0.9;
-  features[NB_BANDS+3*NB_DELTA_CEPS] = .01*(pitch_index-300);
+  /* The model knows periods in 48 kHz samples */
+  features[NB_BANDS+3*NB_DELTA_CEPS] = .01*(pitch_index*m->period_scale-300);
   logMax = -2;
   follow = -2;
   for (i=0;i<NB_BANDS;i++) {
@@ -399,10 +487,11 @@ static int compute_frame_features(DenoiseState *st, kiss_fft_cpx *X, kiss_fft_cp
 static void frame_synthesis(DenoiseState *st, float *out, const kiss_fft_cpx *y) {
   float x[WINDOW_SIZE];
   int i;
-  inverse_transform(x, y);
-  apply_window(x);
-  for (i=0;i<FRAME_SIZE;i++) out[i] = x[i] + st->synthesis_mem[i];
-  RNN_COPY(st->synthesis_mem, &x[FRAME_SIZE], FRAME_SIZE);
+  int n = st->mode->frame_size;
+  inverse_transform(st->mode, x, y);
+  apply_window(st->mode, x);
+  for (i=0;i<n;i++) out[i] = x[i] + st->synthesis_mem[i];
+  RNN_COPY(st->synthesis_mem, &x[n], n);
 }
 
 static void biquad(float *y, float mem[2], const float *x, const float *b, const float *a, int N) {
@@ -417,7 +506,7 @@ static void biquad(float *y, float mem[2], const float *x, const float *b, const
   }
 }
 
-void pitch_filter(kiss_fft_cpx *X, const kiss_fft_cpx *P, const float *Ex, const float *Ep,
+void pitch_filter(const DenoiseMode *m, kiss_fft_cpx *X, const kiss_fft_cpx *P, const float *Ex, const float *Ep,
                   const float *Exp, const float *g) {
   int i;
   float r[NB_BANDS];
@@ -434,63 +523,119 @@ void pitch_filter(kiss_fft_cpx *X, const kiss_fft_cpx *P, const float *Ex, const
 #endif
     r[i] *= sqrt(Ex[i]/(1e-8+Ep[i]));
   }
-  interp_band_gain(rf, r);
-  for (i=0;i<FREQ_SIZE;i++) {
+  interp_band_gain(m, rf, r);
+  for (i=0;i<m->freq_size;i++) {
     X[i].r += rf[i]*P[i].r;
     X[i].i += rf[i]*P[i].i;
   }
   float newE[NB_BANDS];
-  compute_band_energy(newE, X);
+  compute_band_energy(m, newE, X);
   float norm[NB_BANDS];
   float normf[FREQ_SIZE]={0};
   for (i=0;i<NB_BANDS;i++) {
     norm[i] = sqrt(Ex[i]/(1e-8+newE[i]));
   }
-  interp_band_gain(normf, norm);
-  for (i=0;i<FREQ_SIZE;i++) {
+  interp_band_gain(m, normf, norm);
+  for (i=0;i<m->freq_size;i++) {
     X[i].r *= normf[i];
     X[i].i *= normf[i];
   }
 }
 
-float rnnoise_process_frame(DenoiseState *st, float *out, const float *in) {
-  int i;
+/* Everything one frame needs between feature extraction and synthesis. */
+typedef struct {
   kiss_fft_cpx X[FREQ_SIZE];
-  kiss_fft_cpx P[WINDOW_SIZE];
-  float x[FRAME_SIZE];
+  kiss_fft_cpx P[FREQ_SIZE];
   float Ex[NB_BANDS], Ep[NB_BANDS];
   float Exp[NB_BANDS];
   float features[NB_FEATURES];
   float g[NB_BANDS];
-  float gf[FREQ_SIZE]={1};
-  float vad_prob = 0;
   int silence;
-  static const float a_hp[2] = {-1.99599, 0.99600};
+} FrameAnalysis;
+
+static void analyze_frame(DenoiseState *st, FrameAnalysis *a, const float *in) {
+  float x[FRAME_SIZE];
   static const float b_hp[2] = {-2, 1};
-  biquad(x, st->mem_hp_x, in, b_hp, a_hp, FRAME_SIZE);
-  silence = compute_frame_features(st, X, P, Ex, Ep, Exp, features, x);
+  biquad(x, st->mem_hp_x, in, b_hp, st->mode->a_hp, st->mode->frame_size);
+  a->silence = compute_frame_features(st, a->X, a->P, a->Ex, a->Ep, a->Exp, a->features, x);
+}
 
-  if (!silence) {
-    compute_rnn(&st->rnn, g, &vad_prob, features);
-    pitch_filter(X, P, Ex, Ep, Exp, g);
+/* Applies the gains the RNN produced in a->g (skipped for silence) and
+   synthesizes the output. */
+static void apply_gains(DenoiseState *st, FrameAnalysis *a, float *out) {
+  int i;
+  float gf[FREQ_SIZE]={1};
+  if (!a->silence) {
+    pitch_filter(st->mode, a->X, a->P, a->Ex, a->Ep, a->Exp, a->g);
     for (i=0;i<NB_BANDS;i++) {
       float alpha = .6f;
-      g[i] = MAX16(g[i], alpha*st->lastg[i]);
-      st->lastg[i] = g[i];
+      a->g[i] = MAX16(a->g[i], alpha*st->lastg[i]);
+      st->lastg[i] = a->g[i];
     }
-    interp_band_gain(gf, g);
+    interp_band_gain(st->mode, gf, a->g);
 #if 1
-    for (i=0;i<FREQ_SIZE;i++) {
-      X[i].r *= gf[i];
-      X[i].i *= gf[i];
+    for (i=0;i<st->mode->freq_size;i++) {
+      a->X[i].r *= gf[i];
+      a->X[i].i *= gf[i];
     }
 #endif
   }
 
-  frame_synthesis(st, out, X);
+  frame_synthesis(st, out, a->X);
+}
+
+float rnnoise_process_frame(DenoiseState *st, float *out, const float *in) {
+  FrameAnalysis a;
+  float vad_prob = 0;
+  analyze_frame(st, &a, in);
+  if (!a.silence)
+    compute_rnn(&st->rnn, a.g, &vad_prob, a.features);
+  apply_gains(st, &a, out);
   return vad_prob;
 }
 
+void rnnoise_process_frames(DenoiseState **st, float **out, const float *const *in, float *vad, int count) {
+  int start;
+  /* Feature extraction and synthesis are per stream; the RNN, where the
+     weights dominate, runs on up to RNN_MAX_BATCH non-silent streams with
+     the same model and int8 setting at a time. */
+  for (start=0;start<count;start+=RNN_MAX_BATCH) {
+    FrameAnalysis a[RNN_MAX_BATCH];
+    int done[RNN_MAX_BATCH];
+    int n = IMIN(count - start, RNN_MAX_BATCH);
+    int k, l;
+    for (k=0;k<n;k++) {
+      analyze_frame(st[start+k], &a[k], in[start+k]);
+      vad[start+k] = 0;
+      done[k] = a[k].silence;
+    }
+    for (k=0;k<n;k++) {
+      RNNState *rnn[RNN_MAX_BATCH];
+      float *gains[RNN_MAX_BATCH];
+      const float *features[RNN_MAX_BATCH];
+      float batch_vad[RNN_MAX_BATCH];
+      int index[RNN_MAX_BATCH];
+      int m = 0;
+      if (done[k]) continue;
+      for (l=k;l<n;l++) {
+        if (done[l] || st[start+l]->rnn.model != st[start+k]->rnn.model
+            || st[start+l]->rnn.int8 != st[start+k]->rnn.int8) continue;
+        rnn[m] = &st[start+l]->rnn;
+        gains[m] = a[l].g;
+        features[m] = a[l].features;
+        index[m] = l;
+        done[l] = 1;
+        m++;
+      }
+      compute_rnn_batch(rnn, m, gains, batch_vad, features);
+      for (l=0;l<m;l++)
+        vad[start+index[l]] = batch_vad[l];
+    }
+    for (k=0;k<n;k++)
+      apply_gains(st[start+k], &a[k], out[start+k]);
+  }
+}
+
 #if TRAINING
 
 static float uni_rand() {
@@ -522,6 +667,8 @@ int main(int argc, char **argv) {
   float xn[FRAME_SIZE];
   int vad_cnt=0;
   int gain_change_count=0;
+  int lowpass = FREQ_SIZE;
+  int band_lp = NB_BANDS;
   float speech_gain = 1, noise_gain = 1;
   FILE *f1, *f2;
   int maxCount;
@@ -570,6 +717,7 @@ int main(int argc, char **argv) {
           break;
         }
       }
+      st->lowpass = noise_state->lowpass = noisy->lowpass = lowpass;
     }
     if (speech_gain != 0) {
       fread(tmp, sizeof(short), FRAME_SIZE, f1);
@@ -618,7 +766,7 @@ int main(int argc, char **argv) {
     frame_analysis(noise_state, N, En, n);
     for (i=0;i<NB_BANDS;i++) Ln[i] = log10(1e-2+En[i]);
     int silence = compute_frame_features(noisy, X, P, Ex, Ep, Exp, features, xn);
-    pitch_filter(X, P, Ex, Ep, Exp, g);
+    pitch_filter(noisy->mode, X, P, Ex, Ep, Exp, g);
     //printf("%f %d\n", noisy->last_gain, noisy->last_period);
     for (i=0;i<NB_BANDS;i++) {
       g[i] = sqrt((Ey[i]+1e-3)/(Ex[i]+1e-3));
@@ -106,16 +106,16 @@ typedef struct kiss_fft_state{
 /*typedef struct kiss_fft_state* kiss_fft_cfg;*/
 
 /**
- *  opus_fft_alloc
+ *  rnn_fft_alloc
  *
  *  Initialize a FFT (or IFFT) algorithm's cfg/state buffer.
  *
- *  typical usage:      kiss_fft_cfg mycfg=opus_fft_alloc(1024,0,NULL,NULL);
+ *  typical usage:      kiss_fft_cfg mycfg=rnn_fft_alloc(1024,0,NULL,NULL);
  *
  *  The return value from fft_alloc is a cfg buffer used internally
  *  by the fft routine or NULL.
  *
- *  If lenmem is NULL, then opus_fft_alloc will allocate a cfg buffer using malloc.
+ *  If lenmem is NULL, then rnn_fft_alloc will allocate a cfg buffer using malloc.
  *  The returned value should be free()d when done to avoid memory leaks.
  *
  *  The state can be placed in a user supplied buffer 'mem':
@@ -128,12 +128,12 @@ typedef struct kiss_fft_state{
  *      buffer size in *lenmem.
  * */
 
-kiss_fft_state *opus_fft_alloc_twiddles(int nfft,void * mem,size_t * lenmem, const kiss_fft_state *base, int arch);
+kiss_fft_state *rnn_fft_alloc_twiddles(int nfft,void * mem,size_t * lenmem, const kiss_fft_state *base, int arch);
 
-kiss_fft_state *opus_fft_alloc(int nfft,void * mem,size_t * lenmem, int arch);
+kiss_fft_state *rnn_fft_alloc(int nfft,void * mem,size_t * lenmem, int arch);
 
 /**
- * opus_fft(cfg,in_out_buf)
+ * rnn_fft(cfg,in_out_buf)
  *
  * Perform an FFT on a complex input buffer.
  * for a forward FFT,
@@ -142,17 +142,17 @@ kiss_fft_state *opus_fft_alloc(int nfft,void * mem,size_t * lenmem, int arch);
  * Note that each element is complex and can be accessed like
     f[k].r and f[k].i
  * */
-void opus_fft_c(const kiss_fft_state *cfg,const kiss_fft_cpx *fin,kiss_fft_cpx *fout);
-void opus_ifft_c(const kiss_fft_state *cfg,const kiss_fft_cpx *fin,kiss_fft_cpx *fout);
+void rnn_fft_c(const kiss_fft_state *cfg,const kiss_fft_cpx *fin,kiss_fft_cpx *fout);
+void rnn_ifft_c(const kiss_fft_state *cfg,const kiss_fft_cpx *fin,kiss_fft_cpx *fout);
 
-void opus_fft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout);
-void opus_ifft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout);
+void rnn_fft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout);
+void rnn_ifft_impl(const kiss_fft_state *st,kiss_fft_cpx *fout);
 
-void opus_fft_free(const kiss_fft_state *cfg, int arch);
+void rnn_fft_free(const kiss_fft_state *cfg, int arch);
 
 
-void opus_fft_free_arch_c(kiss_fft_state *st);
-int opus_fft_alloc_arch_c(kiss_fft_state *st);
+void rnn_fft_free_arch_c(kiss_fft_state *st);
+int rnn_fft_alloc_arch_c(kiss_fft_state *st);
 
 #if !defined(OVERRIDE_OPUS_FFT)
 /* Is run-time CPU detection enabled on this platform? */
@@ -161,37 +161,37 @@ int opus_fft_alloc_arch_c(kiss_fft_state *st);
 extern int (*const OPUS_FFT_ALLOC_ARCH_IMPL[OPUS_ARCHMASK+1])(
  kiss_fft_state *st);
 
-#define opus_fft_alloc_arch(_st, arch) \
+#define rnn_fft_alloc_arch(_st, arch) \
          ((*OPUS_FFT_ALLOC_ARCH_IMPL[(arch)&OPUS_ARCHMASK])(_st))
 
 extern void (*const OPUS_FFT_FREE_ARCH_IMPL[OPUS_ARCHMASK+1])(
  kiss_fft_state *st);
-#define opus_fft_free_arch(_st, arch) \
+#define rnn_fft_free_arch(_st, arch) \
          ((*OPUS_FFT_FREE_ARCH_IMPL[(arch)&OPUS_ARCHMASK])(_st))
 
 extern void (*const OPUS_FFT[OPUS_ARCHMASK+1])(const kiss_fft_state *cfg,
  const kiss_fft_cpx *fin, kiss_fft_cpx *fout);
-#define opus_fft(_cfg, _fin, _fout, arch) \
+#define rnn_fft(_cfg, _fin, _fout, arch) \
    ((*OPUS_FFT[(arch)&OPUS_ARCHMASK])(_cfg, _fin, _fout))
 
 extern void (*const OPUS_IFFT[OPUS_ARCHMASK+1])(const kiss_fft_state *cfg,
  const kiss_fft_cpx *fin, kiss_fft_cpx *fout);
-#define opus_ifft(_cfg, _fin, _fout, arch) \
+#define rnn_ifft(_cfg, _fin, _fout, arch) \
    ((*OPUS_IFFT[(arch)&OPUS_ARCHMASK])(_cfg, _fin, _fout))
 
 #else /* else for if defined(OPUS_HAVE_RTCD) && (defined(HAVE_ARM_NE10)) */
 
-#define opus_fft_alloc_arch(_st, arch) \
-         ((void)(arch), opus_fft_alloc_arch_c(_st))
+#define rnn_fft_alloc_arch(_st, arch) \
+         ((void)(arch), rnn_fft_alloc_arch_c(_st))
 
-#define opus_fft_free_arch(_st, arch) \
-         ((void)(arch), opus_fft_free_arch_c(_st))
+#define rnn_fft_free_arch(_st, arch) \
+         ((void)(arch), rnn_fft_free_arch_c(_st))
 
-#define opus_fft(_cfg, _fin, _fout, arch) \
-         ((void)(arch), opus_fft_c(_cfg, _fin, _fout))
+#define rnn_fft(_cfg, _fin, _fout, arch) \
+         ((void)(arch), rnn_fft_c(_cfg, _fin, _fout))
 
-#define opus_ifft(_cfg, _fin, _fout, arch) \
-         ((void)(arch), opus_ifft_c(_cfg, _fin, _fout))
+#define rnn_ifft(_cfg, _fin, _fout, arch) \
+         ((void)(arch), rnn_ifft_c(_cfg, _fin, _fout))
 
 #endif /* end if defined(OPUS_HAVE_RTCD) && (defined(HAVE_ARM_NE10)) */
 #endif /* end if !defined(OVERRIDE_OPUS_FFT) */
@@ -42,6 +42,41 @@
 //#include "mathops.h"
 #include "celt_lpc.h"
 #include "math.h"
+#include "cpu_support.h"
+
+#if defined(RNN_X86_MAY_HAVE_AVX2) && !defined(FIXED_POINT)
+#define RNN_PITCH_X86
+#include "x86/pitch_x86.h"
+#endif
+
+static opus_val32 inner_prod(const opus_val16 *x, const opus_val16 *y, int N, int arch)
+{
+#ifdef RNN_PITCH_X86
+   if (arch >= RNN_ARCH_AVX2)
+      return rnn_inner_prod_avx2(x, y, N);
+   if (arch >= RNN_ARCH_SSE4_1)
+      return rnn_inner_prod_sse4_1(x, y, N);
+#endif
+   (void)arch;
+   return celt_inner_prod(x, y, N);
+}
+
+static void dual_prod(const opus_val16 *x, const opus_val16 *y01, const opus_val16 *y02,
+      int N, opus_val32 *xy1, opus_val32 *xy2, int arch)
+{
+#ifdef RNN_PITCH_X86
+   if (arch >= RNN_ARCH_AVX2) {
+      rnn_dual_inner_prod_avx2(x, y01, y02, N, xy1, xy2);
+      return;
+   }
+   if (arch >= RNN_ARCH_SSE4_1) {
+      rnn_dual_inner_prod_sse4_1(x, y01, y02, N, xy1, xy2);
+      return;
+   }
+#endif
+   (void)arch;
+   dual_inner_prod(x, y01, y02, N, xy1, xy2);
+}
 
 static void find_best_pitch(opus_val32 *xcorr, opus_val16 *y, int len,
                             int max_pitch, int *best_pitch
@@ -145,8 +180,8 @@ static void celt_fir5(const opus_val16 *x,
 }
 
 
-void pitch_downsample(celt_sig *x[], opus_val16 *x_lp,
-      int len, int C)
+void rnn_pitch_downsample(celt_sig *x[], opus_val16 *x_lp,
+      int len, int C, int arch)
 {
    int i;
    opus_val32 ac[5];
@@ -180,8 +215,8 @@ void pitch_downsample(celt_sig *x[], opus_val16 *x_lp,
       x_lp[0] += SHR32(HALF32(HALF32(x[1][1])+x[1][0]), shift);
    }
 
-   _celt_autocorr(x_lp, ac, NULL, 0,
-                  4, len>>1);
+   rnn_autocorr(x_lp, ac, NULL, 0,
+                  4, len>>1, arch);
 
    /* Noise floor -40 dB */
 #ifdef FIXED_POINT
@@ -200,7 +235,7 @@ void pitch_downsample(celt_sig *x[], opus_val16 *x_lp,
 #endif
    }
 
-   _celt_lpc(lpc, ac, 4);
+   rnn_lpc(lpc, ac, 4);
    for (i=0;i<4;i++)
    {
       tmp = MULT16_16_Q15(QCONST16(.9f,15), tmp);
@@ -215,9 +250,20 @@ void pitch_downsample(celt_sig *x[], opus_val16 *x_lp,
    celt_fir5(x_lp, lpc2, x_lp, len>>1, mem);
 }
 
-void celt_pitch_xcorr(const opus_val16 *_x, const opus_val16 *_y,
-      opus_val32 *xcorr, int len, int max_pitch)
+void rnn_pitch_xcorr(const opus_val16 *_x, const opus_val16 *_y,
+      opus_val32 *xcorr, int len, int max_pitch, int arch)
 {
+#ifdef RNN_PITCH_X86
+   if (arch >= RNN_ARCH_AVX2) {
+      rnn_pitch_xcorr_avx2(_x, _y, xcorr, len, max_pitch);
+      return;
+   }
+   if (arch >= RNN_ARCH_SSE4_1) {
+      rnn_pitch_xcorr_sse4_1(_x, _y, xcorr, len, max_pitch);
+      return;
+   }
+#endif
+   (void)arch;
 
 #if 0 /* This is a simple version of the pitch correlation that should work
          well on DSPs like Blackfin and TI C5x/C6x */
@@ -280,8 +326,8 @@ void celt_pitch_xcorr(const opus_val16 *_x, const opus_val16 *_y,
 #endif
 }
 
-void pitch_search(const opus_val16 *x_lp, opus_val16 *y,
-                  int len, int max_pitch, int *pitch)
+void rnn_pitch_search(const opus_val16 *x_lp, opus_val16 *y,
+                  int len, int max_pitch, int *pitch, int arch)
 {
    int i, j;
    int lag;
@@ -329,7 +375,7 @@ void pitch_search(const opus_val16 *x_lp, opus_val16 *y,
 #ifdef FIXED_POINT
    maxcorr =
 #endif
-   celt_pitch_xcorr(x_lp4, y_lp4, xcorr, len>>2, max_pitch>>2);
+   rnn_pitch_xcorr(x_lp4, y_lp4, xcorr, len>>2, max_pitch>>2, arch);
 
    find_best_pitch(xcorr, y_lp4, len>>2, max_pitch>>2, best_pitch
 #ifdef FIXED_POINT
@@ -352,7 +398,7 @@ void pitch_search(const opus_val16 *x_lp, opus_val16 *y,
       for (j=0;j<len>>1;j++)
          sum += SHR32(MULT16_16(x_lp[j],y[i+j]), shift);
 #else
-      sum = celt_inner_prod(x_lp, y+i, len>>1);
+      sum = inner_prod(x_lp, y+i, len>>1, arch);
 #endif
       xcorr[i] = MAX32(-1, sum);
 #ifdef FIXED_POINT
@@ -424,8 +470,8 @@ static opus_val16 compute_pitch_gain(opus_val32 xy, opus_val32 xx, opus_val32 yy
 #endif
 
 static const int second_check[16] = {0, 0, 3, 2, 3, 2, 5, 2, 3, 2, 3, 2, 5, 2, 3, 2};
-opus_val16 remove_doubling(opus_val16 *x, int maxperiod, int minperiod,
-      int N, int *T0_, int prev_period, opus_val16 prev_gain)
+opus_val16 rnn_remove_doubling(opus_val16 *x, int maxperiod, int minperiod,
+      int N, int *T0_, int prev_period, opus_val16 prev_gain, int arch)
 {
    int k, i, T, T0;
    opus_val16 g, g0;
@@ -448,7 +494,7 @@ opus_val16 remove_doubling(opus_val16 *x, int maxperiod, int minperiod,
 
    T = T0 = *T0_;
    opus_val32 *yy_lookup = malloc(sizeof(opus_val32) * (maxperiod + 1));
-   dual_inner_prod(x, x, x-T0, N, &xx, &xy);
+   dual_prod(x, x, x-T0, N, &xx, &xy, arch);
    yy_lookup[0] = xx;
    yy=xx;
    for (i=1;i<=maxperiod;i++)
@@ -481,7 +527,7 @@ opus_val16 remove_doubling(opus_val16 *x, int maxperiod, int minperiod,
       {
          T1b = (2*second_check[k]*T0+k)/(2*k);
       }
-      dual_inner_prod(x, &x[-T1], &x[-T1b], N, &xy, &xy2);
+      dual_prod(x, &x[-T1], &x[-T1b], N, &xy, &xy2, arch);
       xy = HALF32(xy + xy2);
       yy = HALF32(yy_lookup[T1] + yy_lookup[T1b]);
       g1 = compute_pitch_gain(xy, xx, yy);
@@ -513,7 +559,7 @@ opus_val16 remove_doubling(opus_val16 *x, int maxperiod, int minperiod,
       pg = best_xy/(best_yy+1);
 
    for (k=0;k<3;k++)
-      xcorr[k] = celt_inner_prod(x, x-(T+k-1), N);
+      xcorr[k] = inner_prod(x, x-(T+k-1), N, arch);
    if ((xcorr[2]-xcorr[0]) > MULT16_32_Q15(QCONST16(.7f,15),xcorr[1]-xcorr[0]))
       offset = 1;
    else if ((xcorr[0]-xcorr[2]) > MULT16_32_Q15(QCONST16(.7f,15),xcorr[1]-xcorr[2]))
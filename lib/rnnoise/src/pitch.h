@@ -38,14 +38,15 @@
 //#include "cpu_support.h"
 #include "arch.h"
 
-void pitch_downsample(celt_sig *x[], opus_val16 *x_lp,
-      int len, int C);
+/* arch (RNN_ARCH_*) picks the correlation kernels, as in rnn.c. */
+void rnn_pitch_downsample(celt_sig *x[], opus_val16 *x_lp,
+      int len, int C, int arch);
 
-void pitch_search(const opus_val16 *x_lp, opus_val16 *y,
-                  int len, int max_pitch, int *pitch);
+void rnn_pitch_search(const opus_val16 *x_lp, opus_val16 *y,
+                  int len, int max_pitch, int *pitch, int arch);
 
-opus_val16 remove_doubling(opus_val16 *x, int maxperiod, int minperiod,
-      int N, int *T0, int prev_period, opus_val16 prev_gain);
+opus_val16 rnn_remove_doubling(opus_val16 *x, int maxperiod, int minperiod,
+      int N, int *T0, int prev_period, opus_val16 prev_gain, int arch);
 
 
 /* OPT: This is the kernel you really want to optimize. It gets used a lot
@@ -143,7 +144,7 @@ static OPUS_INLINE opus_val32 celt_inner_prod(const opus_val16 *x,
    return xy;
 }
 
-void celt_pitch_xcorr(const opus_val16 *_x, const opus_val16 *_y,
-      opus_val32 *xcorr, int len, int max_pitch);
+void rnn_pitch_xcorr(const opus_val16 *_x, const opus_val16 *_y,
+      opus_val32 *xcorr, int len, int max_pitch, int arch);
 
 #endif
@@ -0,0 +1,362 @@
+/* Real-input FFT: see real_fft.h. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include "common.h"
+#include "real_fft.h"
+#include "cpu_support.h"
+#ifdef RNN_X86_MAY_HAVE_AVX2
+#include "x86/real_fft_x86.h"
+#endif
+
+#ifndef M_PI
+#define M_PI 3.141592653589793
+#endif
+
+/* Portable instance of the stage kernels. */
+#define RFFT_NAME(x) x##_c
+#define RFFT_TARGET
+#define RFFT_W 1
+#define rv float
+#define RV_LOAD(p) (*(p))
+#define RV_STORE(p, v) (*(p) = (v))
+#define RV_SET1(x) (x)
+#define RV_ADD(a, b) ((a) + (b))
+#define RV_SUB(a, b) ((a) - (b))
+#define RV_MUL(a, b) ((a) * (b))
+#include "real_fft_tmpl.h"
+#undef RFFT_NAME
+#undef RFFT_TARGET
+#undef RFFT_W
+#undef rv
+#undef RV_LOAD
+#undef RV_STORE
+#undef RV_SET1
+#undef RV_ADD
+#undef RV_SUB
+#undef RV_MUL
+
+/* SSE2 is part of the x86-64 baseline, so that instance needs no dispatch. */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RFFT_HAVE_SSE2
+#include <emmintrin.h>
+#define RFFT_NAME(x) x##_sse2
+#define RFFT_TARGET
+#define RFFT_W 4
+#define rv __m128
+#define RV_LOAD(p) _mm_loadu_ps(p)
+#define RV_STORE(p, v) _mm_storeu_ps(p, v)
+#define RV_SET1(x) _mm_set1_ps(x)
+#define RV_ADD(a, b) _mm_add_ps(a, b)
+#define RV_SUB(a, b) _mm_sub_ps(a, b)
+#define RV_MUL(a, b) _mm_mul_ps(a, b)
+#include "real_fft_tmpl.h"
+
+/* The first radix-4 stage (s == 1) has nothing contiguous to vectorize
+   over in q, so it goes across four twiddle groups j instead: inputs and
+   twiddles load contiguously, and a 4x4 transpose turns the four outputs
+   of four butterflies into y[4j..4j+15]. */
+static void radix4_first_sse2(float *yr, float *yi, const float *xr, const float *xi,
+      int m, const float *twr, const float *twi)
+{
+   int j;
+   for (j=0;j<m;j+=4) {
+      __m128 a0r = _mm_loadu_ps(&xr[j]),       a0i = _mm_loadu_ps(&xi[j]);
+      __m128 a1r = _mm_loadu_ps(&xr[j + m]),   a1i = _mm_loadu_ps(&xi[j + m]);
+      __m128 a2r = _mm_loadu_ps(&xr[j + 2*m]), a2i = _mm_loadu_ps(&xi[j + 2*m]);
+      __m128 a3r = _mm_loadu_ps(&xr[j + 3*m]), a3i = _mm_loadu_ps(&xi[j + 3*m]);
+      __m128 t0r = _mm_add_ps(a0r, a2r), t0i = _mm_add_ps(a0i, a2i);
+      __m128 t1r = _mm_sub_ps(a0r, a2r), t1i = _mm_sub_ps(a0i, a2i);
+      __m128 t2r = _mm_add_ps(a1r, a3r), t2i = _mm_add_ps(a1i, a3i);
+      __m128 t3r = _mm_sub_ps(a1i, a3i), t3i = _mm_sub_ps(a3r, a1r);
+      __m128 y0r = _mm_add_ps(t0r, t2r), y0i = _mm_add_ps(t0i, t2i);
+      __m128 y1r = _mm_add_ps(t1r, t3r), y1i = _mm_add_ps(t1i, t3i);
+      __m128 y2r = _mm_sub_ps(t0r, t2r), y2i = _mm_sub_ps(t0i, t2i);
+      __m128 y3r = _mm_sub_ps(t1r, t3r), y3i = _mm_sub_ps(t1i, t3i);
+      __m128 wr, wi, tmp;
+#define TWIDDLE_FIRST(k) \
+      wr = _mm_loadu_ps(&twr[((k)-1)*m + j]); \
+      wi = _mm_loadu_ps(&twi[((k)-1)*m + j]); \
+      tmp = _mm_sub_ps(_mm_mul_ps(y##k##r, wr), _mm_mul_ps(y##k##i, wi)); \
+      y##k##i = _mm_add_ps(_mm_mul_ps(y##k##r, wi), _mm_mul_ps(y##k##i, wr)); \
+      y##k##r = tmp
+      TWIDDLE_FIRST(1);
+      TWIDDLE_FIRST(2);
+      TWIDDLE_FIRST(3);
+#undef TWIDDLE_FIRST
+      _MM_TRANSPOSE4_PS(y0r, y1r, y2r, y3r);
+      _MM_TRANSPOSE4_PS(y0i, y1i, y2i, y3i);
+      _mm_storeu_ps(&yr[4*j], y0r);      _mm_storeu_ps(&yi[4*j], y0i);
+      _mm_storeu_ps(&yr[4*j + 4], y1r);  _mm_storeu_ps(&yi[4*j + 4], y1i);
+      _mm_storeu_ps(&yr[4*j + 8], y2r);  _mm_storeu_ps(&yi[4*j + 8], y2i);
+      _mm_storeu_ps(&yr[4*j + 12], y3r); _mm_storeu_ps(&yi[4*j + 12], y3i);
+   }
+}
+
+/* Reverses the four floats of v. */
+#define REVERSE4(v) _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3))
+#endif
+
+rnn_rfft_state *rnn_rfft_alloc(int n, int arch)
+{
+   rnn_rfft_state *st;
+   int m, rest, len, t;
+   float *tw;
+   if (n <= 0 || n%2 || n/2 > RFFT_MAX_COMPLEX)
+      return NULL;
+   st = calloc(1, sizeof(*st));
+   if (!st)
+      return NULL;
+   st->n = n;
+   st->m = m = n/2;
+   st->arch = arch;
+   /* Radix 4 first, so every stage after the first has a stride that is a
+      multiple of 4 and vectorizes. */
+   rest = m;
+   while (rest > 1 && st->nstages < RFFT_MAX_STAGES) {
+      int p = rest%4 == 0 ? 4 : rest%2 == 0 ? 2 : rest%3 == 0 ? 3 : rest%5 == 0 ? 5 : 0;
+      if (!p) {
+         free(st);
+         return NULL;
+      }
+      st->radix[st->nstages++] = p;
+      rest /= p;
+   }
+   if (rest != 1) {
+      free(st);
+      return NULL;
+   }
+   /* Twiddles for all stages, then the split table. */
+   len = 0;
+   rest = m;
+   for (t=0;t<st->nstages;t++) {
+      rest /= st->radix[t];
+      len += (st->radix[t] - 1)*rest;
+   }
+   st->mem = malloc(sizeof(float)*2*(len + m + 1));
+   if (!st->mem) {
+      free(st);
+      return NULL;
+   }
+   tw = st->mem;
+   rest = m;
+   for (t=0;t<st->nstages;t++) {
+      int p = st->radix[t];
+      int ms = rest/p;
+      int r, j;
+      float *twr = tw;
+      float *twi = tw + (p - 1)*ms;
+      for (r=1;r<p;r++) {
+         for (j=0;j<ms;j++) {
+            double phase = -2*M_PI*j*r/rest;
+            twr[(r-1)*ms + j] = (float)cos(phase);
+            twi[(r-1)*ms + j] = (float)sin(phase);
+         }
+      }
+      st->twr[t] = twr;
+      st->twi[t] = twi;
+      tw += 2*(p - 1)*ms;
+      rest = ms;
+   }
+   {
+      float *sr = tw;
+      float *si = tw + m + 1;
+      int k;
+      for (k=0;k<=m;k++) {
+         double phase = -2*M_PI*k/n;
+         sr[k] = (float)cos(phase);
+         si[k] = (float)sin(phase);
+      }
+      st->split_r = sr;
+      st->split_i = si;
+   }
+   return st;
+}
+
+void rnn_rfft_free(rnn_rfft_state *st)
+{
+   if (st) {
+      free(st->mem);
+      free(st);
+   }
+}
+
+/* Forward complex FFT of (re, im), using (sr, si) as scratch. Returns which
+   pair holds the result: 0 for (re, im), 1 for (sr, si). */
+static int complex_fft(const rnn_rfft_state *st, float *re, float *im, float *sr, float *si)
+{
+   float *xr = re, *xi = im, *yr = sr, *yi = si;
+   int rest = st->m;
+   int s = 1;
+   int t;
+   for (t=0;t<st->nstages;t++) {
+      int p = st->radix[t];
+      int ms = rest/p;
+      int done = 0;
+      float *tmp;
+#ifdef RNN_X86_MAY_HAVE_AVX2
+      if (!done && st->arch >= RNN_ARCH_AVX2 && s%8 == 0)
+         done = rnn_rfft_stage_avx2(p, yr, yi, xr, xi, s, ms, st->twr[t], st->twi[t]);
+#endif
+#ifdef RFFT_HAVE_SSE2
+      if (!done && s%4 == 0)
+         done = stage_sse2(p, yr, yi, xr, xi, s, ms, st->twr[t], st->twi[t]);
+      if (!done && s == 1 && p == 4 && ms%4 == 0) {
+         radix4_first_sse2(yr, yi, xr, xi, ms, st->twr[t], st->twi[t]);
+         done = 1;
+      }
+#endif
+      if (!done)
+         stage_c(p, yr, yi, xr, xi, s, ms, st->twr[t], st->twi[t]);
+      tmp = xr; xr = yr; yr = tmp;
+      tmp = xi; xi = yi; yi = tmp;
+      s *= p;
+      rest = ms;
+   }
+   return xr != re;
+}
+
+/* One bin of the forward split; see rnn_rfft_forward(). */
+static OPUS_INLINE void split_forward_bin(const rnn_rfft_state *st, kiss_fft_cpx *out,
+      const float *zr, const float *zi, int k, float scale)
+{
+   const int m = st->m;
+   int a = k == m ? 0 : k;
+   int b = k == 0 ? 0 : m - k;
+   float er = zr[a] + zr[b];
+   float ei = zi[a] - zi[b];
+   float or_ = zi[a] + zi[b];
+   float oi = zr[b] - zr[a];
+   float wr = st->split_r[k], wi = st->split_i[k];
+   out[k].r = scale*(er + wr*or_ - wi*oi);
+   out[k].i = scale*(ei + wr*oi + wi*or_);
+}
+
+void rnn_rfft_forward(const rnn_rfft_state *st, kiss_fft_cpx *out, const float *in)
+{
+   float ar[RFFT_MAX_COMPLEX], ai[RFFT_MAX_COMPLEX];
+   float br[RFFT_MAX_COMPLEX], bi[RFFT_MAX_COMPLEX];
+   const float *zr, *zi;
+   const int m = st->m;
+   /* Both halves of the split are twice too big; fold that into the scaling. */
+   const float scale = .5f/st->n;
+   int k = 0;
+#ifdef RFFT_HAVE_SSE2
+   for (;k+4<=m;k+=4) {
+      __m128 lo = _mm_loadu_ps(&in[2*k]);
+      __m128 hi = _mm_loadu_ps(&in[2*k + 4]);
+      _mm_storeu_ps(&ar[k], _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm_storeu_ps(&ai[k], _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+   }
+#endif
+   for (;k<m;k++) {
+      ar[k] = in[2*k];
+      ai[k] = in[2*k + 1];
+   }
+   if (complex_fft(st, ar, ai, br, bi)) {
+      zr = br;
+      zi = bi;
+   } else {
+      zr = ar;
+      zi = ai;
+   }
+   /* With Z the FFT of z[t] = in[2t] + i*in[2t+1], E = Z[k] + conj(Z[m-k])
+      is twice the spectrum of the even samples and -i*(Z[k] - conj(Z[m-k]))
+      twice that of the odd ones, and X[k] = E + w^k*O. */
+   split_forward_bin(st, out, zr, zi, 0, scale);
+   k = 1;
+#ifdef RFFT_HAVE_SSE2
+   {
+      const __m128 vscale = _mm_set1_ps(scale);
+      for (;k+4<=m;k+=4) {
+         __m128 ar4 = _mm_loadu_ps(&zr[k]), ai4 = _mm_loadu_ps(&zi[k]);
+         __m128 br4 = REVERSE4(_mm_loadu_ps(&zr[m - k - 3]));
+         __m128 bi4 = REVERSE4(_mm_loadu_ps(&zi[m - k - 3]));
+         __m128 er = _mm_add_ps(ar4, br4), ei = _mm_sub_ps(ai4, bi4);
+         __m128 or_ = _mm_add_ps(ai4, bi4), oi = _mm_sub_ps(br4, ar4);
+         __m128 wr = _mm_loadu_ps(&st->split_r[k]), wi = _mm_loadu_ps(&st->split_i[k]);
+         __m128 xr = _mm_mul_ps(vscale, _mm_add_ps(er, _mm_sub_ps(_mm_mul_ps(wr, or_), _mm_mul_ps(wi, oi))));
+         __m128 xi = _mm_mul_ps(vscale, _mm_add_ps(ei, _mm_add_ps(_mm_mul_ps(wr, oi), _mm_mul_ps(wi, or_))));
+         _mm_storeu_ps(&out[k].r, _mm_unpacklo_ps(xr, xi));
+         _mm_storeu_ps(&out[k + 2].r, _mm_unpackhi_ps(xr, xi));
+      }
+   }
+#endif
+   for (;k<=m;k++)
+      split_forward_bin(st, out, zr, zi, k, scale);
+}
+
+/* One bin of the inverse split; see rnn_rfft_inverse(). */
+static OPUS_INLINE void split_inverse_bin(const rnn_rfft_state *st, float *ar, float *ai,
+      const kiss_fft_cpx *in, int k)
+{
+   const int m = st->m;
+   float xr = in[k].r, xi = k == 0 ? 0 : in[k].i;
+   float cr = in[m-k].r, ci = k == 0 ? 0 : -in[m-k].i;
+   float er = xr + cr, ei = xi + ci;
+   float dr = xr - cr, di = xi - ci;
+   float wr = st->split_r[k], wi = -st->split_i[k];
+   float or_ = dr*wr - di*wi;
+   float oi = dr*wi + di*wr;
+   ai[k] = er - oi;
+   ar[k] = ei + or_;
+}
+
+void rnn_rfft_inverse(const rnn_rfft_state *st, float *out, const kiss_fft_cpx *in)
+{
+   float ar[RFFT_MAX_COMPLEX], ai[RFFT_MAX_COMPLEX];
+   float br[RFFT_MAX_COMPLEX], bi[RFFT_MAX_COMPLEX];
+   const float *zr, *zi;
+   const int m = st->m;
+   int k;
+   /* The reverse of the split: Z[k] = E + i*conj(w^k)*(X[k] - conj(X[m-k])),
+      E = X[k] + conj(X[m-k]). The inverse FFT is a forward FFT with real
+      and imaginary parts swapped on the way in and out, so Z goes into
+      (ai, ar). */
+   split_inverse_bin(st, ar, ai, in, 0);
+   k = 1;
+#ifdef RFFT_HAVE_SSE2
+   for (;k+4<=m;k+=4) {
+      /* De-interleave X[k..k+3], and X[m-k-3..m-k] reversed. */
+      __m128 x01 = _mm_loadu_ps(&in[k].r), x23 = _mm_loadu_ps(&in[k + 2].r);
+      __m128 c01 = _mm_loadu_ps(&in[m - k - 3].r), c23 = _mm_loadu_ps(&in[m - k - 1].r);
+      __m128 xr = _mm_shuffle_ps(x01, x23, _MM_SHUFFLE(2, 0, 2, 0));
+      __m128 xi = _mm_shuffle_ps(x01, x23, _MM_SHUFFLE(3, 1, 3, 1));
+      __m128 cr = REVERSE4(_mm_shuffle_ps(c01, c23, _MM_SHUFFLE(2, 0, 2, 0)));
+      __m128 ci = _mm_sub_ps(_mm_setzero_ps(), REVERSE4(_mm_shuffle_ps(c01, c23, _MM_SHUFFLE(3, 1, 3, 1))));
+      __m128 er = _mm_add_ps(xr, cr), ei = _mm_add_ps(xi, ci);
+      __m128 dr = _mm_sub_ps(xr, cr), di = _mm_sub_ps(xi, ci);
+      __m128 wr = _mm_loadu_ps(&st->split_r[k]);
+      __m128 wi = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&st->split_i[k]));
+      __m128 or_ = _mm_sub_ps(_mm_mul_ps(dr, wr), _mm_mul_ps(di, wi));
+      __m128 oi = _mm_add_ps(_mm_mul_ps(dr, wi), _mm_mul_ps(di, wr));
+      _mm_storeu_ps(&ai[k], _mm_sub_ps(er, oi));
+      _mm_storeu_ps(&ar[k], _mm_add_ps(ei, or_));
+   }
+#endif
+   for (;k<m;k++)
+      split_inverse_bin(st, ar, ai, in, k);
+   if (complex_fft(st, ar, ai, br, bi)) {
+      zr = bi;
+      zi = br;
+   } else {
+      zr = ai;
+      zi = ar;
+   }
+   k = 0;
+#ifdef RFFT_HAVE_SSE2
+   for (;k+4<=m;k+=4) {
+      __m128 re = _mm_loadu_ps(&zr[k]), im = _mm_loadu_ps(&zi[k]);
+      _mm_storeu_ps(&out[2*k], _mm_unpacklo_ps(re, im));
+      _mm_storeu_ps(&out[2*k + 4], _mm_unpackhi_ps(re, im));
+   }
+#endif
+   for (;k<m;k++) {
+      out[2*k] = zr[k];
+      out[2*k + 1] = zi[k];
+   }
+}
@@ -0,0 +1,44 @@
+/* Real-input FFT for the analysis and synthesis transforms in denoise.c.
+
+   A length-n real transform is done as a length-n/2 complex FFT (a Stockham
+   mixed-radix FFT on split real/imaginary arrays, whose stages run on
+   AVX2 or SSE2 when they are wide enough) followed by the usual split into
+   the n/2+1 bins of the real spectrum. That is half the work of the
+   length-n complex FFT it replaces, before any SIMD. n/2 must factor into
+   2, 3, 4 and 5, and be at most RFFT_MAX_COMPLEX. */
+
+#ifndef REAL_FFT_H
+#define REAL_FFT_H
+
+#include "kiss_fft.h"
+
+#define RFFT_MAX_COMPLEX 960
+#define RFFT_MAX_STAGES 16
+
+typedef struct {
+   int n;                        /* Real length */
+   int m;                        /* Complex length, n/2 */
+   int nstages;
+   int radix[RFFT_MAX_STAGES];
+   const float *twr[RFFT_MAX_STAGES]; /* Per stage: w^(j*r) at [(r-1)*m_stage + j] */
+   const float *twi[RFFT_MAX_STAGES];
+   const float *split_r;         /* e^(-2*pi*i*k/n), k = 0..m */
+   const float *split_i;
+   int arch;
+   float *mem;
+} rnn_rfft_state;
+
+/* NULL if n is not supported or out of memory. */
+rnn_rfft_state *rnn_rfft_alloc(int n, int arch);
+void rnn_rfft_free(rnn_rfft_state *st);
+
+/* out[k] = 1/n * sum over t of in[t]*e^(-2*pi*i*k*t/n), for k = 0..n/2, the
+   same as the first n/2+1 outputs of kiss_fft on the real input. */
+void rnn_rfft_forward(const rnn_rfft_state *st, kiss_fft_cpx *out, const float *in);
+
+/* out[t] = sum over k of X[k]*e^(2*pi*i*k*t/n), for the Hermitian X whose
+   first n/2+1 values are in (unscaled; the imaginary parts of in[0] and
+   in[n/2] are ignored). */
+void rnn_rfft_inverse(const rnn_rfft_state *st, float *out, const kiss_fft_cpx *in);
+
+#endif
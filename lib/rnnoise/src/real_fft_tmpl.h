@@ -0,0 +1,184 @@
+/* Stockham stage kernels for real_fft.c, written once and instantiated for
+   each vector width. The includer defines:
+
+     RFFT_NAME(x)   name mangling for the instance
+     RFFT_TARGET    function attributes (instruction set), may be empty
+     rv             the vector type, RFFT_W floats wide
+     RV_LOAD(p), RV_STORE(p, v), RV_SET1(x), RV_ADD(a, b), RV_SUB(a, b),
+     RV_MUL(a, b)
+
+   A stage of radix p reads x[q + s*(j + r*m)] and writes
+   y[q + s*(p*j + r)] = w^(j*r) * DFT_p(...)[r] for the m twiddle groups j
+   and the s contiguous elements q, which are what gets vectorized: the
+   caller only uses an instance when s is a multiple of RFFT_W. Data is
+   split complex (separate real and imaginary arrays). */
+
+#define RFFT_CMUL(outr, outi, ar, ai, br, bi) do { \
+      rv cmul_ar = (ar), cmul_ai = (ai); \
+      outr = RV_SUB(RV_MUL(cmul_ar, br), RV_MUL(cmul_ai, bi)); \
+      outi = RV_ADD(RV_MUL(cmul_ar, bi), RV_MUL(cmul_ai, br)); \
+   } while (0)
+
+#define RFFT_LOAD_IN(k) \
+   rv a##k##r = RV_LOAD(&xr[q + s*(j + (k)*m)]); \
+   rv a##k##i = RV_LOAD(&xi[q + s*(j + (k)*m)])
+
+#define RFFT_STORE_OUT(k, vr, vi) do { \
+      RV_STORE(&yr[q + s*(p*j + (k))], vr); \
+      RV_STORE(&yi[q + s*(p*j + (k))], vi); \
+   } while (0)
+
+/* Output k >= 1 times its twiddle w^(j*k). */
+#define RFFT_STORE_TWIDDLED(k, vr, vi) do { \
+      rv tw_outr, tw_outi; \
+      RFFT_CMUL(tw_outr, tw_outi, vr, vi, w##k##r, w##k##i); \
+      RFFT_STORE_OUT(k, tw_outr, tw_outi); \
+   } while (0)
+
+#define RFFT_TWIDDLE(k) \
+   rv w##k##r = RV_SET1(twr[((k)-1)*m + j]); \
+   rv w##k##i = RV_SET1(twi[((k)-1)*m + j])
+
+static RFFT_TARGET void RFFT_NAME(radix2)(float *yr, float *yi, const float *xr, const float *xi,
+      int s, int m, const float *twr, const float *twi)
+{
+   const int p = 2;
+   int j, q;
+   for (j=0;j<m;j++) {
+      RFFT_TWIDDLE(1);
+      for (q=0;q<s;q+=RFFT_W) {
+         RFFT_LOAD_IN(0);
+         RFFT_LOAD_IN(1);
+         RFFT_STORE_OUT(0, RV_ADD(a0r, a1r), RV_ADD(a0i, a1i));
+         RFFT_STORE_TWIDDLED(1, RV_SUB(a0r, a1r), RV_SUB(a0i, a1i));
+      }
+   }
+}
+
+static RFFT_TARGET void RFFT_NAME(radix3)(float *yr, float *yi, const float *xr, const float *xi,
+      int s, int m, const float *twr, const float *twi)
+{
+   const int p = 3;
+   int j, q;
+   const rv half = RV_SET1(.5f);
+   const rv sin3 = RV_SET1(.86602540378443865f);
+   for (j=0;j<m;j++) {
+      RFFT_TWIDDLE(1);
+      RFFT_TWIDDLE(2);
+      for (q=0;q<s;q+=RFFT_W) {
+         rv sr, si, tr, ti, ur, ui;
+         RFFT_LOAD_IN(0);
+         RFFT_LOAD_IN(1);
+         RFFT_LOAD_IN(2);
+         sr = RV_ADD(a1r, a2r);
+         si = RV_ADD(a1i, a2i);
+         tr = RV_SUB(a0r, RV_MUL(half, sr));
+         ti = RV_SUB(a0i, RV_MUL(half, si));
+         /* -i*sin(2pi/3)*(a1 - a2) */
+         ur = RV_MUL(sin3, RV_SUB(a1i, a2i));
+         ui = RV_MUL(sin3, RV_SUB(a2r, a1r));
+         RFFT_STORE_OUT(0, RV_ADD(a0r, sr), RV_ADD(a0i, si));
+         RFFT_STORE_TWIDDLED(1, RV_ADD(tr, ur), RV_ADD(ti, ui));
+         RFFT_STORE_TWIDDLED(2, RV_SUB(tr, ur), RV_SUB(ti, ui));
+      }
+   }
+}
+
+static RFFT_TARGET void RFFT_NAME(radix4)(float *yr, float *yi, const float *xr, const float *xi,
+      int s, int m, const float *twr, const float *twi)
+{
+   const int p = 4;
+   int j, q;
+   for (j=0;j<m;j++) {
+      RFFT_TWIDDLE(1);
+      RFFT_TWIDDLE(2);
+      RFFT_TWIDDLE(3);
+      for (q=0;q<s;q+=RFFT_W) {
+         rv t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i;
+         RFFT_LOAD_IN(0);
+         RFFT_LOAD_IN(1);
+         RFFT_LOAD_IN(2);
+         RFFT_LOAD_IN(3);
+         t0r = RV_ADD(a0r, a2r);
+         t0i = RV_ADD(a0i, a2i);
+         t1r = RV_SUB(a0r, a2r);
+         t1i = RV_SUB(a0i, a2i);
+         t2r = RV_ADD(a1r, a3r);
+         t2i = RV_ADD(a1i, a3i);
+         /* -i*(a1 - a3) */
+         t3r = RV_SUB(a1i, a3i);
+         t3i = RV_SUB(a3r, a1r);
+         RFFT_STORE_OUT(0, RV_ADD(t0r, t2r), RV_ADD(t0i, t2i));
+         RFFT_STORE_TWIDDLED(1, RV_ADD(t1r, t3r), RV_ADD(t1i, t3i));
+         RFFT_STORE_TWIDDLED(2, RV_SUB(t0r, t2r), RV_SUB(t0i, t2i));
+         RFFT_STORE_TWIDDLED(3, RV_SUB(t1r, t3r), RV_SUB(t1i, t3i));
+      }
+   }
+}
+
+static RFFT_TARGET void RFFT_NAME(radix5)(float *yr, float *yi, const float *xr, const float *xi,
+      int s, int m, const float *twr, const float *twi)
+{
+   const int p = 5;
+   int j, q;
+   const rv c1 = RV_SET1(.30901699437494742f);  /* cos(2pi/5) */
+   const rv c2 = RV_SET1(-.80901699437494742f); /* cos(4pi/5) */
+   const rv s1 = RV_SET1(.95105651629515357f);  /* sin(2pi/5) */
+   const rv s2 = RV_SET1(.58778525229247313f);  /* sin(4pi/5) */
+   for (j=0;j<m;j++) {
+      RFFT_TWIDDLE(1);
+      RFFT_TWIDDLE(2);
+      RFFT_TWIDDLE(3);
+      RFFT_TWIDDLE(4);
+      for (q=0;q<s;q+=RFFT_W) {
+         rv b1r, b1i, b2r, b2i, d1r, d1i, d2r, d2i;
+         rv t1r, t1i, t2r, t2i, u1r, u1i, u2r, u2i;
+         RFFT_LOAD_IN(0);
+         RFFT_LOAD_IN(1);
+         RFFT_LOAD_IN(2);
+         RFFT_LOAD_IN(3);
+         RFFT_LOAD_IN(4);
+         b1r = RV_ADD(a1r, a4r);
+         b1i = RV_ADD(a1i, a4i);
+         b2r = RV_ADD(a2r, a3r);
+         b2i = RV_ADD(a2i, a3i);
+         d1r = RV_SUB(a1r, a4r);
+         d1i = RV_SUB(a1i, a4i);
+         d2r = RV_SUB(a2r, a3r);
+         d2i = RV_SUB(a2i, a3i);
+         t1r = RV_ADD(a0r, RV_ADD(RV_MUL(c1, b1r), RV_MUL(c2, b2r)));
+         t1i = RV_ADD(a0i, RV_ADD(RV_MUL(c1, b1i), RV_MUL(c2, b2i)));
+         t2r = RV_ADD(a0r, RV_ADD(RV_MUL(c2, b1r), RV_MUL(c1, b2r)));
+         t2i = RV_ADD(a0i, RV_ADD(RV_MUL(c2, b1i), RV_MUL(c1, b2i)));
+         /* u1 = -i*(s1*d1 + s2*d2), u2 = -i*(s2*d1 - s1*d2) */
+         u1r = RV_ADD(RV_MUL(s1, d1i), RV_MUL(s2, d2i));
+         u1i = RV_SUB(RV_SUB(RV_SET1(0.f), RV_MUL(s1, d1r)), RV_MUL(s2, d2r));
+         u2r = RV_SUB(RV_MUL(s2, d1i), RV_MUL(s1, d2i));
+         u2i = RV_SUB(RV_MUL(s1, d2r), RV_MUL(s2, d1r));
+         RFFT_STORE_OUT(0, RV_ADD(a0r, RV_ADD(b1r, b2r)), RV_ADD(a0i, RV_ADD(b1i, b2i)));
+         RFFT_STORE_TWIDDLED(1, RV_ADD(t1r, u1r), RV_ADD(t1i, u1i));
+         RFFT_STORE_TWIDDLED(2, RV_ADD(t2r, u2r), RV_ADD(t2i, u2i));
+         RFFT_STORE_TWIDDLED(3, RV_SUB(t2r, u2r), RV_SUB(t2i, u2i));
+         RFFT_STORE_TWIDDLED(4, RV_SUB(t1r, u1r), RV_SUB(t1i, u1i));
+      }
+   }
+}
+
+/* Runs one stage; returns 0 for a radix this file has no kernel for. */
+static RFFT_TARGET int RFFT_NAME(stage)(int p, float *yr, float *yi, const float *xr, const float *xi,
+      int s, int m, const float *twr, const float *twi)
+{
+   switch (p) {
+   case 2: RFFT_NAME(radix2)(yr, yi, xr, xi, s, m, twr, twi); return 1;
+   case 3: RFFT_NAME(radix3)(yr, yi, xr, xi, s, m, twr, twi); return 1;
+   case 4: RFFT_NAME(radix4)(yr, yi, xr, xi, s, m, twr, twi); return 1;
+   case 5: RFFT_NAME(radix5)(yr, yi, xr, xi, s, m, twr, twi); return 1;
+   }
+   return 0;
+}
+
+#undef RFFT_CMUL
+#undef RFFT_LOAD_IN
+#undef RFFT_STORE_OUT
+#undef RFFT_STORE_TWIDDLED
+#undef RFFT_TWIDDLE
@@ -36,6 +36,11 @@
 #include "tansig_table.h"
 #include "rnn.h"
 #include "rnn_data.h"
+#include "rnn_int8.h"
+#include "cpu_support.h"
+#ifdef RNN_X86_MAY_HAVE_AVX2
+#include "x86/rnn_x86.h"
+#endif
 #include <stdio.h>
 
 static OPUS_INLINE float tansig_approx(float x)
@@ -76,103 +81,203 @@ static OPUS_INLINE float relu(float x)
    return x < 0 ? 0 : x;
 }
 
-static void compute_dense(const DenseLayer *layer, float *output, const float *input)
+void rnn_gemv_accum_c(float *out, const rnn_weight *weights, int stride,
+      int N, int M, const float *x, const float *x2)
 {
    int i, j;
-   int N, M;
-   int stride;
-   M = layer->nb_inputs;
-   N = layer->nb_neurons;
-   stride = N;
    for (i=0;i<N;i++)
    {
-      /* Compute update gate. */
-      float sum = layer->bias[i];
-      for (j=0;j<M;j++)
-         sum += layer->input_weights[j*stride + i]*input[j];
-      output[i] = WEIGHTS_SCALE*sum;
+      float sum = out[i];
+      if (x2) {
+         for (j=0;j<M;j++)
+            sum += weights[j*stride + i]*x[j]*x2[j];
+      } else {
+         for (j=0;j<M;j++)
+            sum += weights[j*stride + i]*x[j];
+      }
+      out[i] = sum;
+   }
+}
+
+void rnn_gemm_accum_c(float *out, int out_stride, const rnn_weight *weights, int stride,
+      int N, int M, const float *x, const float *x2, int x_stride, int K)
+{
+   int k;
+   for (k=0;k<K;k++)
+      rnn_gemv_accum_c(&out[k*out_stride], weights, stride, N, M, &x[k*x_stride],
+            x2 ? &x2[k*x_stride] : NULL);
+}
+
+/* With packed weights qw (not NULL in the int8 mode) those are used instead
+   of weights and stride. */
+static void gemm_accum(float *out, int out_stride, const rnn_weight *weights, int stride,
+      const Int8Matrix *qw, int N, int M, const float *x, const float *x2, int x_stride,
+      int K, int arch)
+{
+   if (qw) {
+      rnn_int8_gemm_accum(out, out_stride, qw, x, x2, x_stride, K, arch);
+      return;
+   }
+#ifdef RNN_X86_MAY_HAVE_AVX2
+   if (arch >= RNN_ARCH_AVX2) {
+      if (K == 1)
+         rnn_gemv_accum_avx2(out, weights, stride, N, M, x, x2);
+      else
+         rnn_gemm_accum_avx2(out, out_stride, weights, stride, N, M, x, x2, x_stride, K);
+      return;
    }
-   if (layer->activation == ACTIVATION_SIGMOID) {
+#endif
+   (void)arch;
+   rnn_gemm_accum_c(out, out_stride, weights, stride, N, M, x, x2, x_stride, K);
+}
+
+static void load_bias(float *out, const rnn_weight *bias, int N)
+{
+   int i;
+   for (i=0;i<N;i++)
+      out[i] = bias[i];
+}
+
+/* Scales the sums and applies the activation, deciding which one once per
+   layer rather than once per neuron. */
+static void activate(float *out, const float *sum, int N, int activation)
+{
+   int i;
+   if (activation == ACTIVATION_SIGMOID) {
       for (i=0;i<N;i++)
-         output[i] = sigmoid_approx(output[i]);
-   } else if (layer->activation == ACTIVATION_TANH) {
+         out[i] = sigmoid_approx(WEIGHTS_SCALE*sum[i]);
+   } else if (activation == ACTIVATION_TANH) {
       for (i=0;i<N;i++)
-         output[i] = tansig_approx(output[i]);
-   } else if (layer->activation == ACTIVATION_RELU) {
+         out[i] = tansig_approx(WEIGHTS_SCALE*sum[i]);
+   } else if (activation == ACTIVATION_RELU) {
       for (i=0;i<N;i++)
-         output[i] = relu(output[i]);
+         out[i] = relu(WEIGHTS_SCALE*sum[i]);
    } else {
      *(int*)0=0;
    }
 }
 
-static void compute_gru(const GRULayer *gru, float *state, const float *input)
+/* The layers work on K streams at once, one row of in_stride (or
+   out_stride, or MAX_NEURONS for GRU states) floats per stream. The packed
+   weights q are NULL unless the int8 mode is on. */
+
+static void compute_dense(const DenseLayer *layer, const Int8Matrix *q, float *output,
+      int out_stride, const float *input, int in_stride, int K, int arch)
 {
-   int i, j;
+   int k;
    int N, M;
    int stride;
-   float z[MAX_NEURONS];
-   float r[MAX_NEURONS];
+   float sum[RNN_MAX_BATCH*MAX_NEURONS];
+   M = layer->nb_inputs;
+   N = layer->nb_neurons;
+   stride = N;
+   for (k=0;k<K;k++)
+      load_bias(&sum[k*MAX_NEURONS], layer->bias, N);
+   gemm_accum(sum, MAX_NEURONS, layer->input_weights, stride, q, N, M, input, NULL, in_stride, K, arch);
+   for (k=0;k<K;k++)
+      activate(&output[k*out_stride], &sum[k*MAX_NEURONS], N, layer->activation);
+}
+
+static void compute_gru(const GRULayer *gru, const Int8GRU *q, float *state,
+      const float *input, int in_stride, int K, int arch)
+{
+   int i, k;
+   int N, M;
+   int stride;
+   float sum[RNN_MAX_BATCH*3*MAX_NEURONS];
+   float z[RNN_MAX_BATCH*MAX_NEURONS];
+   float r[RNN_MAX_BATCH*MAX_NEURONS];
    float h[MAX_NEURONS];
    M = gru->nb_inputs;
    N = gru->nb_neurons;
    stride = 3*N;
-   for (i=0;i<N;i++)
-   {
-      /* Compute update gate. */
-      float sum = gru->bias[i];
-      for (j=0;j<M;j++)
-         sum += gru->input_weights[j*stride + i]*input[j];
-      for (j=0;j<N;j++)
-         sum += gru->recurrent_weights[j*stride + i]*state[j];
-      z[i] = sigmoid_approx(WEIGHTS_SCALE*sum);
+   /* Update and reset gates: the input parts of all three gates are one
+      product, the recurrent parts of the first two another. */
+   for (k=0;k<K;k++)
+      load_bias(&sum[k*3*MAX_NEURONS], gru->bias, 3*N);
+   gemm_accum(sum, 3*MAX_NEURONS, gru->input_weights, stride, q ? &q->input : NULL,
+         3*N, M, input, NULL, in_stride, K, arch);
+   gemm_accum(sum, 3*MAX_NEURONS, gru->recurrent_weights, stride, q ? &q->recurrent_zr : NULL,
+         2*N, N, state, NULL, MAX_NEURONS, K, arch);
+   for (k=0;k<K;k++) {
+      activate(&z[k*MAX_NEURONS], &sum[k*3*MAX_NEURONS], N, ACTIVATION_SIGMOID);
+      activate(&r[k*MAX_NEURONS], &sum[k*3*MAX_NEURONS + N], N, ACTIVATION_SIGMOID);
    }
-   for (i=0;i<N;i++)
-   {
-      /* Compute reset gate. */
-      float sum = gru->bias[N + i];
-      for (j=0;j<M;j++)
-         sum += gru->input_weights[N + j*stride + i]*input[j];
-      for (j=0;j<N;j++)
-         sum += gru->recurrent_weights[N + j*stride + i]*state[j];
-      r[i] = sigmoid_approx(WEIGHTS_SCALE*sum);
-   }
-   for (i=0;i<N;i++)
-   {
-      /* Compute output. */
-      float sum = gru->bias[2*N + i];
-      for (j=0;j<M;j++)
-         sum += gru->input_weights[2*N + j*stride + i]*input[j];
-      for (j=0;j<N;j++)
-         sum += gru->recurrent_weights[2*N + j*stride + i]*state[j]*r[j];
-      if (gru->activation == ACTIVATION_SIGMOID) sum = sigmoid_approx(WEIGHTS_SCALE*sum);
-      else if (gru->activation == ACTIVATION_TANH) sum = tansig_approx(WEIGHTS_SCALE*sum);
-      else if (gru->activation == ACTIVATION_RELU) sum = relu(WEIGHTS_SCALE*sum);
-      else *(int*)0=0;
-      h[i] = z[i]*state[i] + (1-z[i])*sum;
+   /* Output, whose recurrent input is the state scaled by the reset gate. */
+   gemm_accum(&sum[2*N], 3*MAX_NEURONS, &gru->recurrent_weights[2*N], stride,
+         q ? &q->recurrent_h : NULL, N, N, state, r, MAX_NEURONS, K, arch);
+   for (k=0;k<K;k++) {
+      float *s = &state[k*MAX_NEURONS];
+      const float *zk = &z[k*MAX_NEURONS];
+      activate(h, &sum[k*3*MAX_NEURONS + 2*N], N, gru->activation);
+      for (i=0;i<N;i++)
+         s[i] = zk[i]*s[i] + (1-zk[i])*h[i];
    }
-   for (i=0;i<N;i++)
-      state[i] = h[i];
 }
 
 #define INPUT_SIZE 42
 
 void compute_rnn(RNNState *rnn, float *gains, float *vad, const float *input) {
-  int i;
-  float dense_out[MAX_NEURONS];
-  float noise_input[MAX_NEURONS*3];
-  float denoise_input[MAX_NEURONS*3];
-  compute_dense(rnn->model->input_dense, dense_out, input);
-  compute_gru(rnn->model->vad_gru, rnn->vad_gru_state, dense_out);
-  compute_dense(rnn->model->vad_output, vad, rnn->vad_gru_state);
-  for (i=0;i<rnn->model->input_dense_size;i++) noise_input[i] = dense_out[i];
-  for (i=0;i<rnn->model->vad_gru_size;i++) noise_input[i+rnn->model->input_dense_size] = rnn->vad_gru_state[i];
-  for (i=0;i<INPUT_SIZE;i++) noise_input[i+rnn->model->input_dense_size+rnn->model->vad_gru_size] = input[i];
-  compute_gru(rnn->model->noise_gru, rnn->noise_gru_state, noise_input);
-
-  for (i=0;i<rnn->model->vad_gru_size;i++) denoise_input[i] = rnn->vad_gru_state[i];
-  for (i=0;i<rnn->model->noise_gru_size;i++) denoise_input[i+rnn->model->vad_gru_size] = rnn->noise_gru_state[i];
-  for (i=0;i<INPUT_SIZE;i++) denoise_input[i+rnn->model->vad_gru_size+rnn->model->noise_gru_size] = input[i];
-  compute_gru(rnn->model->denoise_gru, rnn->denoise_gru_state, denoise_input);
-  compute_dense(rnn->model->denoise_output, gains, rnn->denoise_gru_state);
+  compute_rnn_batch(&rnn, 1, &gains, vad, &input);
+}
+
+void compute_rnn_batch(RNNState **rnn, int count, float **gains, float *vad, const float **input) {
+  int i, k;
+  const RNNModel *model = rnn[0]->model;
+  int arch = rnn[0]->arch;
+  const RNNInt8Model *q = rnn[0]->int8;
+  int dense_size = model->input_dense_size;
+  int vad_size = model->vad_gru_size;
+  int noise_size = model->noise_gru_size;
+  float in[RNN_MAX_BATCH*INPUT_SIZE];
+  float dense_out[RNN_MAX_BATCH*MAX_NEURONS];
+  float vad_gru_state[RNN_MAX_BATCH*MAX_NEURONS];
+  float noise_gru_state[RNN_MAX_BATCH*MAX_NEURONS];
+  float denoise_gru_state[RNN_MAX_BATCH*MAX_NEURONS];
+  float gru_input[RNN_MAX_BATCH*MAX_NEURONS*3]; /* For the noise GRU, then the denoise GRU */
+  float output[RNN_MAX_BATCH*MAX_NEURONS];
+  celt_assert(count >= 1 && count <= RNN_MAX_BATCH);
+
+  /* Gather the streams into rows, so each layer's weights are read once for
+     all of them. */
+  for (k=0;k<count;k++) {
+    RNN_COPY(&in[k*INPUT_SIZE], input[k], INPUT_SIZE);
+    RNN_COPY(&vad_gru_state[k*MAX_NEURONS], rnn[k]->vad_gru_state, vad_size);
+    RNN_COPY(&noise_gru_state[k*MAX_NEURONS], rnn[k]->noise_gru_state, noise_size);
+    RNN_COPY(&denoise_gru_state[k*MAX_NEURONS], rnn[k]->denoise_gru_state, model->denoise_gru_size);
+  }
+
+  compute_dense(model->input_dense, q ? &q->input_dense : NULL, dense_out, MAX_NEURONS,
+        in, INPUT_SIZE, count, arch);
+  compute_gru(model->vad_gru, q ? &q->vad_gru : NULL, vad_gru_state, dense_out, MAX_NEURONS,
+        count, arch);
+  compute_dense(model->vad_output, q ? &q->vad_output : NULL, output, MAX_NEURONS,
+        vad_gru_state, MAX_NEURONS, count, arch);
+  for (k=0;k<count;k++) {
+    float *row = &gru_input[k*MAX_NEURONS*3];
+    vad[k] = output[k*MAX_NEURONS];
+    for (i=0;i<dense_size;i++) row[i] = dense_out[k*MAX_NEURONS + i];
+    for (i=0;i<vad_size;i++) row[i+dense_size] = vad_gru_state[k*MAX_NEURONS + i];
+    for (i=0;i<INPUT_SIZE;i++) row[i+dense_size+vad_size] = in[k*INPUT_SIZE + i];
+  }
+  compute_gru(model->noise_gru, q ? &q->noise_gru : NULL, noise_gru_state, gru_input,
+        MAX_NEURONS*3, count, arch);
+
+  for (k=0;k<count;k++) {
+    float *row = &gru_input[k*MAX_NEURONS*3];
+    for (i=0;i<vad_size;i++) row[i] = vad_gru_state[k*MAX_NEURONS + i];
+    for (i=0;i<noise_size;i++) row[i+vad_size] = noise_gru_state[k*MAX_NEURONS + i];
+    for (i=0;i<INPUT_SIZE;i++) row[i+vad_size+noise_size] = in[k*INPUT_SIZE + i];
+  }
+  compute_gru(model->denoise_gru, q ? &q->denoise_gru : NULL, denoise_gru_state, gru_input,
+        MAX_NEURONS*3, count, arch);
+  compute_dense(model->denoise_output, q ? &q->denoise_output : NULL, output, MAX_NEURONS,
+        denoise_gru_state, MAX_NEURONS, count, arch);
+
+  for (k=0;k<count;k++) {
+    RNN_COPY(gains[k], &output[k*MAX_NEURONS], model->denoise_output_size);
+    RNN_COPY(rnn[k]->vad_gru_state, &vad_gru_state[k*MAX_NEURONS], vad_size);
+    RNN_COPY(rnn[k]->noise_gru_state, &noise_gru_state[k*MAX_NEURONS], noise_size);
+    RNN_COPY(rnn[k]->denoise_gru_state, &denoise_gru_state[k*MAX_NEURONS], model->denoise_gru_size);
+  }
 }
@@ -35,6 +35,9 @@
 
 #define MAX_NEURONS 128
 
+/* Most streams compute_rnn_batch() takes at once. */
+#define RNN_MAX_BATCH 8
+
 #define ACTIVATION_TANH    0
 #define ACTIVATION_SIGMOID 1
 #define ACTIVATION_RELU    2
@@ -60,6 +63,26 @@ typedef struct {
 
 typedef struct RNNState RNNState;
 
+typedef struct RNNInt8Model RNNInt8Model;
+
+typedef struct RNNMappedModel RNNMappedModel;
+
+/* out[i] += sum over j of weights[j*stride + i]*x[j] (times x2[j] if x2 is
+   not NULL), for the N neurons i and M inputs j. The portable version of
+   the kernel the dense and GRU layers are built on. */
+void rnn_gemv_accum_c(float *out, const rnn_weight *weights, int stride,
+      int N, int M, const float *x, const float *x2);
+
+/* The same for K streams: rows k*out_stride of out and k*x_stride of x and
+   x2, all against one pass over the weights. */
+void rnn_gemm_accum_c(float *out, int out_stride, const rnn_weight *weights, int stride,
+      int N, int M, const float *x, const float *x2, int x_stride, int K);
+
 void compute_rnn(RNNState *rnn, float *gains, float *vad, const float *input);
 
+/* compute_rnn() for up to RNN_MAX_BATCH states sharing one model (and int8
+   setting), with the same results as calling it on each in turn. vad gets
+   one value per state. */
+void compute_rnn_batch(RNNState **rnn, int count, float **gains, float *vad, const float **input);
+
 #endif /* _MLP_H_ */
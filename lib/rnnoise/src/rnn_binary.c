@@ -0,0 +1,432 @@
+/* Binary model files, mapped read-only and shared through a process-wide
+   cache: see rnn_binary.h. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "rnn.h"
+#include "rnn_data.h"
+#include "rnn_int8.h"
+#include "rnn_binary.h"
+#include "rnn_mutex.h"
+#include "rnnoise.h"
+
+extern const struct RNNModel rnnoise_model_orig;
+
+#define NB_LAYERS 6
+#define HEADER_SIZE (8 + 4 + NB_LAYERS*3*4)
+
+/* The network in rnn.c is wired for 42 input features and 22 band gains. */
+#define MODEL_INPUTS 42
+#define MODEL_BANDS 22
+
+typedef struct {
+   int inputs;
+   int neurons;
+   int activation;               /* ACTIVATION_* */
+} LayerShape;
+
+/* What tells two opens of the same, unchanged file apart from others. */
+typedef struct {
+   unsigned long long volume;
+   unsigned long long index;
+   unsigned long long size;
+   unsigned long long mtime;
+} FileId;
+
+struct RNNMappedModel {
+   RNNModel model;
+   DenseLayer dense[3];          /* input_dense, denoise_output, vad_output */
+   GRULayer gru[3];              /* vad_gru, noise_gru, denoise_gru */
+   const unsigned char *data;
+   size_t size;
+   FileId id;
+   int refs;
+   RNNMappedModel *next;
+};
+
+static rnn_mutex cache_lock = RNN_MUTEX_INIT;
+static RNNMappedModel *cache;
+
+static int is_gru(int layer)
+{
+   return layer >= 1 && layer <= 3;
+}
+
+/* Sizes of a layer's arrays in file order; returns how many there are. */
+static int array_sizes(const LayerShape *s, int layer, size_t *sizes)
+{
+   int gates = is_gru(layer) ? 3 : 1;
+   int n = 0;
+   sizes[n++] = (size_t)s->inputs*s->neurons*gates;
+   if (is_gru(layer))
+      sizes[n++] = (size_t)s->neurons*s->neurons*3;
+   sizes[n++] = (size_t)s->neurons*gates;
+   return n;
+}
+
+/* Where the next array of size bytes goes, with *pos the end of the
+   previous one; advances *pos past it. */
+static size_t place(size_t *pos, size_t size)
+{
+   size_t at = (*pos + RNN_BINARY_ALIGN - 1)/RNN_BINARY_ALIGN*RNN_BINARY_ALIGN;
+   *pos = at + size;
+   return at;
+}
+
+static int check_shapes(const LayerShape *s)
+{
+   int l;
+   for (l=0;l<NB_LAYERS;l++) {
+      if (s[l].inputs <= 0 || s[l].inputs > MAX_NEURONS
+            || s[l].neurons <= 0 || s[l].neurons > MAX_NEURONS)
+         return 0;
+   }
+   return s[0].inputs == MODEL_INPUTS
+         && s[1].inputs == s[0].neurons
+         && s[2].inputs == s[0].neurons + s[1].neurons + MODEL_INPUTS
+         && s[3].inputs == s[1].neurons + s[2].neurons + MODEL_INPUTS
+         && s[4].inputs == s[3].neurons && s[4].neurons == MODEL_BANDS
+         && s[5].inputs == s[1].neurons && s[5].neurons == 1;
+}
+
+static int activation_to_file(int activation)
+{
+   switch (activation) {
+      case ACTIVATION_SIGMOID: return F_ACTIVATION_SIGMOID;
+      case ACTIVATION_RELU: return F_ACTIVATION_RELU;
+      default: return F_ACTIVATION_TANH;
+   }
+}
+
+/* -1 if invalid. */
+static int activation_from_file(unsigned int activation)
+{
+   switch (activation) {
+      case F_ACTIVATION_TANH: return ACTIVATION_TANH;
+      case F_ACTIVATION_SIGMOID: return ACTIVATION_SIGMOID;
+      case F_ACTIVATION_RELU: return ACTIVATION_RELU;
+      default: return -1;
+   }
+}
+
+static unsigned int read_u32(const unsigned char *p)
+{
+   return p[0] | (unsigned int)p[1] << 8 | (unsigned int)p[2] << 16 | (unsigned int)p[3] << 24;
+}
+
+static void write_u32(unsigned char *p, unsigned int v)
+{
+   p[0] = v & 0xff;
+   p[1] = (v >> 8) & 0xff;
+   p[2] = (v >> 16) & 0xff;
+   p[3] = v >> 24;
+}
+
+static void dense_shape(LayerShape *s, const rnn_weight **arrays, const DenseLayer *d)
+{
+   s->inputs = d->nb_inputs;
+   s->neurons = d->nb_neurons;
+   s->activation = d->activation;
+   arrays[0] = d->input_weights;
+   arrays[1] = d->bias;
+}
+
+static void gru_shape(LayerShape *s, const rnn_weight **arrays, const GRULayer *g)
+{
+   s->inputs = g->nb_inputs;
+   s->neurons = g->nb_neurons;
+   s->activation = g->activation;
+   arrays[0] = g->input_weights;
+   arrays[1] = g->recurrent_weights;
+   arrays[2] = g->bias;
+}
+
+static void set_dense(DenseLayer *d, const LayerShape *s, const rnn_weight **arrays)
+{
+   d->input_weights = arrays[0];
+   d->bias = arrays[1];
+   d->nb_inputs = s->inputs;
+   d->nb_neurons = s->neurons;
+   d->activation = s->activation;
+}
+
+static void set_gru(GRULayer *g, const LayerShape *s, const rnn_weight **arrays)
+{
+   g->input_weights = arrays[0];
+   g->recurrent_weights = arrays[1];
+   g->bias = arrays[2];
+   g->nb_inputs = s->inputs;
+   g->nb_neurons = s->neurons;
+   g->activation = s->activation;
+}
+
+/* Points m's layers into its mapped data; 0 if that isn't a valid model. */
+static int parse(RNNMappedModel *m)
+{
+   LayerShape s[NB_LAYERS];
+   const rnn_weight *arrays[NB_LAYERS][3];
+   size_t pos;
+   int l, i;
+   if (m->size < HEADER_SIZE || memcmp(m->data, RNN_BINARY_MAGIC, 8) != 0
+         || read_u32(m->data + 8) != RNN_BINARY_VERSION)
+      return 0;
+   for (l=0;l<NB_LAYERS;l++) {
+      const unsigned char *p = m->data + 12 + 12*l;
+      if (read_u32(p) > MAX_NEURONS || read_u32(p + 4) > MAX_NEURONS)
+         return 0;
+      s[l].inputs = read_u32(p);
+      s[l].neurons = read_u32(p + 4);
+      s[l].activation = activation_from_file(read_u32(p + 8));
+      if (s[l].activation < 0)
+         return 0;
+   }
+   if (!check_shapes(s))
+      return 0;
+   pos = HEADER_SIZE;
+   for (l=0;l<NB_LAYERS;l++) {
+      size_t sizes[3];
+      int n = array_sizes(&s[l], l, sizes);
+      for (i=0;i<n;i++)
+         arrays[l][i] = (const rnn_weight *)(m->data + place(&pos, sizes[i]));
+   }
+   if (pos != m->size)
+      return 0;
+   set_dense(&m->dense[0], &s[0], arrays[0]);
+   set_gru(&m->gru[0], &s[1], arrays[1]);
+   set_gru(&m->gru[1], &s[2], arrays[2]);
+   set_gru(&m->gru[2], &s[3], arrays[3]);
+   set_dense(&m->dense[1], &s[4], arrays[4]);
+   set_dense(&m->dense[2], &s[5], arrays[5]);
+   m->model.input_dense_size = s[0].neurons;
+   m->model.input_dense = &m->dense[0];
+   m->model.vad_gru_size = s[1].neurons;
+   m->model.vad_gru = &m->gru[0];
+   m->model.noise_gru_size = s[2].neurons;
+   m->model.noise_gru = &m->gru[1];
+   m->model.denoise_gru_size = s[3].neurons;
+   m->model.denoise_gru = &m->gru[2];
+   m->model.denoise_output_size = s[4].neurons;
+   m->model.denoise_output = &m->dense[1];
+   m->model.vad_output_size = s[5].neurons;
+   m->model.vad_output = &m->dense[2];
+   m->model.mapped = m;
+   return 1;
+}
+
+/* The platform part: open a file, tell which one it is, and map it. */
+
+typedef struct {
+#ifdef _WIN32
+   HANDLE handle;
+#else
+   int fd;
+#endif
+   FileId id;
+} OpenFile;
+
+#ifdef _WIN32
+
+static int file_open(OpenFile *f, const char *path)
+{
+   BY_HANDLE_FILE_INFORMATION info;
+   f->handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+         FILE_ATTRIBUTE_NORMAL, NULL);
+   if (f->handle == INVALID_HANDLE_VALUE)
+      return 0;
+   if (!GetFileInformationByHandle(f->handle, &info)) {
+      CloseHandle(f->handle);
+      return 0;
+   }
+   f->id.volume = info.dwVolumeSerialNumber;
+   f->id.index = (unsigned long long)info.nFileIndexHigh << 32 | info.nFileIndexLow;
+   f->id.size = (unsigned long long)info.nFileSizeHigh << 32 | info.nFileSizeLow;
+   f->id.mtime = (unsigned long long)info.ftLastWriteTime.dwHighDateTime << 32
+         | info.ftLastWriteTime.dwLowDateTime;
+   return 1;
+}
+
+static const unsigned char *file_map(OpenFile *f)
+{
+   const unsigned char *data;
+   /* The view keeps the mapping object alive on its own. */
+   HANDLE mapping = CreateFileMappingA(f->handle, NULL, PAGE_READONLY, 0, 0, NULL);
+   if (!mapping)
+      return NULL;
+   data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+   CloseHandle(mapping);
+   return data;
+}
+
+static void file_close(OpenFile *f)
+{
+   CloseHandle(f->handle);
+}
+
+static void unmap(const unsigned char *data, size_t size)
+{
+   (void)size;
+   UnmapViewOfFile(data);
+}
+
+#else
+
+static int file_open(OpenFile *f, const char *path)
+{
+   struct stat st;
+   f->fd = open(path, O_RDONLY);
+   if (f->fd < 0)
+      return 0;
+   if (fstat(f->fd, &st) != 0) {
+      close(f->fd);
+      return 0;
+   }
+   f->id.volume = st.st_dev;
+   f->id.index = st.st_ino;
+   f->id.size = st.st_size;
+   f->id.mtime = st.st_mtime;
+   return 1;
+}
+
+static const unsigned char *file_map(OpenFile *f)
+{
+   void *data = mmap(NULL, f->id.size, PROT_READ, MAP_SHARED, f->fd, 0);
+   return data == MAP_FAILED ? NULL : data;
+}
+
+static void file_close(OpenFile *f)
+{
+   close(f->fd);
+}
+
+static void unmap(const unsigned char *data, size_t size)
+{
+   munmap((void *)data, size);
+}
+
+#endif
+
+static RNNMappedModel *load(OpenFile *f)
+{
+   RNNMappedModel *m;
+   if (f->id.size < HEADER_SIZE || f->id.size != (size_t)f->id.size)
+      return NULL;
+   m = calloc(1, sizeof(*m));
+   if (!m)
+      return NULL;
+   m->size = f->id.size;
+   m->data = file_map(f);
+   if (!m->data) {
+      free(m);
+      return NULL;
+   }
+   if (!parse(m)) {
+      unmap(m->data, m->size);
+      free(m);
+      return NULL;
+   }
+   m->id = f->id;
+   m->refs = 1;
+   return m;
+}
+
+RNNModel *rnnoise_model_load(const char *path)
+{
+   OpenFile f;
+   RNNMappedModel *m;
+   if (!file_open(&f, path))
+      return NULL;
+   /* Held while loading, so that racing loads of one file map it once. */
+   rnn_mutex_lock(&cache_lock);
+   for (m=cache;m;m=m->next) {
+      if (memcmp(&m->id, &f.id, sizeof(f.id)) == 0) {
+         m->refs++;
+         break;
+      }
+   }
+   if (!m) {
+      m = load(&f);
+      if (m) {
+         m->next = cache;
+         cache = m;
+      }
+   }
+   rnn_mutex_unlock(&cache_lock);
+   file_close(&f);
+   return m ? &m->model : NULL;
+}
+
+void rnn_mapped_model_release(RNNMappedModel *m)
+{
+   RNNMappedModel **p;
+   rnn_mutex_lock(&cache_lock);
+   if (--m->refs > 0) {
+      rnn_mutex_unlock(&cache_lock);
+      return;
+   }
+   for (p=&cache;*p!=m;p=&(*p)->next);
+   *p = m->next;
+   rnn_mutex_unlock(&cache_lock);
+   unmap(m->data, m->size);
+   rnn_int8_model_free(m->model.int8);
+   free(m);
+}
+
+int rnnoise_model_write(const RNNModel *model, FILE *f)
+{
+   static const unsigned char zeros[RNN_BINARY_ALIGN];
+   unsigned char header[HEADER_SIZE];
+   LayerShape s[NB_LAYERS];
+   const rnn_weight *arrays[NB_LAYERS][3];
+   size_t pos;
+   int l, i;
+   if (!model)
+      model = &rnnoise_model_orig;
+   dense_shape(&s[0], arrays[0], model->input_dense);
+   gru_shape(&s[1], arrays[1], model->vad_gru);
+   gru_shape(&s[2], arrays[2], model->noise_gru);
+   gru_shape(&s[3], arrays[3], model->denoise_gru);
+   dense_shape(&s[4], arrays[4], model->denoise_output);
+   dense_shape(&s[5], arrays[5], model->vad_output);
+   if (!check_shapes(s))
+      return -1;
+   memcpy(header, RNN_BINARY_MAGIC, 8);
+   write_u32(header + 8, RNN_BINARY_VERSION);
+   for (l=0;l<NB_LAYERS;l++) {
+      write_u32(header + 12 + 12*l, s[l].inputs);
+      write_u32(header + 16 + 12*l, s[l].neurons);
+      write_u32(header + 20 + 12*l, activation_to_file(s[l].activation));
+   }
+   if (fwrite(header, 1, HEADER_SIZE, f) != HEADER_SIZE)
+      return -1;
+   pos = HEADER_SIZE;
+   for (l=0;l<NB_LAYERS;l++) {
+      size_t sizes[3];
+      int n = array_sizes(&s[l], l, sizes);
+      for (i=0;i<n;i++) {
+         size_t end = pos;
+         size_t at = place(&pos, sizes[i]);
+         if (fwrite(zeros, 1, at - end, f) != at - end
+               || fwrite(arrays[l][i], 1, sizes[i], f) != sizes[i])
+            return -1;
+      }
+   }
+   return 0;
+}
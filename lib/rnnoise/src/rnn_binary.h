@@ -0,0 +1,37 @@
+/* Binary model files: see rnnoise_model_load() and rnnoise_model_write().
+
+   The format is built to be used in place from a read-only mapping. All
+   integers are 32-bit little-endian:
+
+     magic        "RNNOISEB" (8 bytes)
+     version      1
+     6 layers     nb_inputs, nb_neurons, activation (F_ACTIVATION_*), in
+                  the order input_dense, vad_gru, noise_gru, denoise_gru,
+                  denoise_output, vad_output
+     weights      for each layer in the same order: input weights, then
+                  recurrent weights (GRUs only), then bias, as the int8
+                  arrays DenseLayer and GRULayer point to, each starting at
+                  the next multiple of RNN_BINARY_ALIGN bytes (zero padding)
+
+   and nothing after the last array. */
+
+#ifndef RNN_BINARY_H
+#define RNN_BINARY_H
+
+#include "rnn.h"
+
+/* Although these values are the same as in rnn.h, we make them separate to
+ * avoid accidentally burning internal values into a file format */
+#define F_ACTIVATION_TANH       0
+#define F_ACTIVATION_SIGMOID    1
+#define F_ACTIVATION_RELU       2
+
+#define RNN_BINARY_MAGIC "RNNOISEB"
+#define RNN_BINARY_VERSION 1
+#define RNN_BINARY_ALIGN 64
+
+/* Drops one reference to a model from rnnoise_model_load(), unmapping it
+   with the last. */
+void rnn_mapped_model_release(RNNMappedModel *m);
+
+#endif
@@ -11047,5 +11047,9 @@ const struct RNNModel rnnoise_model_orig = {
     &denoise_output,
 
     1,
-    &vad_output
+    &vad_output,
+
+    NULL,  /* int8: packed on first use by rnn_int8_model_get() */
+
+    NULL   /* mapped: built in, not from rnnoise_model_load() */
 };
@@ -21,10 +21,21 @@ struct RNNModel {
 
   int vad_output_size;
   const DenseLayer *vad_output;
+
+  /* Packed weights for the int8 mode, made by rnn_int8_model_get() when a
+     state first enables it (NULL until then, and always for the built-in
+     model, whose copy is kept apart). */
+  RNNInt8Model *int8;
+
+  /* Set for models from rnnoise_model_load(), which rnnoise_model_free()
+     releases rather than frees. */
+  RNNMappedModel *mapped;
 };
 
 struct RNNState {
   const RNNModel *model;
+  int arch;
+  const RNNInt8Model *int8; /* NULL to run in float */
   float *vad_gru_state;
   float *noise_gru_state;
   float *denoise_gru_state;
@@ -0,0 +1,247 @@
+/* 8-bit inference for the RNN layers: see rnn_int8.h. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "arch.h"
+#include "rnn.h"
+#include "rnn_data.h"
+#include "rnn_int8.h"
+#include "rnn_mutex.h"
+#include "rnn_once.h"
+#include "cpu_support.h"
+#ifdef RNN_X86_MAY_HAVE_AVX2
+#include "x86/rnn_x86.h"
+#endif
+
+extern const struct RNNModel rnnoise_model_orig;
+
+#define ROUND_UP(x, n) (((x) + (n) - 1)/(n)*(n))
+
+/* The widest layer inputs (a GRU's input can be three layers' outputs, as
+   gru_input in rnn.c) and outputs (the three gates of a GRU), padded. */
+#define MAX_INPUTS  ROUND_UP(3*MAX_NEURONS, RNN_INT8_INPUTS)
+#define MAX_OUTPUTS ROUND_UP(3*MAX_NEURONS, RNN_INT8_NEURONS)
+
+static int packed_size(int N, int M)
+{
+   return ROUND_UP(N, RNN_INT8_NEURONS)*ROUND_UP(M, RNN_INT8_INPUTS);
+}
+
+static int dense_size(const DenseLayer *layer)
+{
+   return packed_size(layer->nb_neurons, layer->nb_inputs);
+}
+
+static int gru_size(const GRULayer *gru)
+{
+   int N = gru->nb_neurons;
+   return packed_size(3*N, gru->nb_inputs) + packed_size(2*N, N) + packed_size(N, N);
+}
+
+/* Packs neurons col0..col0+N-1 of the input-major weights[j*stride + i]
+   into dst; returns the end of what it wrote. */
+static signed char *pack(Int8Matrix *m, signed char *dst, const rnn_weight *weights,
+      int stride, int col0, int N, int M)
+{
+   int b, g, i, j;
+   m->w = dst;
+   m->N = N;
+   m->M = M;
+   for (b=0;b<N;b+=RNN_INT8_NEURONS)
+   {
+      for (g=0;g<M;g+=RNN_INT8_INPUTS)
+      {
+         for (i=b;i<b+RNN_INT8_NEURONS;i++)
+         {
+            for (j=g;j<g+RNN_INT8_INPUTS;j++)
+               *dst++ = i < N && j < M ? weights[j*stride + col0 + i] : 0;
+         }
+      }
+   }
+   return dst;
+}
+
+static int dense_fits(const DenseLayer *layer)
+{
+   return layer->nb_neurons <= MAX_NEURONS && layer->nb_inputs <= 3*MAX_NEURONS;
+}
+
+static int gru_fits(const GRULayer *gru)
+{
+   return gru->nb_neurons <= MAX_NEURONS && gru->nb_inputs <= 3*MAX_NEURONS;
+}
+
+static signed char *pack_dense(Int8Matrix *m, signed char *dst, const DenseLayer *layer)
+{
+   return pack(m, dst, layer->input_weights, layer->nb_neurons, 0,
+         layer->nb_neurons, layer->nb_inputs);
+}
+
+static signed char *pack_gru(Int8GRU *q, signed char *dst, const GRULayer *gru)
+{
+   int N = gru->nb_neurons;
+   dst = pack(&q->input, dst, gru->input_weights, 3*N, 0, 3*N, gru->nb_inputs);
+   dst = pack(&q->recurrent_zr, dst, gru->recurrent_weights, 3*N, 0, 2*N, N);
+   return pack(&q->recurrent_h, dst, gru->recurrent_weights, 3*N, 2*N, N, N);
+}
+
+RNNInt8Model *rnn_int8_model_create(const RNNModel *model)
+{
+   RNNInt8Model *q;
+   signed char *dst;
+   int size;
+   if (!dense_fits(model->input_dense) || !gru_fits(model->vad_gru)
+         || !gru_fits(model->noise_gru) || !gru_fits(model->denoise_gru)
+         || !dense_fits(model->denoise_output) || !dense_fits(model->vad_output))
+      return NULL;
+   q = calloc(1, sizeof(*q));
+   if (!q)
+      return NULL;
+   size = dense_size(model->input_dense) + gru_size(model->vad_gru)
+         + gru_size(model->noise_gru) + gru_size(model->denoise_gru)
+         + dense_size(model->denoise_output) + dense_size(model->vad_output);
+   q->mem = malloc(size);
+   if (!q->mem) {
+      free(q);
+      return NULL;
+   }
+   dst = pack_dense(&q->input_dense, q->mem, model->input_dense);
+   dst = pack_gru(&q->vad_gru, dst, model->vad_gru);
+   dst = pack_gru(&q->noise_gru, dst, model->noise_gru);
+   dst = pack_gru(&q->denoise_gru, dst, model->denoise_gru);
+   dst = pack_dense(&q->denoise_output, dst, model->denoise_output);
+   dst = pack_dense(&q->vad_output, dst, model->vad_output);
+   celt_assert(dst == q->mem + size);
+   return q;
+}
+
+void rnn_int8_model_free(RNNInt8Model *q)
+{
+   if (!q)
+      return;
+   free(q->mem);
+   free(q);
+}
+
+static RNNInt8Model *builtin;
+static rnn_once_flag builtin_once = RNN_ONCE_INIT;
+
+/* Guards the int8 field of loaded models, which only ever goes from NULL to
+   its final value; held only while a model is packed or looked up. */
+static rnn_mutex pack_lock = RNN_MUTEX_INIT;
+
+static void init_builtin(void)
+{
+   builtin = rnn_int8_model_create(&rnnoise_model_orig);
+}
+
+const RNNInt8Model *rnn_int8_model_get(const RNNModel *model)
+{
+   RNNModel *m;
+   const RNNInt8Model *q;
+   if (model == &rnnoise_model_orig) {
+      rnn_call_once(&builtin_once, init_builtin);
+      return builtin;
+   }
+   /* Loaded models are the library's own allocations; only the built-in
+      one is really const. */
+   m = (RNNModel *)model;
+   rnn_mutex_lock(&pack_lock);
+   if (!m->int8)
+      m->int8 = rnn_int8_model_create(m);
+   q = m->int8;
+   rnn_mutex_unlock(&pack_lock);
+   return q;
+}
+
+void rnn_int8_gemv_c(int *acc, const signed char *w, int N, int M, const signed char *q)
+{
+   int b, g, i, j;
+   for (b=0;b<N;b+=RNN_INT8_NEURONS)
+   {
+      for (g=0;g<M;g+=RNN_INT8_INPUTS)
+      {
+         for (i=b;i<b+RNN_INT8_NEURONS;i++)
+         {
+            int sum = 0;
+            for (j=g;j<g+RNN_INT8_INPUTS;j++)
+               sum += *w++ * q[j];
+            acc[i] += sum;
+         }
+      }
+   }
+}
+
+static void gemv(int *acc, const signed char *w, int N, int M, const signed char *q, int arch)
+{
+#ifdef RNN_X86_MAY_HAVE_AVX2
+   if (arch >= RNN_ARCH_AVX2) {
+      rnn_int8_gemv_avx2(acc, w, N, M, q);
+      return;
+   }
+   if (arch >= RNN_ARCH_SSE4_1) {
+      rnn_int8_gemv_sse4_1(acc, w, N, M, q);
+      return;
+   }
+#endif
+   (void)arch;
+   rnn_int8_gemv_c(acc, w, N, M, q);
+}
+
+/* q[j] = round(x[j]*x2[j]/scale) in [-127, 127], zero-padded to a whole
+   block, with scale = max|x*x2|/127 returned (0 if the input is all zero,
+   or not finite). */
+static float quantize(signed char *q, const float *x, const float *x2, int M)
+{
+   int j;
+   float v[MAX_INPUTS];
+   float amax = 0;
+   float inv;
+   for (j=0;j<M;j++)
+   {
+      float a;
+      v[j] = x2 ? x[j]*x2[j] : x[j];
+      a = (float)fabs(v[j]);
+      /* Reversed to catch NaNs */
+      if (!(a < 1e30f))
+         return 0;
+      amax = MAX16(amax, a);
+   }
+   if (amax == 0)
+      return 0;
+   inv = 127.f/amax;
+   /* Rounds half away from zero; floor() would be a library call here. */
+   for (j=0;j<M;j++)
+      q[j] = (int)(inv*v[j] + (v[j] < 0 ? -.5f : .5f));
+   for (;j<ROUND_UP(M, RNN_INT8_INPUTS);j++)
+      q[j] = 0;
+   return amax*(1.f/127);
+}
+
+void rnn_int8_gemm_accum(float *out, int out_stride, const Int8Matrix *w,
+      const float *x, const float *x2, int x_stride, int K, int arch)
+{
+   int i, k;
+   int N = ROUND_UP(w->N, RNN_INT8_NEURONS);
+   int M = ROUND_UP(w->M, RNN_INT8_INPUTS);
+   celt_assert(M <= MAX_INPUTS && N <= MAX_OUTPUTS);
+   for (k=0;k<K;k++)
+   {
+      signed char q[MAX_INPUTS];
+      int acc[MAX_OUTPUTS];
+      float *o = &out[k*out_stride];
+      float scale = quantize(q, &x[k*x_stride], x2 ? &x2[k*x_stride] : NULL, w->M);
+      if (scale == 0)
+         continue;
+      RNN_CLEAR(acc, N);
+      gemv(acc, w->w, N, M, q, arch);
+      for (i=0;i<w->N;i++)
+         o[i] += scale*acc[i];
+   }
+}
@@ -0,0 +1,64 @@
+/* 8-bit inference for the RNN layers; see rnnoise_set_quantized().
+
+   The weights are int8 already (they are scaled by WEIGHTS_SCALE when
+   used), so only the layer inputs are quantized: each stream's input vector
+   gets its own scale, max|x|/127, and the products are summed in 32-bit
+   integers, which is exact. The kernels therefore all give the same
+   result, and what differs from the float network is only the rounding of
+   the inputs.
+
+   The int8 instructions (pmaddubsw) sum adjacent products, so adjacent
+   bytes have to belong to the same neuron: the weights are repacked into
+   blocks of 8 neurons by 4 inputs, 32 bytes each, neuron-major within the
+   block; block (b, g) covers neurons 8b..8b+7 and inputs 4g..4g+3 and the
+   blocks are stored b-major, zero-padded where N or M run out. */
+
+#ifndef RNN_INT8_H
+#define RNN_INT8_H
+
+#include "rnn.h"
+
+#define RNN_INT8_NEURONS 8
+#define RNN_INT8_INPUTS  4
+
+typedef struct {
+   const signed char *w;
+   int N, M;                     /* Unpadded */
+} Int8Matrix;
+
+typedef struct {
+   Int8Matrix input;             /* All three gates */
+   Int8Matrix recurrent_zr;      /* Recurrent weights of the update and reset gates */
+   Int8Matrix recurrent_h;       /* Recurrent weights of the output */
+} Int8GRU;
+
+struct RNNInt8Model {
+   Int8Matrix input_dense;
+   Int8GRU vad_gru;
+   Int8GRU noise_gru;
+   Int8GRU denoise_gru;
+   Int8Matrix denoise_output;
+   Int8Matrix vad_output;
+   signed char *mem;
+};
+
+/* NULL if out of memory, or if a layer is wider than the network's buffers
+   (MAX_NEURONS neurons, 3*MAX_NEURONS inputs). */
+RNNInt8Model *rnn_int8_model_create(const RNNModel *model);
+void rnn_int8_model_free(RNNInt8Model *q);
+
+/* The packed weights of model, built on its first use and kept until the
+   model is freed; safe to call on a shared model from several threads.
+   NULL if out of memory or the model doesn't fit (see above). */
+const RNNInt8Model *rnn_int8_model_get(const RNNModel *model);
+
+/* rnn_gemm_accum_c() with packed weights: out[i] += sum over j of
+   w(i, j)*x[j] (times x2[j] if x2 is not NULL), for K streams. */
+void rnn_int8_gemm_accum(float *out, int out_stride, const Int8Matrix *w,
+      const float *x, const float *x2, int x_stride, int K, int arch);
+
+/* acc[i] += sum over j of w(i, j)*q[j] on the packed layout, for N and M
+   already rounded up to whole blocks. The portable kernel. */
+void rnn_int8_gemv_c(int *acc, const signed char *w, int N, int M, const signed char *q);
+
+#endif
@@ -0,0 +1,46 @@
+/* A statically initialized mutex: an SRW lock on Windows, a pthread mutex
+   elsewhere. */
+
+#ifndef RNN_MUTEX_H
+#define RNN_MUTEX_H
+
+#ifdef _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+typedef SRWLOCK rnn_mutex;
+#define RNN_MUTEX_INIT SRWLOCK_INIT
+
+static void rnn_mutex_lock(rnn_mutex *m)
+{
+   AcquireSRWLockExclusive(m);
+}
+
+static void rnn_mutex_unlock(rnn_mutex *m)
+{
+   ReleaseSRWLockExclusive(m);
+}
+
+#else
+
+#include <pthread.h>
+
+typedef pthread_mutex_t rnn_mutex;
+#define RNN_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+
+static void rnn_mutex_lock(rnn_mutex *m)
+{
+   pthread_mutex_lock(m);
+}
+
+static void rnn_mutex_unlock(rnn_mutex *m)
+{
+   pthread_mutex_unlock(m);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,45 @@
+/* One-time initialization that is safe to race on: InitOnceExecuteOnce() on
+   Windows, pthread_once() elsewhere. Only the first caller runs fn; every
+   other caller, on any thread, returns once it has finished. */
+
+#ifndef RNN_ONCE_H
+#define RNN_ONCE_H
+
+#ifdef _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+typedef INIT_ONCE rnn_once_flag;
+#define RNN_ONCE_INIT INIT_ONCE_STATIC_INIT
+
+static BOOL CALLBACK rnn_once_thunk(PINIT_ONCE once, PVOID fn, PVOID *context)
+{
+   (void)once;
+   (void)context;
+   ((void (*)(void))fn)();
+   return TRUE;
+}
+
+static void rnn_call_once(rnn_once_flag *flag, void (*fn)(void))
+{
+   InitOnceExecuteOnce(flag, rnn_once_thunk, (PVOID)fn, NULL);
+}
+
+#else
+
+#include <pthread.h>
+
+typedef pthread_once_t rnn_once_flag;
+#define RNN_ONCE_INIT PTHREAD_ONCE_INIT
+
+static void rnn_call_once(rnn_once_flag *flag, void (*fn)(void))
+{
+   pthread_once(flag, fn);
+}
+
+#endif
+
+#endif
@@ -34,14 +34,10 @@
 
 #include "rnn.h"
 #include "rnn_data.h"
+#include "rnn_int8.h"
+#include "rnn_binary.h"
 #include "rnnoise.h"
 
-/* Although these values are the same as in rnn.h, we make them separate to
- * avoid accidentally burning internal values into a file format */
-#define F_ACTIVATION_TANH       0
-#define F_ACTIVATION_SIGMOID    1
-#define F_ACTIVATION_RELU       2
-
 RNNModel *rnnoise_model_from_file(FILE *f)
 {
     int i, in;
@@ -158,11 +154,16 @@ void rnnoise_model_free(RNNModel *model)
 
     if (!model)
         return;
+    if (model->mapped) {
+        rnn_mapped_model_release(model->mapped);
+        return;
+    }
     FREE_DENSE(input_dense);
     FREE_GRU(vad_gru);
     FREE_GRU(noise_gru);
     FREE_GRU(denoise_gru);
     FREE_DENSE(denoise_output);
     FREE_DENSE(vad_output);
+    rnn_int8_model_free(model->int8);
     free(model);
 }
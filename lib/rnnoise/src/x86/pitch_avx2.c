@@ -0,0 +1,134 @@
+/* AVX2/FMA versions of the pitch kernels. rnn_pitch_xcorr_avx2() is
+   celt_pitch_xcorr_avx2() from celt/x86/pitch_avx.c in Opus: eight lags at
+   a time, each against the same load of x. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cpu_support.h"
+
+#if defined(RNN_X86_MAY_HAVE_AVX2) && !defined(FIXED_POINT)
+
+#include <immintrin.h>
+#include "common.h"
+#include "arch.h"
+#include "pitch_x86.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RNN_TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+#else
+#define RNN_TARGET_AVX2_FMA
+#endif
+
+static RNN_TARGET_AVX2_FMA OPUS_INLINE float hsum8(__m256 v)
+{
+   __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+   s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+   s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x55));
+   return _mm_cvtss_f32(s);
+}
+
+/* sum[k] = x[j]*y[j+k] summed over j < len, for k < 8. */
+static RNN_TARGET_AVX2_FMA void xcorr_kernel_avx2(const float *x, const float *y, float sum[8], int len)
+{
+   int i;
+   __m256 x0;
+   __m256 xsum0, xsum1, xsum2, xsum3, xsum4, xsum5, xsum6, xsum7;
+   xsum7 = xsum6 = xsum5 = xsum4 = xsum3 = xsum2 = xsum1 = xsum0 = _mm256_setzero_ps();
+   for (i=0;i<len-7;i+=8)
+   {
+      x0 = _mm256_loadu_ps(x+i);
+      xsum0 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(y+i  ), xsum0);
+      xsum1 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(y+i+1), xsum1);
+      xsum2 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(y+i+2), xsum2);
+      xsum3 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(y+i+3), xsum3);
+      xsum4 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(y+i+4), xsum4);
+      xsum5 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(y+i+5), xsum5);
+      xsum6 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(y+i+6), xsum6);
+      xsum7 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(y+i+7), xsum7);
+   }
+   if (i != len)
+   {
+      static const int mask[15] = {-1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
+      __m256i m = _mm256_loadu_si256((const __m256i *)(const void *)(mask + 7+i-len));
+      x0 = _mm256_maskload_ps(x+i, m);
+      xsum0 = _mm256_fmadd_ps(x0, _mm256_maskload_ps(y+i  , m), xsum0);
+      xsum1 = _mm256_fmadd_ps(x0, _mm256_maskload_ps(y+i+1, m), xsum1);
+      xsum2 = _mm256_fmadd_ps(x0, _mm256_maskload_ps(y+i+2, m), xsum2);
+      xsum3 = _mm256_fmadd_ps(x0, _mm256_maskload_ps(y+i+3, m), xsum3);
+      xsum4 = _mm256_fmadd_ps(x0, _mm256_maskload_ps(y+i+4, m), xsum4);
+      xsum5 = _mm256_fmadd_ps(x0, _mm256_maskload_ps(y+i+5, m), xsum5);
+      xsum6 = _mm256_fmadd_ps(x0, _mm256_maskload_ps(y+i+6, m), xsum6);
+      xsum7 = _mm256_fmadd_ps(x0, _mm256_maskload_ps(y+i+7, m), xsum7);
+   }
+   /* Transposing horizontal sums: [0 4] [1 5] [2 6] [3 7], then
+      [0 1 4 5] [2 3 6 7], then [0 1 2 3 4 5 6 7]. */
+   xsum0 = _mm256_add_ps(_mm256_permute2f128_ps(xsum0, xsum4, 2<<4), _mm256_permute2f128_ps(xsum0, xsum4, 1 | (3<<4)));
+   xsum1 = _mm256_add_ps(_mm256_permute2f128_ps(xsum1, xsum5, 2<<4), _mm256_permute2f128_ps(xsum1, xsum5, 1 | (3<<4)));
+   xsum2 = _mm256_add_ps(_mm256_permute2f128_ps(xsum2, xsum6, 2<<4), _mm256_permute2f128_ps(xsum2, xsum6, 1 | (3<<4)));
+   xsum3 = _mm256_add_ps(_mm256_permute2f128_ps(xsum3, xsum7, 2<<4), _mm256_permute2f128_ps(xsum3, xsum7, 1 | (3<<4)));
+   xsum0 = _mm256_hadd_ps(xsum0, xsum1);
+   xsum1 = _mm256_hadd_ps(xsum2, xsum3);
+   xsum0 = _mm256_hadd_ps(xsum0, xsum1);
+   _mm256_storeu_ps(sum, xsum0);
+}
+
+RNN_TARGET_AVX2_FMA float rnn_inner_prod_avx2(const float *x, const float *y, int N)
+{
+   int i;
+   float xy;
+   __m256 sum0 = _mm256_setzero_ps();
+   __m256 sum1 = _mm256_setzero_ps();
+   for (i=0;i<N-15;i+=16)
+   {
+      sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(x+i), _mm256_loadu_ps(y+i), sum0);
+      sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(x+i+8), _mm256_loadu_ps(y+i+8), sum1);
+   }
+   if (i < N-7)
+   {
+      sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(x+i), _mm256_loadu_ps(y+i), sum0);
+      i += 8;
+   }
+   xy = hsum8(_mm256_add_ps(sum0, sum1));
+   for (;i<N;i++)
+      xy = MAC16_16(xy, x[i], y[i]);
+   return xy;
+}
+
+RNN_TARGET_AVX2_FMA void rnn_dual_inner_prod_avx2(const float *x, const float *y01, const float *y02,
+      int N, float *xy1, float *xy2)
+{
+   int i;
+   float xy01, xy02;
+   __m256 xsum1 = _mm256_setzero_ps();
+   __m256 xsum2 = _mm256_setzero_ps();
+   for (i=0;i<N-7;i+=8)
+   {
+      __m256 xi = _mm256_loadu_ps(x+i);
+      xsum1 = _mm256_fmadd_ps(xi, _mm256_loadu_ps(y01+i), xsum1);
+      xsum2 = _mm256_fmadd_ps(xi, _mm256_loadu_ps(y02+i), xsum2);
+   }
+   xy01 = hsum8(xsum1);
+   xy02 = hsum8(xsum2);
+   for (;i<N;i++)
+   {
+      xy01 = MAC16_16(xy01, x[i], y01[i]);
+      xy02 = MAC16_16(xy02, x[i], y02[i]);
+   }
+   *xy1 = xy01;
+   *xy2 = xy02;
+}
+
+RNN_TARGET_AVX2_FMA void rnn_pitch_xcorr_avx2(const float *x, const float *y, float *xcorr,
+      int len, int max_pitch)
+{
+   int i;
+   celt_assert(max_pitch>0);
+   for (i=0;i<max_pitch-7;i+=8)
+      xcorr_kernel_avx2(x, y+i, &xcorr[i], len);
+   for (;i<max_pitch;i++)
+      xcorr[i] = rnn_inner_prod_avx2(x, y+i, len);
+}
+
+#endif
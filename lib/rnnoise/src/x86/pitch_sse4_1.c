@@ -0,0 +1,128 @@
+/* SSE versions of the pitch kernels, from celt/x86/pitch_sse.c in Opus.
+   They only need SSE, but are built and dispatched at the SSE4.1 level,
+   the lowest that rnn_select_arch() reports. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cpu_support.h"
+
+#if defined(RNN_X86_MAY_HAVE_AVX2) && !defined(FIXED_POINT)
+
+#include <smmintrin.h>
+#include "common.h"
+#include "arch.h"
+#include "pitch_x86.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RNN_TARGET_SSE4_1 __attribute__((target("sse4.1")))
+#else
+#define RNN_TARGET_SSE4_1
+#endif
+
+static RNN_TARGET_SSE4_1 OPUS_INLINE float hsum4(__m128 v)
+{
+   v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+   v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 0x55));
+   return _mm_cvtss_f32(v);
+}
+
+/* sum[k] += x[j]*y[j+k] for j < len and k < 4, like xcorr_kernel(); reads
+   y[0] to y[len+2]. */
+static RNN_TARGET_SSE4_1 void xcorr_kernel_sse4_1(const float *x, const float *y, float sum[4], int len)
+{
+   int j;
+   __m128 xsum1, xsum2;
+   xsum1 = _mm_loadu_ps(sum);
+   xsum2 = _mm_setzero_ps();
+   for (j=0;j<len-3;j+=4)
+   {
+      __m128 x0 = _mm_loadu_ps(x+j);
+      __m128 yj = _mm_loadu_ps(y+j);
+      __m128 y3 = _mm_loadu_ps(y+j+3);
+      xsum1 = _mm_add_ps(xsum1, _mm_mul_ps(_mm_shuffle_ps(x0, x0, 0x00), yj));
+      xsum2 = _mm_add_ps(xsum2, _mm_mul_ps(_mm_shuffle_ps(x0, x0, 0x55),
+            _mm_shuffle_ps(yj, y3, 0x49)));
+      xsum1 = _mm_add_ps(xsum1, _mm_mul_ps(_mm_shuffle_ps(x0, x0, 0xaa),
+            _mm_shuffle_ps(yj, y3, 0x9e)));
+      xsum2 = _mm_add_ps(xsum2, _mm_mul_ps(_mm_shuffle_ps(x0, x0, 0xff), y3));
+   }
+   if (j < len)
+   {
+      xsum1 = _mm_add_ps(xsum1, _mm_mul_ps(_mm_load1_ps(x+j), _mm_loadu_ps(y+j)));
+      if (++j < len)
+      {
+         xsum2 = _mm_add_ps(xsum2, _mm_mul_ps(_mm_load1_ps(x+j), _mm_loadu_ps(y+j)));
+         if (++j < len)
+            xsum1 = _mm_add_ps(xsum1, _mm_mul_ps(_mm_load1_ps(x+j), _mm_loadu_ps(y+j)));
+      }
+   }
+   _mm_storeu_ps(sum, _mm_add_ps(xsum1, xsum2));
+}
+
+RNN_TARGET_SSE4_1 float rnn_inner_prod_sse4_1(const float *x, const float *y, int N)
+{
+   int i;
+   float xy;
+   __m128 sum0 = _mm_setzero_ps();
+   __m128 sum1 = _mm_setzero_ps();
+   for (i=0;i<N-7;i+=8)
+   {
+      sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(x+i), _mm_loadu_ps(y+i)));
+      sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(x+i+4), _mm_loadu_ps(y+i+4)));
+   }
+   if (i < N-3)
+   {
+      sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(x+i), _mm_loadu_ps(y+i)));
+      i += 4;
+   }
+   xy = hsum4(_mm_add_ps(sum0, sum1));
+   for (;i<N;i++)
+      xy = MAC16_16(xy, x[i], y[i]);
+   return xy;
+}
+
+RNN_TARGET_SSE4_1 void rnn_dual_inner_prod_sse4_1(const float *x, const float *y01, const float *y02,
+      int N, float *xy1, float *xy2)
+{
+   int i;
+   float xy01, xy02;
+   __m128 xsum1 = _mm_setzero_ps();
+   __m128 xsum2 = _mm_setzero_ps();
+   for (i=0;i<N-3;i+=4)
+   {
+      __m128 xi = _mm_loadu_ps(x+i);
+      xsum1 = _mm_add_ps(xsum1, _mm_mul_ps(xi, _mm_loadu_ps(y01+i)));
+      xsum2 = _mm_add_ps(xsum2, _mm_mul_ps(xi, _mm_loadu_ps(y02+i)));
+   }
+   xy01 = hsum4(xsum1);
+   xy02 = hsum4(xsum2);
+   for (;i<N;i++)
+   {
+      xy01 = MAC16_16(xy01, x[i], y01[i]);
+      xy02 = MAC16_16(xy02, x[i], y02[i]);
+   }
+   *xy1 = xy01;
+   *xy2 = xy02;
+}
+
+RNN_TARGET_SSE4_1 void rnn_pitch_xcorr_sse4_1(const float *x, const float *y, float *xcorr,
+      int len, int max_pitch)
+{
+   int i;
+   celt_assert(max_pitch>0);
+   for (i=0;i<max_pitch-3;i+=4)
+   {
+      float sum[4]={0,0,0,0};
+      xcorr_kernel_sse4_1(x, y+i, sum, len);
+      xcorr[i]=sum[0];
+      xcorr[i+1]=sum[1];
+      xcorr[i+2]=sum[2];
+      xcorr[i+3]=sum[3];
+   }
+   for (;i<max_pitch;i++)
+      xcorr[i] = rnn_inner_prod_sse4_1(x, y+i, len);
+}
+
+#endif
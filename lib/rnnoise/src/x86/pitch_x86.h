@@ -0,0 +1,24 @@
+/* x86 versions of the pitch analysis kernels in pitch.c, after
+   celt/x86/pitch_sse.c and pitch_avx.c in Opus. Float builds only. */
+
+#ifndef PITCH_X86_H
+#define PITCH_X86_H
+
+float rnn_inner_prod_sse4_1(const float *x, const float *y, int N);
+
+void rnn_dual_inner_prod_sse4_1(const float *x, const float *y01, const float *y02,
+      int N, float *xy1, float *xy2);
+
+void rnn_pitch_xcorr_sse4_1(const float *x, const float *y, float *xcorr,
+      int len, int max_pitch);
+
+/* The AVX2 level also has FMA (see rnn_select_arch()). */
+float rnn_inner_prod_avx2(const float *x, const float *y, int N);
+
+void rnn_dual_inner_prod_avx2(const float *x, const float *y01, const float *y02,
+      int N, float *xy1, float *xy2);
+
+void rnn_pitch_xcorr_avx2(const float *x, const float *y, float *xcorr,
+      int len, int max_pitch);
+
+#endif
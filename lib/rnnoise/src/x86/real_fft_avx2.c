@@ -0,0 +1,38 @@
+/* AVX instance of the real FFT stage kernels (real_fft_tmpl.h), eight
+   floats at a time. Selected with the AVX2 arch, which implies AVX. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cpu_support.h"
+
+#ifdef RNN_X86_MAY_HAVE_AVX2
+
+#include <immintrin.h>
+#include "x86/real_fft_x86.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RFFT_TARGET __attribute__((target("avx")))
+#else
+#define RFFT_TARGET
+#endif
+
+#define RFFT_NAME(x) x##_avx
+#define RFFT_W 8
+#define rv __m256
+#define RV_LOAD(p) _mm256_loadu_ps(p)
+#define RV_STORE(p, v) _mm256_storeu_ps(p, v)
+#define RV_SET1(x) _mm256_set1_ps(x)
+#define RV_ADD(a, b) _mm256_add_ps(a, b)
+#define RV_SUB(a, b) _mm256_sub_ps(a, b)
+#define RV_MUL(a, b) _mm256_mul_ps(a, b)
+#include "real_fft_tmpl.h"
+
+RFFT_TARGET int rnn_rfft_stage_avx2(int p, float *yr, float *yi, const float *xr, const float *xi,
+      int s, int m, const float *twr, const float *twi)
+{
+   return stage_avx(p, yr, yi, xr, xi, s, m, twr, twi);
+}
+
+#endif
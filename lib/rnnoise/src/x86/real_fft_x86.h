@@ -0,0 +1,11 @@
+/* x86 stage kernels for real_fft.c. */
+
+#ifndef REAL_FFT_X86_H
+#define REAL_FFT_X86_H
+
+/* One Stockham stage on AVX2-capable CPUs; s must be a multiple of 8.
+   Returns 0 for a radix it has no kernel for. */
+int rnn_rfft_stage_avx2(int p, float *yr, float *yi, const float *xr, const float *xi,
+      int s, int m, const float *twr, const float *twi);
+
+#endif
@@ -0,0 +1,203 @@
+/* AVX2 matrix-vector product for the dense and GRU layers.
+
+   The weights are stored input-major (weights[j*stride + i] for input j and
+   neuron i), so for a fixed input the weights of consecutive neurons are
+   contiguous: eight int8 weights load with one 64-bit read and the matrix is
+   streamed front to back, one input row at a time, while eight neurons (or
+   32, using four accumulators) are computed side by side.
+
+   Each neuron's sum is accumulated in the same order and with the same
+   separate multiplies and adds as rnn_gemv_accum_c(), so the results are
+   bit-exact with the scalar code. FMA would be faster still but rounds
+   differently. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cpu_support.h"
+
+#ifdef RNN_X86_MAY_HAVE_AVX2
+
+#include <stddef.h>
+#include <immintrin.h>
+#include <string.h>
+#include "common.h"
+#include "rnn_int8.h"
+#include "rnn_x86.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RNN_TARGET_AVX2 __attribute__((target("avx2")))
+#define RNN_ALWAYS_INLINE __attribute__((always_inline)) inline
+#else
+#define RNN_TARGET_AVX2
+#define RNN_ALWAYS_INLINE __forceinline
+#endif
+
+static RNN_TARGET_AVX2 OPUS_INLINE __m256 load_weights8(const rnn_weight *w)
+{
+   __m128i bytes = _mm_loadl_epi64((const __m128i *)(const void *)w);
+   return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(bytes));
+}
+
+/* w*x[j], or (w*x[j])*x2[j], in the scalar code's order. */
+static RNN_TARGET_AVX2 OPUS_INLINE __m256 product8(const rnn_weight *w, __m256 xj,
+      const __m256 *x2j)
+{
+   __m256 p = _mm256_mul_ps(load_weights8(w), xj);
+   return x2j ? _mm256_mul_ps(p, *x2j) : p;
+}
+
+RNN_TARGET_AVX2 void rnn_gemv_accum_avx2(float *out, const rnn_weight *weights,
+      int stride, int N, int M, const float *x, const float *x2)
+{
+   int i, j;
+   for (i=0;i+32<=N;i+=32)
+   {
+      __m256 acc0 = _mm256_loadu_ps(&out[i]);
+      __m256 acc1 = _mm256_loadu_ps(&out[i + 8]);
+      __m256 acc2 = _mm256_loadu_ps(&out[i + 16]);
+      __m256 acc3 = _mm256_loadu_ps(&out[i + 24]);
+      for (j=0;j<M;j++)
+      {
+         const rnn_weight *w = &weights[j*stride + i];
+         __m256 xj = _mm256_set1_ps(x[j]);
+         __m256 x2j = _mm256_set1_ps(x2 ? x2[j] : 0);
+         const __m256 *x2p = x2 ? &x2j : NULL;
+         acc0 = _mm256_add_ps(acc0, product8(w, xj, x2p));
+         acc1 = _mm256_add_ps(acc1, product8(w + 8, xj, x2p));
+         acc2 = _mm256_add_ps(acc2, product8(w + 16, xj, x2p));
+         acc3 = _mm256_add_ps(acc3, product8(w + 24, xj, x2p));
+      }
+      _mm256_storeu_ps(&out[i], acc0);
+      _mm256_storeu_ps(&out[i + 8], acc1);
+      _mm256_storeu_ps(&out[i + 16], acc2);
+      _mm256_storeu_ps(&out[i + 24], acc3);
+   }
+   for (;i+8<=N;i+=8)
+   {
+      __m256 acc = _mm256_loadu_ps(&out[i]);
+      for (j=0;j<M;j++)
+      {
+         __m256 xj = _mm256_set1_ps(x[j]);
+         __m256 x2j = _mm256_set1_ps(x2 ? x2[j] : 0);
+         acc = _mm256_add_ps(acc, product8(&weights[j*stride + i], xj, x2 ? &x2j : NULL));
+      }
+      _mm256_storeu_ps(&out[i], acc);
+   }
+   if (i < N)
+      rnn_gemv_accum_c(&out[i], &weights[i], stride, N - i, M, x, x2);
+}
+
+/* w*x[idx], or (w*x[idx])*x2[idx], in the scalar code's order. */
+static RNN_TARGET_AVX2 RNN_ALWAYS_INLINE __m256 scaled(__m256 w, const float *x, const float *x2, int idx)
+{
+   __m256 p = _mm256_mul_ps(w, _mm256_set1_ps(x[idx]));
+   return x2 ? _mm256_mul_ps(p, _mm256_set1_ps(x2[idx])) : p;
+}
+
+/* Four streams against one pass over the weights: each weight load serves
+   all four, with the accumulators (16 neurons by four streams) in
+   registers. Always inlined, so that x2 is a compile-time constant. */
+static RNN_TARGET_AVX2 RNN_ALWAYS_INLINE void gemm4_accum(float *out, int os,
+      const rnn_weight *weights, int stride, int N, int M, const float *x,
+      const float *x2, int xs)
+{
+   int i, j;
+   for (i=0;i+16<=N;i+=16)
+   {
+      __m256 a00 = _mm256_loadu_ps(&out[i]),        a01 = _mm256_loadu_ps(&out[i + 8]);
+      __m256 a10 = _mm256_loadu_ps(&out[os + i]),   a11 = _mm256_loadu_ps(&out[os + i + 8]);
+      __m256 a20 = _mm256_loadu_ps(&out[2*os + i]), a21 = _mm256_loadu_ps(&out[2*os + i + 8]);
+      __m256 a30 = _mm256_loadu_ps(&out[3*os + i]), a31 = _mm256_loadu_ps(&out[3*os + i + 8]);
+      for (j=0;j<M;j++)
+      {
+         __m256 w0 = load_weights8(&weights[j*stride + i]);
+         __m256 w1 = load_weights8(&weights[j*stride + i + 8]);
+         a00 = _mm256_add_ps(a00, scaled(w0, x, x2, j));
+         a01 = _mm256_add_ps(a01, scaled(w1, x, x2, j));
+         a10 = _mm256_add_ps(a10, scaled(w0, x, x2, xs + j));
+         a11 = _mm256_add_ps(a11, scaled(w1, x, x2, xs + j));
+         a20 = _mm256_add_ps(a20, scaled(w0, x, x2, 2*xs + j));
+         a21 = _mm256_add_ps(a21, scaled(w1, x, x2, 2*xs + j));
+         a30 = _mm256_add_ps(a30, scaled(w0, x, x2, 3*xs + j));
+         a31 = _mm256_add_ps(a31, scaled(w1, x, x2, 3*xs + j));
+      }
+      _mm256_storeu_ps(&out[i], a00);        _mm256_storeu_ps(&out[i + 8], a01);
+      _mm256_storeu_ps(&out[os + i], a10);   _mm256_storeu_ps(&out[os + i + 8], a11);
+      _mm256_storeu_ps(&out[2*os + i], a20); _mm256_storeu_ps(&out[2*os + i + 8], a21);
+      _mm256_storeu_ps(&out[3*os + i], a30); _mm256_storeu_ps(&out[3*os + i + 8], a31);
+   }
+   for (;i+8<=N;i+=8)
+   {
+      __m256 a0 = _mm256_loadu_ps(&out[i]);
+      __m256 a1 = _mm256_loadu_ps(&out[os + i]);
+      __m256 a2 = _mm256_loadu_ps(&out[2*os + i]);
+      __m256 a3 = _mm256_loadu_ps(&out[3*os + i]);
+      for (j=0;j<M;j++)
+      {
+         __m256 w = load_weights8(&weights[j*stride + i]);
+         a0 = _mm256_add_ps(a0, scaled(w, x, x2, j));
+         a1 = _mm256_add_ps(a1, scaled(w, x, x2, xs + j));
+         a2 = _mm256_add_ps(a2, scaled(w, x, x2, 2*xs + j));
+         a3 = _mm256_add_ps(a3, scaled(w, x, x2, 3*xs + j));
+      }
+      _mm256_storeu_ps(&out[i], a0);
+      _mm256_storeu_ps(&out[os + i], a1);
+      _mm256_storeu_ps(&out[2*os + i], a2);
+      _mm256_storeu_ps(&out[3*os + i], a3);
+   }
+   if (i < N)
+      rnn_gemm_accum_c(&out[i], os, &weights[i], stride, N - i, M, x, x2, xs, 4);
+}
+
+/* Batched version: groups of four streams share each weight load, and any
+   left over go through the single-stream kernel. */
+RNN_TARGET_AVX2 void rnn_gemm_accum_avx2(float *out, int out_stride,
+      const rnn_weight *weights, int stride, int N, int M, const float *x,
+      const float *x2, int x_stride, int K)
+{
+   int k;
+   for (k=0;k+4<=K;k+=4)
+   {
+      if (x2)
+         gemm4_accum(&out[k*out_stride], out_stride, weights, stride, N, M,
+               &x[k*x_stride], &x2[k*x_stride], x_stride);
+      else
+         gemm4_accum(&out[k*out_stride], out_stride, weights, stride, N, M,
+               &x[k*x_stride], NULL, x_stride);
+   }
+   for (;k<K;k++)
+      rnn_gemv_accum_avx2(&out[k*out_stride], weights, stride, N, M, &x[k*x_stride],
+            x2 ? &x2[k*x_stride] : NULL);
+}
+
+/* int8: each 32-byte block is 8 neurons by 4 inputs, and the four inputs
+   are broadcast to all eight neurons. pmaddubsw wants one operand unsigned,
+   so it gets |w| and the inputs take the sign of w instead; with |q| <= 127
+   and |w| <= 128 a pair of products can't saturate its 16 bits. pmaddwd by
+   one then adds the pairs into one 32-bit sum per neuron. */
+RNN_TARGET_AVX2 void rnn_int8_gemv_avx2(int *acc, const signed char *w, int N, int M,
+      const signed char *q)
+{
+   int i, j;
+   const __m256i ones = _mm256_set1_epi16(1);
+   for (i=0;i<N;i+=RNN_INT8_NEURONS)
+   {
+      __m256i sum = _mm256_loadu_si256((const __m256i *)(const void *)&acc[i]);
+      for (j=0;j<M;j+=RNN_INT8_INPUTS)
+      {
+         int q4;
+         __m256i wv = _mm256_loadu_si256((const __m256i *)(const void *)w);
+         __m256i xv;
+         memcpy(&q4, &q[j], sizeof(q4));
+         xv = _mm256_set1_epi32(q4);
+         xv = _mm256_maddubs_epi16(_mm256_abs_epi8(wv), _mm256_sign_epi8(xv, wv));
+         sum = _mm256_add_epi32(sum, _mm256_madd_epi16(xv, ones));
+         w += RNN_INT8_NEURONS*RNN_INT8_INPUTS;
+      }
+      _mm256_storeu_si256((__m256i *)(void *)&acc[i], sum);
+   }
+}
+
+#endif
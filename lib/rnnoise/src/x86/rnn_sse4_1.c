@@ -0,0 +1,55 @@
+/* SSE4.1 int8 kernel for the RNN layers; see rnn_int8_gemv_avx2() for how
+   the products are formed. Each 32-byte block takes two 128-bit halves, the
+   first four neurons and the last four. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cpu_support.h"
+
+#ifdef RNN_X86_MAY_HAVE_AVX2
+
+#include <string.h>
+#include <smmintrin.h>
+#include "common.h"
+#include "rnn_int8.h"
+#include "rnn_x86.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RNN_TARGET_SSE4_1 __attribute__((target("sse4.1")))
+#else
+#define RNN_TARGET_SSE4_1
+#endif
+
+static RNN_TARGET_SSE4_1 OPUS_INLINE __m128i dot4(__m128i w, __m128i x, __m128i ones)
+{
+   __m128i p = _mm_maddubs_epi16(_mm_abs_epi8(w), _mm_sign_epi8(x, w));
+   return _mm_madd_epi16(p, ones);
+}
+
+RNN_TARGET_SSE4_1 void rnn_int8_gemv_sse4_1(int *acc, const signed char *w, int N, int M,
+      const signed char *q)
+{
+   int i, j;
+   const __m128i ones = _mm_set1_epi16(1);
+   for (i=0;i<N;i+=RNN_INT8_NEURONS)
+   {
+      __m128i sum0 = _mm_loadu_si128((const __m128i *)(const void *)&acc[i]);
+      __m128i sum1 = _mm_loadu_si128((const __m128i *)(const void *)&acc[i + 4]);
+      for (j=0;j<M;j+=RNN_INT8_INPUTS)
+      {
+         int q4;
+         __m128i xv;
+         memcpy(&q4, &q[j], sizeof(q4));
+         xv = _mm_set1_epi32(q4);
+         sum0 = _mm_add_epi32(sum0, dot4(_mm_loadu_si128((const __m128i *)(const void *)w), xv, ones));
+         sum1 = _mm_add_epi32(sum1, dot4(_mm_loadu_si128((const __m128i *)(const void *)(w + 16)), xv, ones));
+         w += RNN_INT8_NEURONS*RNN_INT8_INPUTS;
+      }
+      _mm_storeu_si128((__m128i *)(void *)&acc[i], sum0);
+      _mm_storeu_si128((__m128i *)(void *)&acc[i + 4], sum1);
+   }
+}
+
+#endif
@@ -0,0 +1,19 @@
+/* x86 versions of the RNN kernels in rnn.c. */
+
+#ifndef RNN_X86_H
+#define RNN_X86_H
+
+#include "rnn.h"
+
+void rnn_gemv_accum_avx2(float *out, const rnn_weight *weights, int stride,
+      int N, int M, const float *x, const float *x2);
+
+void rnn_gemm_accum_avx2(float *out, int out_stride, const rnn_weight *weights, int stride,
+      int N, int M, const float *x, const float *x2, int x_stride, int K);
+
+/* x86 versions of rnn_int8_gemv_c(). */
+void rnn_int8_gemv_sse4_1(int *acc, const signed char *w, int N, int M, const signed char *q);
+
+void rnn_int8_gemv_avx2(int *acc, const signed char *w, int N, int M, const signed char *q);
+
+#endif
@@ -0,0 +1,66 @@
+/* CPUID-based detection for the x86 kernels, after celt/x86/x86cpu.c in Opus. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cpu_support.h"
+
+#ifdef RNN_X86_MAY_HAVE_AVX2
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+static void cpuid(unsigned int info[4], unsigned int leaf, unsigned int subleaf)
+{
+   __cpuidex((int *)info, (int)leaf, (int)subleaf);
+}
+
+static unsigned long long xgetbv0(void)
+{
+   return _xgetbv(0);
+}
+
+#else
+#include <cpuid.h>
+
+static void cpuid(unsigned int info[4], unsigned int leaf, unsigned int subleaf)
+{
+   __cpuid_count(leaf, subleaf, info[0], info[1], info[2], info[3]);
+}
+
+static unsigned long long xgetbv0(void)
+{
+   unsigned int eax, edx;
+   __asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+   return ((unsigned long long)edx << 32) | eax;
+}
+#endif
+
+int rnn_select_arch(void)
+{
+   unsigned int info[4];
+   unsigned int max_leaf;
+   cpuid(info, 0, 0);
+   max_leaf = info[0];
+   if (max_leaf < 1)
+      return RNN_ARCH_C;
+   cpuid(info, 1, 0);
+   /* The int8 kernels need SSSE3 (bit 9) as well as SSE4.1 (bit 19). */
+   if (!(info[2] & (1u << 9)) || !(info[2] & (1u << 19)))
+      return RNN_ARCH_C;
+   /* AVX needs both the CPU (bit 28) and the OS saving the YMM registers
+      (OSXSAVE, bit 27, then XCR0 bits 1 and 2). The AVX2 level also takes FMA
+      (bit 12), which the pitch kernels use. */
+   if (max_leaf < 7 || !(info[2] & (1u << 27)) || !(info[2] & (1u << 28))
+         || !(info[2] & (1u << 12)))
+      return RNN_ARCH_SSE4_1;
+   if ((xgetbv0() & 6) != 6)
+      return RNN_ARCH_SSE4_1;
+   cpuid(info, 7, 0);
+   if (!(info[1] & (1u << 5)))
+      return RNN_ARCH_SSE4_1;
+   return RNN_ARCH_AVX2;
+}
+
+#endif